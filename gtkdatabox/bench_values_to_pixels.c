@@ -0,0 +1,213 @@
+/* GtkDatabox - An extension to the gtk+ library
+ * Copyright (C) 1998 - 2008  Dr. Roland Bock
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Microbenchmark of gtk_databox_values_to_xpixels/_ypixels: the former loop,
+ * which tested the value type and the scale for every value, against the
+ * loops of gtkdatabox_pixels.h, for some types, scales and array sizes.
+ * The linear scale must give the very same pixels, also when zoomed in far
+ * from 0: it fails otherwise.
+ *
+ *   make bench_values_to_pixels && ./bench_values_to_pixels [values per case]
+ */
+
+#include <stdlib.h>
+#include <glib/gprintf.h>
+#include <gtkdatabox_pixels.h>
+
+#define BENCH_TOTAL 20000000	/* values converted per case, whatever the array size */
+
+typedef struct
+{
+	const gchar *name;
+	GtkDataboxScaleType scale_type;
+	gint base;		/* values from base to base + spread - 1 */
+	gint spread;
+	gfloat tf;
+	gfloat minvis;
+} BenchCase;
+
+/* The loop before the per type and scale specialization, as it was */
+static void
+bench_old_values_to_pixels (gint *pixels, void *values, GType vtype,
+	guint maxlen, guint start, guint stride, guint len,
+	GtkDataboxScaleType scale_type, gfloat tf, gfloat minvis)
+{
+	guint i, indx;
+	gfloat fval = 0.0;
+
+	indx = start * stride;
+	i = 0;
+	do {
+		if (vtype == G_TYPE_FLOAT)
+			fval = ((gfloat *)values)[indx];
+		else if (vtype == G_TYPE_DOUBLE)
+			fval = ((gdouble *)values)[indx];
+		else if (vtype == G_TYPE_INT)
+			fval = ((gint *)values)[indx];
+		else if (vtype == G_TYPE_UINT)
+			fval = ((guint *)values)[indx];
+		else if (vtype == G_TYPE_LONG)
+			fval = ((glong *)values)[indx];
+		else if (vtype == G_TYPE_ULONG)
+			fval = ((gulong *)values)[indx];
+		else if (vtype == G_TYPE_INT64)
+			fval = ((gint64 *)values)[indx];
+		else if (vtype == G_TYPE_UINT64)
+			fval = ((guint64 *)values)[indx];
+		else if (vtype == G_TYPE_CHAR)
+			fval = ((gchar *)values)[indx];
+		else if (vtype == G_TYPE_UCHAR)
+			fval = ((guchar *)values)[indx];
+
+		if (scale_type == GTK_DATABOX_SCALE_LINEAR)
+			pixels[i] = tf * (fval - minvis);
+		else if (scale_type == GTK_DATABOX_SCALE_LOG2)
+			pixels[i] = tf * log2(fval / minvis);
+		else
+			pixels[i] = tf * log10(fval / minvis);
+
+		if (i + start > maxlen)
+			indx = ((i + start) % maxlen) * stride;
+		else
+			indx += stride;
+	} while (++i < len);
+}
+
+static void *
+bench_values_new (GType vtype, guint len, gint base, gint spread)
+{
+	guint i;
+	gfloat *f;
+	gdouble *d;
+	gint *n;
+
+	/* Positive, so that the log scales apply too */
+	if (vtype == G_TYPE_FLOAT)
+	{
+		f = g_new (gfloat, len);
+		for (i = 0; i < len; i++)
+			f[i] = base + (gint) ((i * 7919u) % spread);
+		return (f);
+	}
+	if (vtype == G_TYPE_DOUBLE)
+	{
+		d = g_new (gdouble, len);
+		for (i = 0; i < len; i++)
+			d[i] = base + (gint) ((i * 7919u) % spread);
+		return (d);
+	}
+	n = g_new (gint, len);
+	for (i = 0; i < len; i++)
+		n[i] = base + (gint) ((i * 7919u) % spread);
+	return (n);
+}
+
+/* Nanoseconds per value */
+static gdouble
+bench_run (gboolean old, gint *pixels, void *values, GType vtype, guint len,
+	const BenchCase *bc, guint reps)
+{
+	guint r;
+	gint64 t;
+
+	t = g_get_monotonic_time ();
+	for (r = 0; r < reps; r++)
+		if (old)
+			bench_old_values_to_pixels (pixels, values, vtype, len, 0, 1, len,
+						    bc->scale_type, bc->tf, bc->minvis);
+		else
+			gtk_databox_values_to_pixels (pixels, values, vtype, len, 0, 1, len,
+						      bc->scale_type, bc->tf, bc->minvis);
+	t = g_get_monotonic_time () - t;
+
+	return (1000.0 * t / ((gdouble) reps * len));
+}
+
+int
+main (int argc, char *argv[])
+{
+	static const guint sizes[] = { 100, 1000, 10000, 100000, 1000000 };
+	static const GType types[] = { G_TYPE_FLOAT, G_TYPE_DOUBLE, G_TYPE_INT };
+	static const gchar *type_names[] = { "float", "double", "int" };
+	static const BenchCase cases[] = {
+		{ "linear", GTK_DATABOX_SCALE_LINEAR, 1, 1000, 0.8, 0.5 },
+		{ "log10", GTK_DATABOX_SCALE_LOG, 1, 1000, 0.8, 0.5 },
+		/* Zoomed in around session 100000: tf * value is near 2e7, where floats are 2 apart */
+		{ "zoomed", GTK_DATABOX_SCALE_LINEAR, 99990, 20, 213.7, 99990.37 },
+	};
+	const BenchCase *bc;
+	gboolean failed = FALSE;
+	guint total = BENCH_TOTAL;
+	guint t, s, k, i, reps;
+	gint diff, max_diff;
+	gint *old_pixels;
+	gint *new_pixels;
+	void *values;
+	gdouble old_ns, new_ns;
+
+	if (argc > 1)
+		total = MAX (atoi (argv[1]), 1);
+
+	g_printf ("%-7s %-7s %8s %10s %10s %8s %5s\n",
+		  "type", "scale", "values", "old ns/v", "new ns/v", "speedup", "diff");
+	for (t = 0; t < G_N_ELEMENTS (types); t++)
+		for (s = 0; s < G_N_ELEMENTS (cases); s++)
+			for (k = 0; k < G_N_ELEMENTS (sizes); k++)
+			{
+				bc = &cases[s];
+				values = bench_values_new (types[t], sizes[k], bc->base, bc->spread);
+				old_pixels = g_new (gint, sizes[k]);
+				new_pixels = g_new (gint, sizes[k]);
+				reps = MAX (total / sizes[k], 1);
+
+				/* Warm up the caches, then take the best of three */
+				bench_run (TRUE, old_pixels, values, types[t], sizes[k], bc, 1);
+				bench_run (FALSE, new_pixels, values, types[t], sizes[k], bc, 1);
+				old_ns = new_ns = G_MAXDOUBLE;
+				for (i = 0; i < 3; i++)
+				{
+					old_ns = MIN (old_ns, bench_run (TRUE, old_pixels, values, types[t],
+									 sizes[k], bc, reps));
+					new_ns = MIN (new_ns, bench_run (FALSE, new_pixels, values, types[t],
+									 sizes[k], bc, reps));
+				}
+
+				/* The offset is taken out of the log, which might move a pixel */
+				max_diff = 0;
+				for (i = 0; i < sizes[k]; i++)
+				{
+					diff = ABS (old_pixels[i] - new_pixels[i]);
+					max_diff = MAX (max_diff, diff);
+				}
+
+				g_printf ("%-7s %-7s %8u %10.2f %10.2f %7.1fx %5d\n",
+					  type_names[t], bc->name, sizes[k],
+					  old_ns, new_ns, old_ns / new_ns, max_diff);
+				if (bc->scale_type == GTK_DATABOX_SCALE_LINEAR && max_diff != 0)
+					failed = TRUE;
+
+				g_free (new_pixels);
+				g_free (old_pixels);
+				g_free (values);
+			}
+
+	if (failed)
+		g_printf ("FAILED: the linear scale gives other pixels\n");
+	return (failed ? 1 : 0);
+}
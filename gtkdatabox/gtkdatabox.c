@@ -20,6 +20,7 @@
 #include <gtkdatabox.h>
 #include <gtkdatabox_marshal.h>
 #include <gtkdatabox_ruler.h>
+#include <gtkdatabox_pixels.h>
 #include <gtk/gtk.h>
 #include <math.h>
 
@@ -56,7 +57,13 @@ static void gtk_databox_create_backing_surface (GtkDatabox * box);
 static void gtk_databox_calculate_selection_values (GtkDatabox * box);
 static void gtk_databox_selection_cancel (GtkDatabox * box);
 static void gtk_databox_zoomed (GtkDatabox * box);
-static void gtk_databox_draw_selection (GtkDatabox * box, gboolean clear);
+static void gtk_databox_draw_selection (GtkDatabox * box, cairo_t * cr);
+static void gtk_databox_layers_free (GtkDatabox * box);
+static void gtk_databox_layers_invalidate (GtkDatabox * box);
+static void gtk_databox_graph_notify (GtkDataboxGraph * graph, GParamSpec * pspec,
+                                      GtkDatabox * box);
+static void gtk_databox_style_updated (GtkWidget * widget);
+static void gtk_databox_finalize (GObject * object);
 static void gtk_databox_adjustment_value_changed (GtkDatabox * box);
 static void gtk_databox_ruler_update (GtkDatabox * box);
 
@@ -88,6 +95,23 @@ enum {
     LAST_PROPERTY
 };
 
+/**
+ * GtkDataboxLayer
+ *
+ * A run of graphs, in drawing order, which are drawn together into their own surface
+ * and kept there until one of them or the visible limits change. Overlay graphs are
+ * drawn between the layers on every redraw.
+ *
+ **/
+typedef struct _GtkDataboxLayer GtkDataboxLayer;
+
+struct _GtkDataboxLayer {
+    cairo_surface_t *surface;
+    GList *first;	/* Graphs are drawn from the last one backwards */
+    guint n;
+    gboolean valid;
+};
+
 /**
  * GtkDataboxPrivate
  *
@@ -99,6 +123,9 @@ typedef struct _GtkDataboxPrivate GtkDataboxPrivate;
 
 struct _GtkDataboxPrivate {
     cairo_surface_t *backing_surface;
+    cairo_surface_t *target;	/* Where the graphs are being drawn */
+    GArray *layers;
+    gboolean layers_stale;
     gint old_width;
     gint old_height;
 
@@ -160,11 +187,13 @@ gtk_databox_class_init (GtkDataboxClass * class) {
 
     gobject_class->set_property = gtk_databox_set_property;
     gobject_class->get_property = gtk_databox_get_property;
+    gobject_class->finalize = gtk_databox_finalize;
 
     widget_class->realize = gtk_databox_realize;
     widget_class->unrealize = gtk_databox_unrealize;
     widget_class->size_allocate = gtk_databox_size_allocate;
     widget_class->draw = gtk_databox_draw;
+    widget_class->style_updated = gtk_databox_style_updated;
     widget_class->motion_notify_event = gtk_databox_motion_notify;
     widget_class->button_press_event = gtk_databox_button_press;
     widget_class->button_release_event = gtk_databox_button_release;
@@ -408,11 +437,25 @@ gtk_databox_class_init (GtkDataboxClass * class) {
     g_type_class_add_private (class, sizeof (GtkDataboxPrivate));
 }
 
+static void
+gtk_databox_finalize (GObject * object) {
+    GtkDatabox *box = GTK_DATABOX (object);
+    GtkDataboxPrivate *priv = GTK_DATABOX_GET_PRIVATE(box);
+
+    gtk_databox_layers_free (box);
+    g_array_free (priv->layers, TRUE);
+
+    G_OBJECT_CLASS (gtk_databox_parent_class)->finalize (object);
+}
+
 static void
 gtk_databox_init (GtkDatabox * box) {
     GtkDataboxPrivate *priv = GTK_DATABOX_GET_PRIVATE(box);
 
     priv->backing_surface = NULL;
+    priv->target = NULL;
+    priv->layers = g_array_new (FALSE, TRUE, sizeof (GtkDataboxLayer));
+    priv->layers_stale = TRUE;
     priv->scale_type_x = GTK_DATABOX_SCALE_LINEAR;
     priv->scale_type_y = GTK_DATABOX_SCALE_LINEAR;
     priv->translation_factor_x = 0;
@@ -494,10 +537,7 @@ gtk_databox_motion_notify (GtkWidget * widget, GdkEventMotion * event) {
         x = MAX (0, MIN (width - 1, x));
         y = MAX (0, MIN (height - 1, y));
 
-        if (priv->selection_active) {
-            /* Clear current selection from backing_surface */
-            gtk_databox_draw_selection (box, TRUE);
-        } else {
+        if (!priv->selection_active) {
             priv->selection_active = TRUE;
             priv->marked.x = x;
             priv->marked.y = y;
@@ -520,8 +560,9 @@ gtk_databox_motion_notify (GtkWidget * widget, GdkEventMotion * event) {
         priv->select.x = x;
         priv->select.y = y;
 
-        /* Draw new selection */
-        gtk_databox_draw_selection (box, FALSE);
+        /* Redraw both selections: it only costs compositing the cached layers */
+        gtk_widget_queue_draw_area (widget, rect.x - 1, rect.y - 1,
+                                    rect.width + 2, rect.height + 2);
 
         gtk_databox_calculate_selection_values (box);
         g_signal_emit (G_OBJECT (box),
@@ -660,17 +701,21 @@ static void
 gtk_databox_unrealize (GtkWidget * widget) {
     GtkDatabox *box = GTK_DATABOX (widget);
     GtkDataboxPrivate *priv = GTK_DATABOX_GET_PRIVATE(box);
+    GList *list;
     gtk_widget_set_realized(widget, FALSE);
 
     if (priv->backing_surface)
 		cairo_surface_destroy (priv->backing_surface);
     priv->backing_surface=NULL;
+    gtk_databox_layers_free (box);
     if (priv->adj_x)
         g_object_unref (priv->adj_x);
     priv->adj_x=NULL;
     if (priv->adj_y)
         g_object_unref (priv->adj_y);
 
+    for (list = priv->graphs; list; list = g_list_next (list))
+        g_signal_handlers_disconnect_by_func (list->data, gtk_databox_graph_notify, box);
     g_list_free (priv->graphs);
     priv->graphs=NULL;
 
@@ -914,6 +959,7 @@ gtk_databox_set_scale_type_x (GtkDatabox * box,
                               GtkDataboxScaleType scale_type) {
     GtkDataboxPrivate *priv = GTK_DATABOX_GET_PRIVATE(box);
     priv->scale_type_x = scale_type;
+    gtk_databox_layers_invalidate (box);
 
     if (priv->ruler_x)
         gtk_databox_ruler_set_scale_type (priv->ruler_x, scale_type);
@@ -934,6 +980,7 @@ gtk_databox_set_scale_type_y (GtkDatabox * box,
                               GtkDataboxScaleType scale_type) {
     GtkDataboxPrivate *priv = GTK_DATABOX_GET_PRIVATE(box);
     priv->scale_type_y = scale_type;
+    gtk_databox_layers_invalidate (box);
 
     if (priv->ruler_y)
         gtk_databox_ruler_set_scale_type (priv->ruler_y, scale_type);
@@ -1110,6 +1157,9 @@ gtk_databox_calculate_translation_factors (GtkDatabox * box) {
     GtkWidget *widget = GTK_WIDGET(box);
 	GtkAllocation allocation;
 
+    /* Every cached pixel moves */
+    gtk_databox_layers_invalidate (box);
+
 	gtk_widget_get_allocation(widget, &allocation);
     if (priv->scale_type_x == GTK_DATABOX_SCALE_LINEAR)
         priv->translation_factor_x =
@@ -1143,7 +1193,6 @@ gtk_databox_create_backing_surface(GtkDatabox * box) {
     GtkDataboxPrivate *priv = GTK_DATABOX_GET_PRIVATE(box);
     GtkAllocation allocation;
     GtkWidget *widget;
-	cairo_t *cr;
     gint width;
     gint height;
 
@@ -1161,13 +1210,92 @@ gtk_databox_create_backing_surface(GtkDatabox * box) {
    priv->old_width = width;
    priv->old_height = height;
 
-    cr = gdk_cairo_create (gtk_widget_get_window (widget));
-
-   priv->backing_surface = cairo_surface_create_similar(
-                                cairo_get_target (cr),
+   priv->backing_surface = gdk_window_create_similar_surface (
+                                gtk_widget_get_window (widget),
                                 CAIRO_CONTENT_COLOR,
                                 width, height);
 
+   /* The layers have the size of the backing surface */
+   gtk_databox_layers_free (box);
+}
+
+static void
+gtk_databox_layers_free (GtkDatabox * box) {
+    GtkDataboxPrivate *priv = GTK_DATABOX_GET_PRIVATE(box);
+    guint i;
+
+    for (i = 0; i < priv->layers->len; i++)
+        cairo_surface_destroy (g_array_index (priv->layers, GtkDataboxLayer, i).surface);
+    g_array_set_size (priv->layers, 0);
+    priv->layers_stale = TRUE;
+}
+
+/* Splits the graphs into the runs between the overlays */
+static void
+gtk_databox_layers_build (GtkDatabox * box) {
+    GtkDataboxPrivate *priv = GTK_DATABOX_GET_PRIVATE(box);
+    GtkDataboxLayer layer;
+    GList *list;
+
+    gtk_databox_layers_free (box);
+
+    layer.n = 0;
+    list = g_list_last (priv->graphs);
+    while (list) {
+        if (list->data && gtk_databox_graph_get_overlay (GTK_DATABOX_GRAPH (list->data))) {
+            if (layer.n > 0)
+                g_array_append_val (priv->layers, layer);
+            layer.n = 0;
+        } else if (layer.n++ == 0) {
+            layer.surface = cairo_surface_create_similar (priv->backing_surface,
+                                                          CAIRO_CONTENT_COLOR_ALPHA,
+                                                          priv->old_width, priv->old_height);
+            layer.first = list;
+            layer.valid = FALSE;
+        }
+        list = g_list_previous (list);
+    }
+    if (layer.n > 0)
+        g_array_append_val (priv->layers, layer);
+
+    priv->layers_stale = FALSE;
+}
+
+static void
+gtk_databox_layers_invalidate (GtkDatabox * box) {
+    GtkDataboxPrivate *priv = GTK_DATABOX_GET_PRIVATE(box);
+    guint i;
+
+    for (i = 0; i < priv->layers->len; i++)
+        g_array_index (priv->layers, GtkDataboxLayer, i).valid = FALSE;
+}
+
+static void
+gtk_databox_layer_draw (GtkDatabox * box, GtkDataboxLayer * layer) {
+    GtkDataboxPrivate *priv = GTK_DATABOX_GET_PRIVATE(box);
+    GList *list;
+    guint i;
+    cairo_t *cr;
+
+    cr = cairo_create (layer->surface);
+    cairo_set_operator (cr, CAIRO_OPERATOR_CLEAR);
+    cairo_paint (cr);
+    cairo_destroy (cr);
+
+    priv->target = layer->surface;
+    for (list = layer->first, i = 0; i < layer->n; list = g_list_previous (list), i++)
+        if (list->data)
+            gtk_databox_graph_draw (GTK_DATABOX_GRAPH (list->data), box);
+    priv->target = priv->backing_surface;
+
+    layer->valid = TRUE;
+}
+
+static void
+gtk_databox_style_updated (GtkWidget * widget) {
+    GTK_WIDGET_CLASS (gtk_databox_parent_class)->style_updated (widget);
+
+    gtk_databox_layers_invalidate (GTK_DATABOX (widget));
 }
 
 /**
@@ -1183,9 +1311,10 @@ gtk_databox_create_backing_surface(GtkDatabox * box) {
  */
 cairo_surface_t *
 gtk_databox_get_backing_surface(GtkDatabox * box) {
+    GtkDataboxPrivate *priv = GTK_DATABOX_GET_PRIVATE(box);
     g_return_val_if_fail (GTK_IS_DATABOX (box), NULL);
 
-    return GTK_DATABOX_GET_PRIVATE(box)->backing_surface;
+    return priv->target ? priv->target : priv->backing_surface;
 }
 
 static void
@@ -1217,29 +1346,43 @@ gtk_databox_draw (GtkWidget * widget, cairo_t * cr) {
     cairo_t *cr2;
     GtkStyleContext *stylecontext = gtk_widget_get_style_context(widget);
     GdkRGBA bg_color;
+    GtkDataboxLayer *layer;
+    guint i;
 
     gtk_databox_create_backing_surface (box);
+    if (priv->layers_stale)
+        gtk_databox_layers_build (box);
 
     cr2 = cairo_create(priv->backing_surface);
     gtk_style_context_get_background_color(stylecontext, GTK_STATE_FLAG_NORMAL, &bg_color);
     gdk_cairo_set_source_rgba (cr2, &bg_color);
     cairo_paint(cr2);
-    cairo_destroy(cr2);
 
+    /* Only the layers whose graphs changed are drawn again, the overlays always are */
+    priv->target = priv->backing_surface;
+    i = 0;
     list = g_list_last (priv->graphs);
     while (list) {
-        if (list->data)
+        if (list->data && gtk_databox_graph_get_overlay (GTK_DATABOX_GRAPH (list->data))) {
             gtk_databox_graph_draw (GTK_DATABOX_GRAPH (list->data), box);
-        list = g_list_previous (list);
+            list = g_list_previous (list);
+            continue;
+        }
+        layer = &g_array_index (priv->layers, GtkDataboxLayer, i++);
+        if (!layer->valid)
+            gtk_databox_layer_draw (box, layer);
+        cairo_set_source_surface (cr2, layer->surface, 0, 0);
+        cairo_paint (cr2);
+        list = g_list_nth_prev (list, layer->n);
     }
-
-    if (priv->selection_active)
-        gtk_databox_draw_selection (box, TRUE);
+    cairo_destroy(cr2);
+    priv->target = NULL;
 
     cairo_set_source_surface (cr, priv->backing_surface, 0, 0);
     cairo_paint(cr);
-	/* the following was removed - unsure if it creates problems */
-    /*gtk_databox_draw_selection (box, FALSE);*/
+
+    if (priv->selection_active)
+        gtk_databox_draw_selection (box, cr);
 
     return FALSE;
 }
@@ -1403,7 +1546,7 @@ gtk_databox_selection_cancel (GtkDatabox * box) {
     priv->selection_finalized = FALSE;
 
     /* Remove selection box */
-    gtk_databox_draw_selection (box, TRUE);
+    gtk_widget_queue_draw (GTK_WIDGET (box));
 
     /* Let everyone know that the selection has been canceled */
     g_signal_emit (G_OBJECT (box),
@@ -1576,30 +1719,20 @@ gtk_databox_zoom_home (GtkDatabox * box) {
 }
 
 static void
-gtk_databox_draw_selection (GtkDatabox * box, gboolean clear) {
+gtk_databox_draw_selection (GtkDatabox * box, cairo_t * cr) {
     GtkDataboxPrivate *priv = GTK_DATABOX_GET_PRIVATE(box);
-    GtkWidget *widget = GTK_WIDGET (box);
-	cairo_t *cr;
 
-	cr = gdk_cairo_create (gtk_widget_get_window (widget));
+    cairo_save (cr);
     cairo_rectangle (cr,
-                     MIN (priv->marked.x, priv->select.x) - 0.5,
-                     MIN (priv->marked.y, priv->select.y) - 0.5,
-                     ABS (priv->marked.x - priv->select.x) + 1.0,
-                     ABS (priv->marked.y - priv->select.y) + 1.0);
-
-   if (clear) {
-      cairo_set_source_surface (cr, priv->backing_surface, 0, 0);
-      cairo_paint(cr);
-      cairo_set_line_width (cr, 2.0);
-    } else {
-      cairo_set_source_rgb (cr, 1.0, 1.0, 1.0);
-      cairo_set_operator (cr, CAIRO_OPERATOR_DIFFERENCE);
-      cairo_set_line_width (cr, 1.0);
-	}
-	cairo_stroke(cr);
-
-	cairo_destroy(cr);
+                     MIN (priv->marked.x, priv->select.x) + 0.5,
+                     MIN (priv->marked.y, priv->select.y) + 0.5,
+                     ABS (priv->marked.x - priv->select.x),
+                     ABS (priv->marked.y - priv->select.y));
+    cairo_set_source_rgb (cr, 1.0, 1.0, 1.0);
+    cairo_set_operator (cr, CAIRO_OPERATOR_DIFFERENCE);
+    cairo_set_line_width (cr, 1.0);
+    cairo_stroke (cr);
+    cairo_restore (cr);
 }
 
 static void
@@ -2043,7 +2176,11 @@ gtk_databox_graph_add (GtkDatabox * box, GtkDataboxGraph * graph) {
     g_return_val_if_fail (GTK_IS_DATABOX (box), -1);
     g_return_val_if_fail (GTK_DATABOX_IS_GRAPH (graph), -1);
 
-        priv->graphs = g_list_append (priv->graphs, graph);
+    if (!g_list_find (priv->graphs, graph))
+        g_signal_connect (graph, "notify", G_CALLBACK (gtk_databox_graph_notify), box);
+    priv->graphs = g_list_append (priv->graphs, graph);
+    /* The layers point into the list */
+    gtk_databox_layers_free (box);
 
     return (priv->graphs == NULL) ? -1 : 0;
 }
@@ -2066,7 +2203,11 @@ gtk_databox_graph_add_front (GtkDatabox * box, GtkDataboxGraph * graph) {
     g_return_val_if_fail (GTK_IS_DATABOX (box), -1);
     g_return_val_if_fail (GTK_DATABOX_IS_GRAPH (graph), -1);
 
-            priv->graphs = g_list_prepend (priv->graphs, graph);
+    if (!g_list_find (priv->graphs, graph))
+        g_signal_connect (graph, "notify", G_CALLBACK (gtk_databox_graph_notify), box);
+    priv->graphs = g_list_prepend (priv->graphs, graph);
+    /* The layers point into the list */
+    gtk_databox_layers_free (box);
 
     return (priv->graphs == NULL) ? -1 : 0;
 }
@@ -2093,6 +2234,10 @@ gtk_databox_graph_remove (GtkDatabox * box, GtkDataboxGraph * graph) {
     g_return_val_if_fail (list, -1);
 
     priv->graphs = g_list_delete_link (priv->graphs, list);
+    if (!g_list_find (priv->graphs, graph))
+        g_signal_handlers_disconnect_by_func (graph, gtk_databox_graph_notify, box);
+    /* The layers point into the list */
+    gtk_databox_layers_free (box);
     return 0;
 }
 
@@ -2107,14 +2252,60 @@ gtk_databox_graph_remove (GtkDatabox * box, GtkDataboxGraph * graph) {
 gint
 gtk_databox_graph_remove_all (GtkDatabox * box) {
     GtkDataboxPrivate *priv = GTK_DATABOX_GET_PRIVATE(box);
+    GList *list;
     g_return_val_if_fail (GTK_IS_DATABOX (box), -1);
 
+    for (list = priv->graphs; list; list = g_list_next (list))
+        g_signal_handlers_disconnect_by_func (list->data, gtk_databox_graph_notify, box);
     g_list_free (priv->graphs);
     priv->graphs = NULL;
+    /* The layers point into the list */
+    gtk_databox_layers_free (box);
 
     return 0;
 }
 
+/**
+ * gtk_databox_graph_changed:
+ * @box: A #GtkDatabox widget
+ * @graph: A graph, e.g. a #GtkDataboxPoints or a #GtkDataboxGrid object
+ *
+ * Tells the @box that the values of the @graph were changed in place, so that the cached
+ * drawing of it is thrown away. Setting any property of the @graph does the same.
+ *
+ */
+void
+gtk_databox_graph_changed (GtkDatabox * box, GtkDataboxGraph * graph) {
+    GtkDataboxPrivate *priv = GTK_DATABOX_GET_PRIVATE(box);
+    GtkDataboxLayer *layer;
+    GList *list;
+    guint i, j;
+
+    g_return_if_fail (GTK_IS_DATABOX (box));
+    g_return_if_fail (GTK_DATABOX_IS_GRAPH (graph));
+
+    gtk_widget_queue_draw (GTK_WIDGET (box));
+    /* The layers are built again anyway */
+    if (priv->layers_stale)
+        return;
+
+    for (i = 0; i < priv->layers->len; i++) {
+        layer = &g_array_index (priv->layers, GtkDataboxLayer, i);
+        for (list = layer->first, j = 0; j < layer->n; list = g_list_previous (list), j++)
+            if (list->data == graph)
+                layer->valid = FALSE;
+    }
+}
+
+static void
+gtk_databox_graph_notify (GtkDataboxGraph * graph, GParamSpec * pspec, GtkDatabox * box) {
+    if (g_str_equal (g_param_spec_get_name (pspec), "overlay")) {
+        GTK_DATABOX_GET_PRIVATE(box)->layers_stale = TRUE;
+        gtk_widget_queue_draw (GTK_WIDGET (box));
+    } else
+        gtk_databox_graph_changed (box, graph);
+}
+
 /**
  * gtk_databox_value_to_pixel_x:
  * @box: A #GtkDatabox widget
@@ -2125,7 +2316,7 @@ gtk_databox_graph_remove_all (GtkDatabox * box) {
  *
  * Return value: Pixel coordinate
  */
-gint16
+gint
 gtk_databox_value_to_pixel_x (GtkDatabox * box, gfloat value) {
     GtkDataboxPrivate *priv = GTK_DATABOX_GET_PRIVATE(box);
 
@@ -2151,7 +2342,7 @@ gtk_databox_value_to_pixel_x (GtkDatabox * box, gfloat value) {
  *
  * Return value: Pixel coordinate
  */
-gint16
+gint
 gtk_databox_value_to_pixel_y (GtkDatabox * box, gfloat value) {
     GtkDataboxPrivate *priv = GTK_DATABOX_GET_PRIVATE(box);
 
@@ -2177,59 +2368,13 @@ gtk_databox_value_to_pixel_y (GtkDatabox * box, gfloat value) {
  * Return value: Pixel coordinates
  */
 void
-gtk_databox_values_to_xpixels (GtkDatabox *box, gint16 *pixels,
+gtk_databox_values_to_xpixels (GtkDatabox *box, gint *pixels,
 	void *values, GType vtype, guint maxlen, guint start, guint stride, guint len)
 {
 	GtkDataboxPrivate *priv = GTK_DATABOX_GET_PRIVATE(box);
-    guint i, indx;
-	gfloat fval = 0.0;
-	GtkDataboxScaleType scale_type;
-	gfloat tf, minvis;
-
-	scale_type = priv->scale_type_x;
-	tf = priv->translation_factor_x;
-	minvis = priv->visible_left;
-
-	indx = start * stride;
-	i = 0;
-	do {
-		/* This may be excessive, but it handles every conceivable type */
-		if (vtype == G_TYPE_FLOAT)
-			fval = ((gfloat *)values)[indx];
-		else if (vtype == G_TYPE_DOUBLE)
-			fval = ((gdouble *)values)[indx];
-		else if (vtype == G_TYPE_INT)
-			fval = ((gint *)values)[indx];
-		else if (vtype == G_TYPE_UINT)
-			fval = ((guint *)values)[indx];
-		else if (vtype == G_TYPE_LONG)
-			fval = ((glong *)values)[indx];
-		else if (vtype == G_TYPE_ULONG)
-			fval = ((gulong *)values)[indx];
-		else if (vtype == G_TYPE_INT64)
-			fval = ((gint64 *)values)[indx];
-		else if (vtype == G_TYPE_UINT64)
-			fval = ((guint64 *)values)[indx];
-		else if (vtype == G_TYPE_CHAR)
-			fval = ((gchar *)values)[indx];
-		else if (vtype == G_TYPE_UCHAR)
-			fval = ((guchar *)values)[indx];
-
-		if (scale_type == GTK_DATABOX_SCALE_LINEAR)
-			pixels[i] = tf * (fval - minvis);
-		else if (scale_type == GTK_DATABOX_SCALE_LOG2)
-			pixels[i] = tf * log2(fval / minvis);
-		else
-			pixels[i] = tf * log10(fval / minvis);
-
-		/* handle the wrap-around (ring buffer) issue using modulus.  for efficiency, don't do this for non-wraparound cases. */
-		/* note this allows multiple wrap-arounds.  One could hold a single cycle of a sine wave, and plot a continuous wave */
-		/* This can be optimized using pointers later */
-		if (i + start > maxlen)
-			indx = ((i + start) % maxlen) * stride;
-		else
-			indx += stride;
-	} while (++i < len);
+
+	gtk_databox_values_to_pixels (pixels, values, vtype, maxlen, start, stride, len,
+		priv->scale_type_x, priv->translation_factor_x, priv->visible_left);
 }
 
 /**
@@ -2243,59 +2388,13 @@ gtk_databox_values_to_xpixels (GtkDatabox *box, gint16 *pixels,
  * Return value: Pixel coordinates
  */
 void
-gtk_databox_values_to_ypixels (GtkDatabox *box, gint16 *pixels,
+gtk_databox_values_to_ypixels (GtkDatabox *box, gint *pixels,
 	void *values, GType vtype, guint maxlen, guint start, guint stride, guint len)
 {
-    GtkDataboxPrivate *priv = GTK_DATABOX_GET_PRIVATE(box);
-    guint i, indx;
-	gfloat fval = 0.0;
-	GtkDataboxScaleType scale_type;
-	gfloat tf, minvis;
-
-	scale_type = priv->scale_type_y;
-	tf = priv->translation_factor_y;
-	minvis = priv->visible_top;
-
-	indx = start * stride;
-	i = 0;
-	do {
-		/* This may be excessive, but it handles every conceivable type */
-		if (vtype == G_TYPE_FLOAT)
-			fval = ((gfloat *)values)[indx];
-		else if (vtype == G_TYPE_DOUBLE)
-			fval = ((gdouble *)values)[indx];
-		else if (vtype == G_TYPE_INT)
-			fval = ((gint *)values)[indx];
-		else if (vtype == G_TYPE_UINT)
-			fval = ((guint *)values)[indx];
-		else if (vtype == G_TYPE_LONG)
-			fval = ((glong *)values)[indx];
-		else if (vtype == G_TYPE_ULONG)
-			fval = ((gulong *)values)[indx];
-		else if (vtype == G_TYPE_INT64)
-			fval = ((gint64 *)values)[indx];
-		else if (vtype == G_TYPE_UINT64)
-			fval = ((guint64 *)values)[indx];
-		else if (vtype == G_TYPE_CHAR)
-			fval = ((gchar *)values)[indx];
-		else if (vtype == G_TYPE_UCHAR)
-			fval = ((guchar *)values)[indx];
-
-		if (scale_type == GTK_DATABOX_SCALE_LINEAR)
-			pixels[i] = tf * (fval - minvis);
-		else if (scale_type == GTK_DATABOX_SCALE_LOG2)
-			pixels[i] = tf * log2(fval / minvis);
-		else
-			pixels[i] = tf * log10(fval / minvis);
-
-		/* handle the wrap-around (ring buffer) issue using modulus.  for efficiency, don't do this for non-wraparound cases. */
-		/* note this allows multiple wrap-arounds.  One could hold a single cycle of a sine wave, and plot a continuous wave */
-		/* This can be optimized using pointers later */
-		if (i + start > maxlen)
-			indx = ((i + start) % maxlen) * stride;
-		else
-			indx += stride;
-	} while (++i < len);
+	GtkDataboxPrivate *priv = GTK_DATABOX_GET_PRIVATE(box);
+
+	gtk_databox_values_to_pixels (pixels, values, vtype, maxlen, start, stride, len,
+		priv->scale_type_y, priv->translation_factor_y, priv->visible_top);
 }
 
 /**
@@ -2309,7 +2408,7 @@ gtk_databox_values_to_ypixels (GtkDatabox *box, gint16 *pixels,
  * Return value: x value
  */
 gfloat
-gtk_databox_pixel_to_value_x (GtkDatabox * box, gint16 pixel) {
+gtk_databox_pixel_to_value_x (GtkDatabox * box, gint pixel) {
     GtkDataboxPrivate *priv = GTK_DATABOX_GET_PRIVATE(box);
 
     if (priv->scale_type_x == GTK_DATABOX_SCALE_LINEAR)
@@ -2338,7 +2437,7 @@ gtk_databox_pixel_to_value_x (GtkDatabox * box, gint16 pixel) {
  * Return value: y value
  */
 gfloat
-gtk_databox_pixel_to_value_y (GtkDatabox * box, gint16 pixel) {
+gtk_databox_pixel_to_value_y (GtkDatabox * box, gint pixel) {
     GtkDataboxPrivate *priv = GTK_DATABOX_GET_PRIVATE(box);
 
     if (priv->scale_type_y == GTK_DATABOX_SCALE_LINEAR)
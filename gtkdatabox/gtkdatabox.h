@@ -117,6 +117,7 @@ gint gtk_databox_graph_add_front (GtkDatabox * box, GtkDataboxGraph * graph);
 
 gint gtk_databox_graph_remove (GtkDatabox * box, GtkDataboxGraph * graph);
 gint gtk_databox_graph_remove_all (GtkDatabox * box);
+void gtk_databox_graph_changed (GtkDatabox * box, GtkDataboxGraph * graph);
 
 gint gtk_databox_auto_rescale (GtkDatabox * box, gfloat border);
 gint gtk_databox_calculate_extrema (GtkDatabox * box,
@@ -165,13 +166,13 @@ void gtk_databox_zoom_to_selection (GtkDatabox * box);
 void gtk_databox_zoom_out (GtkDatabox * box);
 void gtk_databox_zoom_home (GtkDatabox * box);
 
-gint16 gtk_databox_value_to_pixel_x (GtkDatabox * box, gfloat value);
-gint16 gtk_databox_value_to_pixel_y (GtkDatabox * box, gfloat value);
-gfloat gtk_databox_pixel_to_value_x (GtkDatabox * box, gint16 pixel);
-gfloat gtk_databox_pixel_to_value_y (GtkDatabox * box, gint16 pixel);
-void gtk_databox_values_to_xpixels (GtkDatabox *box, gint16 *pixels,
+gint gtk_databox_value_to_pixel_x (GtkDatabox * box, gfloat value);
+gint gtk_databox_value_to_pixel_y (GtkDatabox * box, gfloat value);
+gfloat gtk_databox_pixel_to_value_x (GtkDatabox * box, gint pixel);
+gfloat gtk_databox_pixel_to_value_y (GtkDatabox * box, gint pixel);
+void gtk_databox_values_to_xpixels (GtkDatabox *box, gint *pixels,
 	void *values, GType vtype, guint size, guint start, guint stride, guint len);
-void gtk_databox_values_to_ypixels (GtkDatabox *box, gint16 *pixels,
+void gtk_databox_values_to_ypixels (GtkDatabox *box, gint *pixels,
 	void *values, GType vtype, guint size, guint start, guint stride, guint len);
 
 void gtk_databox_create_box_with_scrollbars_and_rulers (GtkWidget **
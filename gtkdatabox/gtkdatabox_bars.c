@@ -35,8 +35,8 @@ typedef struct _GtkDataboxBarsPrivate GtkDataboxBarsPrivate;
 
 struct _GtkDataboxBarsPrivate
 {
-   gint16 *xpixels;
-   gint16 *ypixels;
+   gint *xpixels;
+   gint *ypixels;
    guint pixelsalloc;
 };
 
@@ -173,10 +173,10 @@ gtk_databox_bars_real_draw (GtkDataboxGraph * graph,
    void *X;
    void *Y;
    guint len, maxlen;
-   gint16 zero = 0;
+   gint zero = 0;
    gfloat fzero = 0.0;
    cairo_t *cr;
-   gint16 *xpixels, *ypixels;
+   gint *xpixels, *ypixels;
    guint xstart, xstride, ystart, ystride;
    GType xtype, ytype;
 
@@ -195,8 +195,8 @@ gtk_databox_bars_real_draw (GtkDataboxGraph * graph,
    if (priv->pixelsalloc < len)
    {
    	priv->pixelsalloc = len;
-	priv->xpixels = (gint16 *)g_realloc(priv->xpixels, len * sizeof(gint16));
-	priv->ypixels = (gint16 *)g_realloc(priv->ypixels, len * sizeof(gint16));
+	priv->xpixels = (gint *)g_realloc(priv->xpixels, len * sizeof(gint));
+	priv->ypixels = (gint *)g_realloc(priv->ypixels, len * sizeof(gint));
    }
 
    xpixels = priv->xpixels;
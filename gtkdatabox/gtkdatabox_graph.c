@@ -36,7 +36,8 @@ enum
 {
   GRAPH_COLOR = 1,
   GRAPH_SIZE,
-  GRAPH_HIDE
+  GRAPH_HIDE,
+  GRAPH_OVERLAY
 };
 
 /**
@@ -53,6 +54,7 @@ struct _GtkDataboxGraphPrivate
   GdkRGBA color;
   gint size;
   gboolean hide;
+  gboolean overlay;
   GdkRGBA rgba;
 };
 
@@ -82,6 +84,11 @@ gtk_databox_graph_set_property (GObject * object,
       gtk_databox_graph_set_hide (graph, g_value_get_boolean (value));
     }
     break;
+    case GRAPH_OVERLAY:
+    {
+      gtk_databox_graph_set_overlay (graph, g_value_get_boolean (value));
+    }
+    break;
     default:
       /* We don't have any other property... */
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -113,6 +120,11 @@ gtk_databox_graph_get_property (GObject * object,
       g_value_set_boolean (value, gtk_databox_graph_get_hide (graph));
     }
     break;
+    case GRAPH_OVERLAY:
+    {
+      g_value_set_boolean (value, gtk_databox_graph_get_overlay (graph));
+    }
+    break;
     default:
       /* We don't have any other property... */
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -183,6 +195,12 @@ gtk_databox_graph_class_init (GtkDataboxGraphClass *klass)
   g_object_class_install_property (gobject_class,
                                    GRAPH_HIDE, graph_param_spec);
 
+  graph_param_spec = g_param_spec_boolean ("overlay", "Graph overlay", "Determine if graph is redrawn every time instead of being cached", FALSE,	/* default value */
+                     G_PARAM_READWRITE);
+
+  g_object_class_install_property (gobject_class,
+                                   GRAPH_OVERLAY, graph_param_spec);
+
   klass->draw = gtk_databox_graph_real_draw;
   klass->calculate_extrema = gtk_databox_graph_real_calculate_extrema;
   klass->create_gc = gtk_databox_graph_real_create_gc;
@@ -371,3 +389,41 @@ gtk_databox_graph_get_hide (GtkDataboxGraph * graph)
 
   return GTK_DATABOX_GRAPH_GET_PRIVATE(graph)->hide;
 }
+
+/**
+ * gtk_databox_graph_set_overlay:
+ * @graph: A #GtkDataboxGraph object
+ * @overlay: Declares whether the graph is an overlay (true) or not (false).
+ *
+ * The #GtkDatabox keeps the drawing of its graphs cached until their data or the
+ * visible limits change. Overlays are drawn anew every time instead, so that graphs
+ * which change all the time, like a marker following the pointer, can be updated
+ * without redrawing the others.
+ *
+ */
+void
+gtk_databox_graph_set_overlay (GtkDataboxGraph * graph, gboolean overlay)
+{
+  g_return_if_fail (GTK_DATABOX_IS_GRAPH (graph));
+
+  GTK_DATABOX_GRAPH_GET_PRIVATE(graph)->overlay = overlay;
+
+  g_object_notify (G_OBJECT (graph), "overlay");
+}
+
+/**
+ * gtk_databox_graph_get_overlay:
+ * @graph: A #GtkDataboxGraph object
+ *
+ * Gets the current "overlay" status.
+ *
+ * Return value: Whether the graph is an overlay (true) or not (false).
+ *
+ */
+gboolean
+gtk_databox_graph_get_overlay (GtkDataboxGraph * graph)
+{
+  g_return_val_if_fail (GTK_DATABOX_IS_GRAPH (graph), FALSE);
+
+  return GTK_DATABOX_GRAPH_GET_PRIVATE(graph)->overlay;
+}
@@ -91,6 +91,9 @@ G_BEGIN_DECLS
    void gtk_databox_graph_set_hide (GtkDataboxGraph * graph, gboolean hide);
    gboolean gtk_databox_graph_get_hide (GtkDataboxGraph * graph);
 
+   void gtk_databox_graph_set_overlay (GtkDataboxGraph * graph, gboolean overlay);
+   gboolean gtk_databox_graph_get_overlay (GtkDataboxGraph * graph);
+
    void gtk_databox_graph_set_color (GtkDataboxGraph * graph,
 				     GdkRGBA * color);
    GdkRGBA *gtk_databox_graph_get_color (GtkDataboxGraph * graph);
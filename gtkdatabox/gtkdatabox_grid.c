@@ -256,14 +256,14 @@ gtk_databox_grid_real_draw (GtkDataboxGraph * graph,
    GtkDataboxGridPrivate *priv = GTK_DATABOX_GRID_GET_PRIVATE(grid);   gint i = 0;
    gfloat x;
    gfloat y;
-   gint16 width;
-   gint16 height;
+   gint width;
+   gint height;
    gfloat offset_x;
    gfloat offset_y;
    gfloat factor_x;
    gfloat factor_y;
-   gint16 pixel_x;
-   gint16 pixel_y;
+   gint pixel_x;
+   gint pixel_y;
    gfloat left, right, top, bottom;
    cairo_t *cr;
    GtkAllocation allocation;
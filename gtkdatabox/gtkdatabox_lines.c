@@ -37,8 +37,8 @@ typedef struct _GtkDataboxLinesPrivate GtkDataboxLinesPrivate;
 
 struct _GtkDataboxLinesPrivate
 {
-   gint16 *xpixels;
-   gint16 *ypixels;
+   gint *xpixels;
+   gint *ypixels;
    guint pixelsalloc;
 };
 
@@ -160,6 +160,79 @@ gtk_databox_lines_new_full (guint maxlen, guint len,
    return GTK_DATABOX_GRAPH (lines);
 }
 
+/* Keeps, in place, the first, lowest, highest and last of each run of points
+ * in the same pixel column: the line drawn through them looks the same.
+ * Of each run of points beyond the same side of the widget only the first and
+ * the last are kept, for the segments crossing into it: the others are hidden.
+ */
+static guint
+gtk_databox_lines_decimate (gint * xpixels, gint * ypixels, guint len,
+			    gint width, gint margin)
+{
+   guint i, j, n;
+   guint first, last, lo, hi, tmp;
+   gint x, y_first, y_lo, y_hi, y_last;
+
+   n = 0;
+   for (i = 0; i < len; i = j)
+   {
+      x = xpixels[i];
+      if (x < -margin || x >= width + margin)
+      {
+	 for (j = i + 1; j < len && (x < -margin ? xpixels[j] < -margin : xpixels[j] >= width + margin); j++)
+	    ;
+	 xpixels[n] = x;
+	 ypixels[n++] = ypixels[i];
+	 if (j - 1 > i)
+	 {
+	    xpixels[n] = xpixels[j - 1];
+	    ypixels[n++] = ypixels[j - 1];
+	 }
+	 continue;
+      }
+
+      first = lo = hi = i;
+      for (j = i + 1; j < len && xpixels[j] == x; j++)
+      {
+	 if (ypixels[j] < ypixels[lo])
+	    lo = j;
+	 else if (ypixels[j] > ypixels[hi])
+	    hi = j;
+      }
+      last = j - 1;
+      if (lo > hi)
+      {
+	 tmp = lo;
+	 lo = hi;
+	 hi = tmp;
+      }
+
+      /* Sources only move forward, so writing at n never overwrites one still needed */
+      y_first = ypixels[first];
+      y_lo = ypixels[lo];
+      y_hi = ypixels[hi];
+      y_last = ypixels[last];
+      xpixels[n] = x;
+      ypixels[n++] = y_first;
+      if (lo > first)
+      {
+	 xpixels[n] = x;
+	 ypixels[n++] = y_lo;
+      }
+      if (hi > lo)
+      {
+	 xpixels[n] = x;
+	 ypixels[n++] = y_hi;
+      }
+      if (last > hi)
+      {
+	 xpixels[n] = x;
+	 ypixels[n++] = y_last;
+      }
+   }
+   return n;
+}
+
 static void
 gtk_databox_lines_real_draw (GtkDataboxGraph * graph,
 			     GtkDatabox * box)
@@ -171,7 +244,7 @@ gtk_databox_lines_real_draw (GtkDataboxGraph * graph,
    void *Y;
    guint len, maxlen;
    cairo_t *cr;
-   gint16 *xpixels, *ypixels;
+   gint *xpixels, *ypixels;
    guint xstart, xstride, ystart, ystride;
    GType xtype, ytype;
    float linewidth;
@@ -185,8 +258,8 @@ gtk_databox_lines_real_draw (GtkDataboxGraph * graph,
    if (priv->pixelsalloc < len)
    {
    	priv->pixelsalloc = len;
-	priv->xpixels = (gint16 *)g_realloc(priv->xpixels, len * sizeof(gint16));
-	priv->ypixels = (gint16 *)g_realloc(priv->ypixels, len * sizeof(gint16));
+	priv->xpixels = (gint *)g_realloc(priv->xpixels, len * sizeof(gint));
+	priv->ypixels = (gint *)g_realloc(priv->ypixels, len * sizeof(gint));
    }
 
    xpixels = priv->xpixels;
@@ -204,9 +277,15 @@ gtk_databox_lines_real_draw (GtkDataboxGraph * graph,
    ytype = gtk_databox_xyc_graph_get_ytype (GTK_DATABOX_XYC_GRAPH (graph));
    gtk_databox_values_to_ypixels(box, ypixels, Y, ytype, maxlen, ystart, ystride, len);
 
+   linewidth = gtk_databox_graph_get_size (graph);
+
+   if (gtk_databox_xyc_graph_get_decimate (GTK_DATABOX_XYC_GRAPH (graph)))
+      len = gtk_databox_lines_decimate (xpixels, ypixels, len,
+					gtk_widget_get_allocated_width (GTK_WIDGET (box)),
+					(gint) linewidth + 2);
+
    cr = gtk_databox_graph_create_gc (graph, box);
 
-   linewidth = gtk_databox_graph_get_size (graph);
    cairo_set_line_width(cr, linewidth + 0.1);
 
    cairo_move_to(cr, xpixels[0] + 0.5, ypixels[0] + 0.5);
@@ -58,8 +58,8 @@ struct _GtkDataboxMarkersPrivate
 {
    GtkDataboxMarkersType type;
    GtkDataboxMarkersInfo *markers_info;
-   gint16 *xpixels;
-   gint16 *ypixels;
+   gint *xpixels;
+   gint *ypixels;
    guint pixelsalloc;
 };
 
@@ -409,16 +409,16 @@ gtk_databox_markers_real_draw (GtkDataboxGraph * graph,
    void *X;
    void *Y;
    guint len, maxlen;
-   gint16 x;
-   gint16 y;
-   gint16 widget_width;
-   gint16 widget_height;
+   gint x;
+   gint y;
+   gint widget_width;
+   gint widget_height;
    GdkPoint coord;
    gint size;
    guint i;
    cairo_t *cr;
    GtkAllocation allocation;
-   gint16 *xpixels, *ypixels;
+   gint *xpixels, *ypixels;
    guint xstart, xstride, ystart, ystride;
    GType xtype, ytype;
 
@@ -436,8 +436,8 @@ gtk_databox_markers_real_draw (GtkDataboxGraph * graph,
    if (priv->pixelsalloc < len)
    {
    	priv->pixelsalloc = len;
-	priv->xpixels = (gint16 *)g_realloc(priv->xpixels, len * sizeof(gint16));
-	priv->ypixels = (gint16 *)g_realloc(priv->ypixels, len * sizeof(gint16));
+	priv->xpixels = (gint *)g_realloc(priv->xpixels, len * sizeof(gint));
+	priv->ypixels = (gint *)g_realloc(priv->ypixels, len * sizeof(gint));
    }
 
    xpixels = priv->xpixels;
@@ -36,9 +36,9 @@ typedef struct _GtkDataboxOffsetBarsPrivate GtkDataboxOffsetBarsPrivate;
 
 struct _GtkDataboxOffsetBarsPrivate
 {
-   gint16 *xpixels;
-   gint16 *y1pixels;
-   gint16 *y2pixels;
+   gint *xpixels;
+   gint *y1pixels;
+   gint *y2pixels;
    guint pixelsalloc;
 };
 
@@ -194,7 +194,7 @@ gtk_databox_offset_bars_real_draw (GtkDataboxGraph * graph,
    void *Y2;
    guint len, maxlen;
    cairo_t *cr;
-   gint16 *xpixels, *y1pixels, *y2pixels;
+   gint *xpixels, *y1pixels, *y2pixels;
    guint xstart, xstride, y1start, y1stride, y2start, y2stride;
    GType xtype, ytype;
 
@@ -211,9 +211,9 @@ gtk_databox_offset_bars_real_draw (GtkDataboxGraph * graph,
    if (priv->pixelsalloc < len)
    {
    	priv->pixelsalloc = len;
-	priv->xpixels = (gint16 *)g_realloc(priv->xpixels, len * sizeof(gint16));
-	priv->y1pixels = (gint16 *)g_realloc(priv->y1pixels, len * sizeof(gint16));
-	priv->y2pixels = (gint16 *)g_realloc(priv->y2pixels, len * sizeof(gint16));
+	priv->xpixels = (gint *)g_realloc(priv->xpixels, len * sizeof(gint));
+	priv->y1pixels = (gint *)g_realloc(priv->y1pixels, len * sizeof(gint));
+	priv->y2pixels = (gint *)g_realloc(priv->y2pixels, len * sizeof(gint));
    }
 
    xpixels = priv->xpixels;
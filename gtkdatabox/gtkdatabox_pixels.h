@@ -0,0 +1,125 @@
+/* GtkDatabox - An extension to the gtk+ library
+ * Copyright (C) 1998 - 2008  Dr. Roland Bock
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Private: the value to pixel conversion of gtkdatabox.c, kept apart so that
+ * bench_values_to_pixels.c measures the very same code. Not installed.
+ */
+
+#ifndef __GTK_DATABOX_PIXELS_H__
+#define __GTK_DATABOX_PIXELS_H__
+
+#include <math.h>
+#include <glib-object.h>
+#include <gtkdatabox_scale.h>
+
+/* Converts one run of contiguous values (no ring buffer wrap-around inside).
+ * There is one loop for each value type and scale, so nothing but the
+ * arithmetic is left inside them. The linear scale takes tf * (value - minvis),
+ * since minvis is subtracted exactly from the values near it, however large
+ * (zoomed in far from 0). The log scales take tf * f(value) + off, where f is
+ * log2 or log10 and off = -tf * f(minvis) was computed once.
+ * The linear loops are vectorized with -O3 (gcc 12 leaves them scalar at -O2),
+ * see bench_values_to_pixels.c.
+ */
+#define GTK_DATABOX_VALUES_TO_PIXELS(ctype)						\
+	G_STMT_START {									\
+		const ctype *v = (const ctype *) values + first * stride;		\
+		if (scale_type == GTK_DATABOX_SCALE_LINEAR && stride == 1)		\
+			for (i = 0; i < len; i++)					\
+				pixels[i] = tf * ((gfloat) v[i] - minvis);		\
+		else if (scale_type == GTK_DATABOX_SCALE_LINEAR)			\
+			for (i = 0; i < len; i++)					\
+				pixels[i] = tf * ((gfloat) v[i * stride] - minvis);	\
+		else if (scale_type == GTK_DATABOX_SCALE_LOG2)				\
+			for (i = 0; i < len; i++)					\
+				pixels[i] = tf * log2 (v[i * stride]) + off;		\
+		else									\
+			for (i = 0; i < len; i++)					\
+				pixels[i] = tf * log10 (v[i * stride]) + off;		\
+	} G_STMT_END
+
+static void
+gtk_databox_values_to_pixels_run (gint *pixels, void *values, GType vtype,
+	guint first, guint stride, guint len,
+	GtkDataboxScaleType scale_type, gfloat tf, gfloat minvis, gfloat off)
+{
+	guint i;
+
+	/* This may be excessive, but it handles every conceivable type */
+	if (vtype == G_TYPE_FLOAT)
+		GTK_DATABOX_VALUES_TO_PIXELS (gfloat);
+	else if (vtype == G_TYPE_DOUBLE)
+		GTK_DATABOX_VALUES_TO_PIXELS (gdouble);
+	else if (vtype == G_TYPE_INT)
+		GTK_DATABOX_VALUES_TO_PIXELS (gint);
+	else if (vtype == G_TYPE_UINT)
+		GTK_DATABOX_VALUES_TO_PIXELS (guint);
+	else if (vtype == G_TYPE_LONG)
+		GTK_DATABOX_VALUES_TO_PIXELS (glong);
+	else if (vtype == G_TYPE_ULONG)
+		GTK_DATABOX_VALUES_TO_PIXELS (gulong);
+	else if (vtype == G_TYPE_INT64)
+		GTK_DATABOX_VALUES_TO_PIXELS (gint64);
+	else if (vtype == G_TYPE_UINT64)
+		GTK_DATABOX_VALUES_TO_PIXELS (guint64);
+	else if (vtype == G_TYPE_CHAR)
+		GTK_DATABOX_VALUES_TO_PIXELS (gchar);
+	else if (vtype == G_TYPE_UCHAR)
+		GTK_DATABOX_VALUES_TO_PIXELS (guchar);
+	else
+		for (i = 0; i < len; i++)
+			pixels[i] = off;
+}
+
+#undef GTK_DATABOX_VALUES_TO_PIXELS
+
+static void
+gtk_databox_values_to_pixels (gint *pixels, void *values, GType vtype,
+	guint maxlen, guint start, guint stride, guint len,
+	GtkDataboxScaleType scale_type, gfloat tf, gfloat minvis)
+{
+	guint first, n;
+	gfloat off;
+
+	if (scale_type == GTK_DATABOX_SCALE_LINEAR)
+		off = -tf * minvis;
+	else if (scale_type == GTK_DATABOX_SCALE_LOG2)
+		off = -tf * log2 (minvis);
+	else
+		off = -tf * log10 (minvis);
+
+	/* handle the wrap-around (ring buffer) issue one contiguous run at a time. */
+	/* note this allows multiple wrap-arounds.  One could hold a single cycle of a sine wave, and plot a continuous wave */
+	if (maxlen == 0)
+	{
+		gtk_databox_values_to_pixels_run (pixels, values, vtype, start, stride, len, scale_type, tf, minvis, off);
+		return;
+	}
+	first = start % maxlen;
+	while (len > 0)
+	{
+		n = MIN (len, maxlen - first);
+		gtk_databox_values_to_pixels_run (pixels, values, vtype, first, stride, n, scale_type, tf, minvis, off);
+		pixels += n;
+		len -= n;
+		first = 0;
+	}
+}
+
+#endif				/* __GTK_DATABOX_PIXELS_H__ */
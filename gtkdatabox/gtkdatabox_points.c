@@ -18,6 +18,7 @@
  */
 
 #include <gtkdatabox_points.h>
+#include <string.h>
 
 G_DEFINE_TYPE(GtkDataboxPoints, gtk_databox_points,
 	GTK_DATABOX_TYPE_XYC_GRAPH)
@@ -36,9 +37,12 @@ typedef struct _GtkDataboxPointsPrivate GtkDataboxPointsPrivate;
 
 struct _GtkDataboxPointsPrivate
 {
-   gint16 *xpixels;
-   gint16 *ypixels;
+   gint *xpixels;
+   gint *ypixels;
    guint pixelsalloc;
+   guint *rows;		/* Column in which each row was last drawn */
+   guint rowsalloc;
+   guint column;
 };
 
 static void
@@ -48,6 +52,7 @@ points_finalize (GObject * object)
 
    g_free (GTK_DATABOX_POINTS_GET_PRIVATE(object)->xpixels);
    g_free (GTK_DATABOX_POINTS_GET_PRIVATE(object)->ypixels);
+   g_free (GTK_DATABOX_POINTS_GET_PRIVATE(object)->rows);
 
    /* Chain up to the parent class */
    G_OBJECT_CLASS (gtk_databox_points_parent_class)->finalize (object);
@@ -69,6 +74,8 @@ gtk_databox_points_class_init (GtkDataboxPointsClass *klass)
 static void
 gtk_databox_points_complete (GtkDataboxPoints * points)
 {
+   g_free (GTK_DATABOX_POINTS_GET_PRIVATE(points)->xpixels);
+   g_free (GTK_DATABOX_POINTS_GET_PRIVATE(points)->ypixels);
    GTK_DATABOX_POINTS_GET_PRIVATE(points)->xpixels = NULL;
    GTK_DATABOX_POINTS_GET_PRIVATE(points)->ypixels = NULL;
    GTK_DATABOX_POINTS_GET_PRIVATE(points)->pixelsalloc = 0;
@@ -164,6 +171,55 @@ gtk_databox_points_new_full (guint maxlen, guint len,
    return GTK_DATABOX_GRAPH (points);
 }
 
+/* Keeps, in place, the points which can be seen: those within the widget,
+ * and in each pixel column only one per row.
+ */
+static guint
+gtk_databox_points_decimate (GtkDataboxPointsPrivate * priv, guint len,
+			     gint width, gint height, gint pointsize)
+{
+   guint i, n;
+   gint x, y;
+   gint lastx;
+   guint rows;
+
+   rows = height + 2 * pointsize;
+   if (priv->rowsalloc < rows)
+   {
+      priv->rowsalloc = rows;
+      priv->rows = (guint *)g_realloc(priv->rows, rows * sizeof(guint));
+      memset (priv->rows, 0, rows * sizeof(guint));
+      priv->column = 0;
+   }
+
+   n = 0;
+   lastx = G_MININT;
+   for (i = 0; i < len; i++)
+   {
+      x = priv->xpixels[i];
+      y = priv->ypixels[i];
+      if (x < -pointsize || x >= width + pointsize || y < -pointsize || y >= height + pointsize)
+	 continue;
+
+      if (x != lastx)
+      {
+	 lastx = x;
+	 if (++priv->column == 0)
+	 {
+	    memset (priv->rows, 0, priv->rowsalloc * sizeof(guint));
+	    priv->column = 1;
+	 }
+      }
+      if (priv->rows[y + pointsize] == priv->column)
+	 continue;
+      priv->rows[y + pointsize] = priv->column;
+
+      priv->xpixels[n] = x;
+      priv->ypixels[n++] = y;
+   }
+   return n;
+}
+
 static void
 gtk_databox_points_real_draw (GtkDataboxGraph * graph,
 			      GtkDatabox* box)
@@ -176,7 +232,7 @@ gtk_databox_points_real_draw (GtkDataboxGraph * graph,
    guint len, maxlen;
    gint pointsize = 0;
    cairo_t *cr;
-   gint16 *xpixels, *ypixels;
+   gint *xpixels, *ypixels;
    guint xstart, xstride, ystart, ystride;
    GType xtype, ytype;
 
@@ -191,8 +247,8 @@ gtk_databox_points_real_draw (GtkDataboxGraph * graph,
    if (priv->pixelsalloc < len)
    {
    	priv->pixelsalloc = len;
-	priv->xpixels = (gint16 *)g_realloc(priv->xpixels, len * sizeof(gint16));
-	priv->ypixels = (gint16 *)g_realloc(priv->ypixels, len * sizeof(gint16));
+	priv->xpixels = (gint *)g_realloc(priv->xpixels, len * sizeof(gint));
+	priv->ypixels = (gint *)g_realloc(priv->ypixels, len * sizeof(gint));
    }
 
    xpixels = priv->xpixels;
@@ -212,6 +268,12 @@ gtk_databox_points_real_draw (GtkDataboxGraph * graph,
 
    pointsize = gtk_databox_graph_get_size (graph);
 
+   if (gtk_databox_xyc_graph_get_decimate (GTK_DATABOX_XYC_GRAPH (graph)))
+      len = gtk_databox_points_decimate (priv, len,
+					 gtk_widget_get_allocated_width (GTK_WIDGET (box)),
+					 gtk_widget_get_allocated_height (GTK_WIDGET (box)),
+					 ABS (pointsize));
+
    for (i = 0; i < len; i++, xpixels++, ypixels++)
       cairo_rectangle(cr, *xpixels - pointsize / 2, *ypixels - pointsize / 2, pointsize, pointsize);
 
@@ -43,6 +43,8 @@
 #define LINEAR_FORMAT_MARKUP "%%-+%dg"
 #define LOG_FORMAT_MARKUP "%%-%dg"
 
+#define LABEL_CACHE_SIZE 256 /* tick labels kept between redraws */
+
 static void gtk_databox_ruler_draw_ticks (GtkDataboxRuler * ruler);
 static void gtk_databox_ruler_draw_pos (GtkDataboxRuler * ruler);
 static gint gtk_databox_ruler_motion_notify (GtkWidget * widget,
@@ -68,6 +70,30 @@ static void gtk_databox_ruler_get_property (GObject * object,
         guint prop_id,
         GValue * value,
         GParamSpec * pspec);
+static void gtk_databox_ruler_notify (GObject * object,
+        GParamSpec * pspec);
+static void gtk_databox_ruler_finalize (GObject * object);
+static void gtk_databox_ruler_style_updated (GtkWidget * widget);
+static void gtk_databox_ruler_flush_labels (GtkDataboxRuler * ruler, gboolean layouts);
+
+/* A tick label is the n-th multiple of the tick step (or the n-th manual tick, with a step of 0) */
+typedef struct _GtkDataboxRulerTick GtkDataboxRulerTick;
+
+struct _GtkDataboxRulerTick
+{
+    gint64 n;
+    gdouble step;
+};
+
+/* The laid out text of a tick label */
+typedef struct _GtkDataboxRulerLabel GtkDataboxRulerLabel;
+
+struct _GtkDataboxRulerLabel
+{
+    PangoLayout *layout;
+    PangoRectangle ink_rect;
+    PangoRectangle logical_rect;
+};
 
 enum {
     PROP_0,
@@ -147,6 +173,18 @@ struct _GtkDataboxRulerPrivate
     gchar **manual_tick_labels;
 
     GtkShadowType box_shadow; /* The type of shadow drawn on the ruler pixmap */
+
+    /* Whether the backing surface holds the ticks for the current range and properties */
+    gboolean ticks_valid;
+    /* Formatted tick labels by tick, and their layouts by text; the font and format are implied */
+    GHashTable *label_texts;
+    GHashTable *label_layouts;
+    /* Width of a digit, 0 if it must be measured again */
+    gint digit_width;
+    /* The tick step depends on the span and the length of the ruler only, not on the offset */
+    gdouble step_span;
+    gint step_length;
+    gdouble step;
 };
 
 G_DEFINE_TYPE (GtkDataboxRuler, gtk_databox_ruler, GTK_TYPE_WIDGET)
@@ -160,11 +198,14 @@ static void gtk_databox_ruler_class_init (GtkDataboxRulerClass * class) {
 
     gobject_class->set_property = gtk_databox_ruler_set_property;
     gobject_class->get_property = gtk_databox_ruler_get_property;
+    gobject_class->notify = gtk_databox_ruler_notify;
+    gobject_class->finalize = gtk_databox_ruler_finalize;
 
     widget_class->realize = gtk_databox_ruler_realize;
     widget_class->unrealize = gtk_databox_ruler_unrealize;
     widget_class->size_allocate = gtk_databox_ruler_size_allocate;
     widget_class->draw = gtk_databox_ruler_draw;
+    widget_class->style_updated = gtk_databox_ruler_style_updated;
     widget_class->motion_notify_event = gtk_databox_ruler_motion_notify;
     widget_class->get_preferred_width = gtk_databox_ruler_get_preferred_width;
     widget_class->get_preferred_height = gtk_databox_ruler_get_preferred_height;
@@ -327,6 +368,82 @@ static void gtk_databox_ruler_class_init (GtkDataboxRulerClass * class) {
                                              G_PARAM_READWRITE));
 }
 
+static guint
+gtk_databox_ruler_tick_hash (gconstpointer key) {
+    const GtkDataboxRulerTick *tick = key;
+
+    return g_int64_hash (&tick->n) ^ g_double_hash (&tick->step);
+}
+
+static gboolean
+gtk_databox_ruler_tick_equal (gconstpointer a, gconstpointer b) {
+    const GtkDataboxRulerTick *tick_a = a;
+    const GtkDataboxRulerTick *tick_b = b;
+
+    return tick_a->n == tick_b->n && tick_a->step == tick_b->step;
+}
+
+static void
+gtk_databox_ruler_label_free (gpointer data) {
+    GtkDataboxRulerLabel *label = data;
+
+    g_object_unref (label->layout);
+    g_free (label);
+}
+
+/* The texts go with the format, the layouts with the font and the text orientation */
+static void
+gtk_databox_ruler_flush_labels (GtkDataboxRuler * ruler, gboolean layouts) {
+    g_hash_table_remove_all (ruler->priv->label_texts);
+    ruler->priv->step_length = -1;
+    if (layouts) {
+        g_hash_table_remove_all (ruler->priv->label_layouts);
+        ruler->priv->digit_width = 0;
+    }
+}
+
+static const gchar *
+gtk_databox_ruler_get_label_text (GtkDataboxRuler * ruler, const gchar * format,
+                                  gint64 n, gdouble step, gdouble value) {
+    GtkDataboxRulerTick key;
+    GtkDataboxRulerTick *tick;
+    gchar *text;
+
+    key.n = n;
+    key.step = step;
+    text = g_hash_table_lookup (ruler->priv->label_texts, &key);
+    if (text)
+        return text;
+
+    if (g_hash_table_size (ruler->priv->label_texts) >= LABEL_CACHE_SIZE)
+        g_hash_table_remove_all (ruler->priv->label_texts);
+
+    tick = g_new (GtkDataboxRulerTick, 1);
+    *tick = key;
+    text = g_malloc (ruler->priv->max_length + 1);
+    g_snprintf (text, ruler->priv->max_length + 1, format, value);
+    g_hash_table_insert (ruler->priv->label_texts, tick, text);
+    return text;
+}
+
+static const GtkDataboxRulerLabel *
+gtk_databox_ruler_get_label (GtkDataboxRuler * ruler, const gchar * text) {
+    GtkDataboxRulerLabel *label;
+
+    label = g_hash_table_lookup (ruler->priv->label_layouts, text);
+    if (label)
+        return label;
+
+    if (g_hash_table_size (ruler->priv->label_layouts) >= LABEL_CACHE_SIZE)
+        g_hash_table_remove_all (ruler->priv->label_layouts);
+
+    label = g_new (GtkDataboxRulerLabel, 1);
+    label->layout = gtk_widget_create_pango_layout (GTK_WIDGET (ruler), text);
+    pango_layout_get_pixel_extents (label->layout, &label->ink_rect, &label->logical_rect);
+    g_hash_table_insert (ruler->priv->label_layouts, g_strdup (text), label);
+    return label;
+}
+
 static void
 gtk_databox_ruler_init (GtkDataboxRuler * ruler) {
     ruler->priv = g_new0 (GtkDataboxRulerPrivate, 1);
@@ -353,6 +470,51 @@ gtk_databox_ruler_init (GtkDataboxRuler * ruler) {
     ruler->priv->manual_tick_cnt=0;
     ruler->priv->manual_tick_labels=NULL;
     ruler->priv->box_shadow=GTK_SHADOW_OUT;
+    ruler->priv->ticks_valid = FALSE;
+    ruler->priv->label_texts = g_hash_table_new_full (gtk_databox_ruler_tick_hash,
+                               gtk_databox_ruler_tick_equal, g_free, g_free);
+    ruler->priv->label_layouts = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                 g_free, gtk_databox_ruler_label_free);
+    ruler->priv->digit_width = 0;
+    ruler->priv->step_length = -1;
+}
+
+static void
+gtk_databox_ruler_finalize (GObject * object) {
+    GtkDataboxRuler *ruler = GTK_DATABOX_RULER (object);
+
+    g_hash_table_destroy (ruler->priv->label_texts);
+    g_hash_table_destroy (ruler->priv->label_layouts);
+    g_free (ruler->priv);
+
+    G_OBJECT_CLASS (gtk_databox_ruler_parent_class)->finalize (object);
+}
+
+/* Anything but the position arrow changes the ticks */
+static void
+gtk_databox_ruler_notify (GObject * object, GParamSpec * pspec) {
+    GtkDataboxRuler *ruler = GTK_DATABOX_RULER (object);
+    const gchar *name = g_param_spec_get_name (pspec);
+
+    if (!g_str_equal (name, "position")) {
+        ruler->priv->ticks_valid = FALSE;
+        if (g_str_equal (name, "orientation") || g_str_equal (name, "text-orientation"))
+            gtk_databox_ruler_flush_labels (ruler, TRUE);
+        else if (!g_str_equal (name, "lower") && !g_str_equal (name, "upper"))
+            gtk_databox_ruler_flush_labels (ruler, FALSE);
+    }
+
+    if (G_OBJECT_CLASS (gtk_databox_ruler_parent_class)->notify)
+        G_OBJECT_CLASS (gtk_databox_ruler_parent_class)->notify (object, pspec);
+}
+
+static void
+gtk_databox_ruler_style_updated (GtkWidget * widget) {
+    GTK_WIDGET_CLASS (gtk_databox_ruler_parent_class)->style_updated (widget);
+
+    /* The font may have changed */
+    gtk_databox_ruler_flush_labels (GTK_DATABOX_RULER (widget), TRUE);
+    GTK_DATABOX_RULER (widget)->priv->ticks_valid = FALSE;
 }
 
 /**
@@ -624,6 +786,8 @@ gtk_databox_ruler_set_scale_type (GtkDataboxRuler * ruler,
     if (ruler->priv->scale_type != scale_type) {
         ruler->priv->scale_type = scale_type;
         /* g_object_notify (G_OBJECT (ruler), "scale-type"); */
+        gtk_databox_ruler_flush_labels (ruler, FALSE);
+        ruler->priv->ticks_valid = FALSE;
     }
 
     if (gtk_widget_is_drawable (GTK_WIDGET (ruler)))
@@ -1276,6 +1440,7 @@ gtk_databox_ruler_set_box_shadow(GtkDataboxRuler * ruler, GtkShadowType which_sh
 
     if (ruler->priv->box_shadow!=which_shadow) {
         ruler->priv->box_shadow=which_shadow;
+        ruler->priv->ticks_valid = FALSE;
         if (gtk_widget_is_drawable (GTK_WIDGET (ruler)))
             gtk_widget_queue_draw (GTK_WIDGET (ruler));
     }
@@ -1313,7 +1478,9 @@ gtk_databox_ruler_draw_ticks (GtkDataboxRuler * ruler) {
     gint digit;
     gdouble subd_incr;
     gdouble start, end, cur, cur_text;
-    gchar unit_str[GTK_DATABOX_RULER_MAX_MAX_LENGTH + 1];	/* buffer for writing numbers */
+    const gchar *unit_str;
+    gint64 n;
+    const GtkDataboxRulerLabel *label;
     gint digit_width;
     gint text_width;
     gint pos;
@@ -1325,6 +1492,7 @@ gtk_databox_ruler_draw_ticks (GtkDataboxRuler * ruler) {
     PangoLayout *layout;
     PangoRectangle logical_rect, ink_rect;
 	GtkAllocation allocation;
+    gint extent;
 	GdkRGBA fg_color, bg_color;
 
     GtkBorder padding;
@@ -1348,20 +1516,26 @@ gtk_databox_ruler_draw_ticks (GtkDataboxRuler * ruler) {
 	gtk_widget_get_allocation(widget, &allocation);
 	stylecontext = gtk_widget_get_style_context(widget);
 
-    layout = gtk_widget_create_pango_layout (widget, "E+-012456789");
-
-    if ((ruler->priv->orientation == GTK_ORIENTATION_VERTICAL) && (ruler->priv->text_orientation == GTK_ORIENTATION_VERTICAL)) {
-        /* vertical ruler with vertical text */
-        context = gtk_widget_get_pango_context (widget);
-        pango_context_set_base_gravity (context, PANGO_GRAVITY_WEST);
-        pango_matrix_rotate (&matrix, 90.);
-        pango_context_set_matrix (context, &matrix);
-        pango_layout_context_changed(layout);
-    }
+    /* Changing the context would lay out all the cached labels again, so it is only
+     * done when they were thrown away */
+    if (ruler->priv->digit_width == 0) {
+        layout = gtk_widget_create_pango_layout (widget, "E+-012456789");
+
+        if ((ruler->priv->orientation == GTK_ORIENTATION_VERTICAL) && (ruler->priv->text_orientation == GTK_ORIENTATION_VERTICAL)) {
+            /* vertical ruler with vertical text */
+            context = gtk_widget_get_pango_context (widget);
+            pango_context_set_base_gravity (context, PANGO_GRAVITY_WEST);
+            pango_matrix_rotate (&matrix, 90.);
+            pango_context_set_matrix (context, &matrix);
+            pango_layout_context_changed(layout);
+        }
 
-    pango_layout_get_pixel_extents (layout, &ink_rect, &logical_rect);
+        pango_layout_get_pixel_extents (layout, &ink_rect, &logical_rect);
+        g_object_unref (layout);
 
-    digit_width = ceil ((logical_rect.width) / 12);
+        ruler->priv->digit_width = MAX (ceil ((logical_rect.width) / 12), 1);
+    }
+    digit_width = ruler->priv->digit_width;
 
     width = allocation.width;
     height = allocation.height;
@@ -1408,17 +1582,18 @@ gtk_databox_ruler_draw_ticks (GtkDataboxRuler * ruler) {
     if ((upper - lower) == 0)
         goto out;
 
-    if (ruler->priv->orientation == GTK_ORIENTATION_HORIZONTAL)
-        increment = (gdouble) width / (upper - lower);
-    else
-        increment = (gdouble) height / (upper - lower);
+    extent = (ruler->priv->orientation == GTK_ORIENTATION_HORIZONTAL) ? width : height;
+    increment = (gdouble) extent / (upper - lower);
 
 
     /* determine the scale, i.e. the distance between the most significant ticks
      *
      * the ticks have to be farther apart than the length of the displayed numbers
      */
-    if (ruler->priv->scale_type == GTK_DATABOX_SCALE_LINEAR) {
+    if (ruler->priv->step_length == extent && ruler->priv->step_span == upper - lower) {
+        /* Only the offset changed: panning */
+        subd_incr = ruler->priv->step;
+    } else if (ruler->priv->scale_type == GTK_DATABOX_SCALE_LINEAR) {
         text_width = (ruler->priv->max_length) * digit_width + 1;
 
         for (power = -20; power < 21; power++) {
@@ -1441,6 +1616,9 @@ gtk_databox_ruler_draw_ticks (GtkDataboxRuler * ruler) {
     } else {
         subd_incr = 1.;
     }
+    ruler->priv->step_length = extent;
+    ruler->priv->step_span = upper - lower;
+    ruler->priv->step = subd_incr;
 
     length = (ruler->priv->orientation == GTK_ORIENTATION_HORIZONTAL)
              ? height - 5 : width - 5;
@@ -1485,22 +1663,26 @@ gtk_databox_ruler_draw_ticks (GtkDataboxRuler * ruler) {
 
         /* draw label */
         /* if manual tick labels are present, display them instead of calculated labels */
+        /* the labels are looked up by their tick number, so they are found again
+         * while panning, and formatted and laid out only the first time */
         if ((ruler->priv->manual_ticks!=NULL) && (ruler->priv->manual_tick_cnt!=0) && (ruler->priv->manual_tick_labels!=NULL))
-            pango_layout_set_text (layout, ruler->priv->manual_tick_labels[(int)cur], -1);
+            unit_str = ruler->priv->manual_tick_labels[(int)cur];
+        else if (ruler->priv->manual_ticks!=NULL)
+            unit_str = gtk_databox_ruler_get_label_text (ruler, format_string, (gint64) cur, 0., cur_text);
         else {
-            if ((ruler->priv->scale_type == GTK_DATABOX_SCALE_LINEAR) || (ruler->priv->manual_ticks!=NULL)) {
-                if (ABS (cur_text) < 0.1 * subd_incr)	/* Rounding errors occur and might make "0" look funny without this check */
-                    cur_text = 0;
-
-                g_snprintf (unit_str, ruler->priv->max_length + 1, format_string, cur_text);
-            } else if (ruler->priv->scale_type == GTK_DATABOX_SCALE_LOG2)
-                g_snprintf (unit_str, ruler->priv->max_length + 1, format_string, pow (2, cur_text));
+            n = (gint64) floor (cur / subd_incr + 0.5);
+            /* Multiplying avoids the rounding errors which might make "0" look funny */
+            if (ruler->priv->scale_type == GTK_DATABOX_SCALE_LINEAR)
+                unit_str = gtk_databox_ruler_get_label_text (ruler, format_string, n, subd_incr, n * subd_incr);
+            else if (ruler->priv->scale_type == GTK_DATABOX_SCALE_LOG2)
+                unit_str = gtk_databox_ruler_get_label_text (ruler, format_string, n, subd_incr, pow (2, n * subd_incr));
             else
-                g_snprintf (unit_str, ruler->priv->max_length + 1, format_string, pow (10, cur_text));
-
-            pango_layout_set_text (layout, unit_str, -1);
+                unit_str = gtk_databox_ruler_get_label_text (ruler, format_string, n, subd_incr, pow (10, n * subd_incr));
         }
-        pango_layout_get_pixel_extents (layout, &ink_rect, &logical_rect);
+        label = gtk_databox_ruler_get_label (ruler, unit_str);
+        layout = label->layout;
+        ink_rect = label->ink_rect;
+        logical_rect = label->logical_rect;
 
         /* remember the pixel extents for sizing later. */
         if ((ruler->priv->orientation == GTK_ORIENTATION_VERTICAL) & (ruler->priv->max_y_text_width<logical_rect.width)) {
@@ -1576,8 +1758,6 @@ gtk_databox_ruler_draw_ticks (GtkDataboxRuler * ruler) {
     cairo_fill (cr);
 out:
     cairo_destroy (cr);
-
-    g_object_unref (layout);
 }
 
 static void
@@ -1757,7 +1937,10 @@ gtk_databox_ruler_draw (GtkWidget * widget, cairo_t * cr){
         ruler = GTK_DATABOX_RULER (widget);
 		gtk_widget_get_allocation(widget, &allocation);
 
-        gtk_databox_ruler_draw_ticks (ruler);
+        if (!ruler->priv->ticks_valid) {
+            gtk_databox_ruler_draw_ticks (ruler);
+            ruler->priv->ticks_valid = TRUE;
+        }
 
 		if (ruler->priv->backing_surface)
 		{
@@ -1796,6 +1979,7 @@ gtk_databox_ruler_create_backing_surface (GtkDataboxRuler * ruler) {
 
 	ruler->priv->old_width = width;
 	ruler->priv->old_height = height;
+	ruler->priv->ticks_valid = FALSE;
 
 	cr = gdk_cairo_create(gtk_widget_get_window(widget));
 
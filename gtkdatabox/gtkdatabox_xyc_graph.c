@@ -41,7 +41,8 @@ enum
    PROP_XSTRIDE,
    PROP_YSTRIDE,
    PROP_XTYPE,
-   PROP_YTYPE
+   PROP_YTYPE,
+   PROP_DECIMATE
 };
 
 /**
@@ -65,6 +66,7 @@ struct _GtkDataboxXYCGraphPrivate
    guint ystride;
    GType xtype;
    GType ytype;
+   gboolean decimate;
 };
 
 /*
@@ -184,6 +186,25 @@ gtk_databox_xyc_graph_set_ytype (GtkDataboxXYCGraph * xyc_graph, GType ytype)
    g_object_notify (G_OBJECT (xyc_graph), "Y-Values");
 }
 
+/**
+ * gtk_databox_xyc_graph_set_decimate:
+ * @xyc_graph: A #GtkDataboxXYCGraph object
+ * @decimate: Whether to decimate
+ *
+ * Lets the graph draw only what can be seen of the data points falling into the same
+ * pixel column (#GtkDataboxLines and #GtkDataboxPoints), so that drawing a long series
+ * costs about as much as the width of the widget. This is the default.
+ */
+void
+gtk_databox_xyc_graph_set_decimate (GtkDataboxXYCGraph * xyc_graph, gboolean decimate)
+{
+   g_return_if_fail (GTK_DATABOX_IS_XYC_GRAPH (xyc_graph));
+
+   GTK_DATABOX_XYC_GRAPH_GET_PRIVATE(xyc_graph)->decimate = decimate;
+
+   g_object_notify (G_OBJECT (xyc_graph), "decimate");
+}
+
 static void
 gtk_databox_xyc_graph_set_property (GObject * object,
 				    guint property_id,
@@ -223,6 +244,9 @@ gtk_databox_xyc_graph_set_property (GObject * object,
    case PROP_YTYPE:
       gtk_databox_xyc_graph_set_ytype (xyc_graph, g_value_get_gtype (value));
       break;
+   case PROP_DECIMATE:
+      gtk_databox_xyc_graph_set_decimate (xyc_graph, g_value_get_boolean (value));
+      break;
    default:
       /* We don't have any other property... */
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -398,6 +422,21 @@ gtk_databox_xyc_graph_get_ytype (GtkDataboxXYCGraph * xyc_graph)
    return GTK_DATABOX_XYC_GRAPH_GET_PRIVATE(xyc_graph)->ytype;
 }
 
+/**
+ * gtk_databox_xyc_graph_get_decimate:
+ * @xyc_graph: A #GtkDataboxXYCGraph object
+ *
+ * Gets whether the data points falling into the same pixel column are decimated.
+ *
+ * Return value: TRUE if they are decimated
+ */
+gboolean
+gtk_databox_xyc_graph_get_decimate (GtkDataboxXYCGraph * xyc_graph)
+{
+   g_return_val_if_fail (GTK_DATABOX_IS_XYC_GRAPH (xyc_graph), FALSE);
+   return GTK_DATABOX_XYC_GRAPH_GET_PRIVATE(xyc_graph)->decimate;
+}
+
 static void
 gtk_databox_xyc_graph_get_property (GObject * object,
 				    guint property_id,
@@ -437,6 +476,9 @@ gtk_databox_xyc_graph_get_property (GObject * object,
    case PROP_YTYPE:
       g_value_set_gtype (value, gtk_databox_xyc_graph_get_ytype (xyc_graph));
       break;
+   case PROP_DECIMATE:
+      g_value_set_boolean (value, gtk_databox_xyc_graph_get_decimate (xyc_graph));
+      break;
    default:
       /* We don't have any other property... */
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -521,6 +563,12 @@ gtk_databox_xyc_graph_class_init (GtkDataboxXYCGraphClass *klass)
    g_object_class_install_property (gobject_class,
 				    PROP_YTYPE, xyc_graph_param_spec);
 
+   xyc_graph_param_spec = g_param_spec_boolean ("decimate", "Decimate", "Draw only what can be seen in each pixel column", TRUE,	/* default value */
+					    G_PARAM_CONSTRUCT |
+					    G_PARAM_READWRITE);
+   g_object_class_install_property (gobject_class,
+				    PROP_DECIMATE, xyc_graph_param_spec);
+
    graph_class->calculate_extrema =
       gtk_databox_xyc_graph_real_calculate_extrema;
 
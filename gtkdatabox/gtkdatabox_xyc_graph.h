@@ -87,6 +87,9 @@ G_BEGIN_DECLS
    guint gtk_databox_xyc_graph_get_ystride (GtkDataboxXYCGraph * xyc_graph);
    GType gtk_databox_xyc_graph_get_xtype (GtkDataboxXYCGraph * xyc_graph);
    GType gtk_databox_xyc_graph_get_ytype (GtkDataboxXYCGraph * xyc_graph);
+   gboolean gtk_databox_xyc_graph_get_decimate (GtkDataboxXYCGraph * xyc_graph);
+
+   void gtk_databox_xyc_graph_set_decimate (GtkDataboxXYCGraph * xyc_graph, gboolean decimate);
 
    void gtk_databox_xyc_graph_set_X_Y_length(GtkDataboxXYCGraph * xyc_graph, gfloat * X, gfloat * Y, guint len);
 
@@ -523,14 +523,13 @@ accur_sort ()
  * Creates a random weird word based on error profile
  */
 gboolean
-accur_create_word (gunichar word[MAX_WORD_LEN + 1])
+accur_create_word (gunichar word[MAX_WORD_LEN + 1], Rnd *rnd)
 {
 	gint i, j;
 	gint ind;
 	gint n;
-	gunichar vowels[20];
 	gunichar last = 0;
-	gint vlen;
+	const KeybClasses *kc;
 	gboolean ptype_terror;
 	gboolean ptype_ttime;
 	static gint profile_type = 0;
@@ -540,8 +539,8 @@ accur_create_word (gunichar word[MAX_WORD_LEN + 1])
 
 	ptype_terror = accur_error_total () >= ERROR_LIMIT;
 	ptype_ttime = accur_profi_aver_norm (0) >= PROFI_LIMIT;
-	vlen = keyb_get_vowels (vowels);
-	n = rand () % (MAX_WORD_LEN) + 1;
+	kc = keyb_get_classes ();
+	n = rnd_int (rnd, MAX_WORD_LEN) + 1;
 	for (i = 0; i < n; i++)
 	{
 		if (profile_type == 0)
@@ -553,10 +552,10 @@ accur_create_word (gunichar word[MAX_WORD_LEN + 1])
 		{
 			for (j = 0; j < 100; j++)
 			{
-				ind = rand () % terror_n;
+				ind = rnd_int (rnd, terror_n);
 				if (terror[ind].uchr == last)
 					continue;
-				if (rand () % terror[0].wrong < terror[ind].wrong)
+				if (rnd_int (rnd, terror[0].wrong) < terror[ind].wrong)
 					break;
 			}
 			word[i] = terror[ind].uchr;
@@ -565,10 +564,10 @@ accur_create_word (gunichar word[MAX_WORD_LEN + 1])
 		{
 			for (j = 0; j < 100; j++)
 			{
-				ind = rand () % ttime_n;
+				ind = rnd_int (rnd, ttime_n);
 				if (ttime[ind].uchr == last)
 					continue;
-				if (rand () % accur_profi_aver_norm (0) < accur_profi_aver_norm (ind))
+				if (rnd_int (rnd, accur_profi_aver_norm (0)) < accur_profi_aver_norm (ind))
 					break;
 			}
 			word[i] = ttime[ind].uchr;
@@ -580,7 +579,7 @@ accur_create_word (gunichar word[MAX_WORD_LEN + 1])
 		if (i > 0)
 			if (keyb_is_diacritic (word[i - 1]) && keyb_is_diacritic (word[i]))
 			{
-				word[i] = vowels[rand () % vlen];
+				word[i] = kc->vowels[rnd_int (rnd, kc->n_vowels)];
 				last = word[i];
 			}
 	}
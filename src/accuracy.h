@@ -39,5 +39,5 @@ gulong accur_error_total (void);
 void accur_terror_sort (void);
 void accur_ttime_sort (void);
 void accur_sort (void);
-gboolean accur_create_word (gunichar *word);
+gboolean accur_create_word (gunichar *word, Rnd *rnd);
 void accur_close (void);
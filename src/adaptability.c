@@ -25,24 +25,41 @@
 #include "tutor.h"
 #include "translation.h"
 #include "accuracy.h"
+#include "markov.h"
 #include "adaptability.h"
 
+/* Flags of the language for the word endings, updated only when it changes
+ */
+static struct
+{
+	gchar code[16];
+	gboolean urdu;
+	gboolean punjabi;
+	gboolean stopmark;
+	const Markov *markov;
+} lang_flags = { "", FALSE, FALSE, TRUE, NULL };
+
+static void
+adapt_set_language (const gchar *lang)
+{
+	lang_flags.markov = markov_get (lang);
+	if (g_str_equal (lang_flags.code, lang))
+		return;
+
+	g_strlcpy (lang_flags.code, lang, sizeof (lang_flags.code));
+	lang_flags.urdu = g_str_has_prefix (lang, "ur");
+	lang_flags.punjabi = g_str_has_prefix (lang, "pa");
+	lang_flags.stopmark = trans_code_has_stopmark (lang);
+}
+
 /**********************************************************************
- * Writes a random pattern of weird words in the exercise window
+ * Tells if the words should be created from the error profile, showing
+ * the button which lets the student choose it or not.
  */
-void
-adapt_draw_random_pattern ()
+gboolean
+adapt_get_special ()
 {
-	gint i, j, k;
-	gint tidx;
-	gchar *hlp;
-	gchar *utf8_text;
-	gunichar text[WORDS * (MAX_WORD_LEN + 1) + 3];
-	gunichar word[MAX_WORD_LEN + 1];
 	gboolean special;
-	gboolean word_ok = FALSE;
-
-	hlp = main_preferences_get_string ("interface", "language");
 
 	special = accur_error_total () >= ERROR_LIMIT ||
 		       	accur_profi_aver_norm (0) >= PROFI_LIMIT;
@@ -54,90 +71,119 @@ adapt_draw_random_pattern ()
 	else
 		gtk_widget_hide (get_wg ("togglebutton_toomuch_errors"));
 
+	return (special);
+}
+
+/**********************************************************************
+ * Appends a random pattern of weird words to 'text'.
+ * No widget nor preference is touched here, so that it may run off the
+ * main loop: 'special' comes from adapt_get_special () and 'lang' is the
+ * language code.
+ */
+void
+adapt_create_random_pattern (GString *text, gboolean special, const gchar *lang, Rnd *rnd)
+{
+	gint i, j, k;
+	gint tidx;
+	gchar *utf8_text;
+	gunichar par[WORDS * (MAX_WORD_LEN + 1) + 3];
+	gunichar word[MAX_WORD_LEN + 1];
+	gboolean word_ok = FALSE;
+
+	adapt_set_language (lang);
 	for (i = 0; i < LINES; i++)
 	{			/* paragraphs per exercise */
 		tidx = 0;
 		for (j = 0; j < WORDS; j++)
 		{		/* words per paragraph */
 			if (special)
-				word_ok = accur_create_word (word);
+				word_ok = accur_create_word (word, rnd);
 
 			if (!special || !word_ok)
 			{
-				if (rand () % 15)
-					adapt_create_word (word);
+				if (rnd_int (rnd, 15))
+					adapt_create_word (word, rnd);
 				else
-					adapt_create_number (word);
+					adapt_create_number (word, rnd);
 			}
 
 			if (j == 0)
 				word[0] = keyb_unichar_toupper (word[0]);
 			else
-				text[tidx++] = L' ';
+				par[tidx++] = L' ';
 
 			for (k = 0; word[k] != L'\0'; k++)
-				text[tidx++] = word[k];
+				par[tidx++] = word[k];
 		}
-		if (g_str_has_prefix (hlp, "ur"))
-			text[tidx++] = URDU_STOP;
-		if (g_str_has_prefix (hlp, "pa"))
-			text[tidx++] = DEVANAGARI_STOP;
-		else if (trans_lang_has_stopmark ())
-			text[tidx++] = L'.';
-		text[tidx++] = L'\n';
-		text[tidx++] = L'\0';
-		utf8_text = g_ucs4_to_utf8 (text, -1, NULL, NULL, NULL);
-		tutor_draw_paragraph (utf8_text);
+		if (lang_flags.urdu)
+			par[tidx++] = URDU_STOP;
+		if (lang_flags.punjabi)
+			par[tidx++] = DEVANAGARI_STOP;
+		else if (lang_flags.stopmark)
+			par[tidx++] = L'.';
+		par[tidx++] = L'\n';
+		par[tidx++] = L'\0';
+		utf8_text = g_ucs4_to_utf8 (par, -1, NULL, NULL, NULL);
+		tutor_format_paragraph (text, utf8_text);
 		g_free (utf8_text);
 	}
-
-	g_free (hlp);
 }
 
 /*
- * Creates a random weird word
+ * Creates a random pseudo-word, pronounceable if the language model allows,
+ * or else a weird one
  */
 void
-adapt_create_word (gunichar word[MAX_WORD_LEN + 1])
+adapt_create_word (gunichar word[MAX_WORD_LEN + 1], Rnd *rnd)
 {
-	gchar *hlp;
 	gint i, n;
-	gint vlen, clen, slen;
-	gunichar vowels[20];
-	gunichar consonants[4 * KEY_LINE_LEN];
-	gunichar symbols[4 * KEY_LINE_LEN];
+	const KeybClasses *kc;
+
+	if (rnd_int (rnd, 25) && markov_create_word (lang_flags.markov, word, MAX_WORD_LEN - 1, rnd))
+	{
+		if (!rnd_int (rnd, 7))	/* capital */
+			word[0] = keyb_unichar_toupper (word[0]);
+		if (!rnd_int (rnd, 20))
+		{
+			for (n = 0; word[n] != L'\0'; n++);
+			if (lang_flags.urdu)
+				word[n++] = URDU_COMMA;
+			else if (lang_flags.stopmark)
+				word[n++] = L',';
+			word[n] = L'\0';
+		}
+		return;
+	}
 
-	vlen = keyb_get_vowels (vowels);
-	clen = keyb_get_consonants (consonants);
-	slen = keyb_get_symbols (symbols);
+	kc = keyb_get_classes ();
 
-	n = rand () % (MAX_WORD_LEN - 1) + 1;
+	n = rnd_int (rnd, MAX_WORD_LEN - 1) + 1;
 	for (i = 0; i < n; i++)
 	{
-		if ((rand () % 25))
+		if (rnd_int (rnd, 25))
 		{
 			/* Literal */
 			if (i % 2)	/* vowel */
-				if (rand () % 30)
-					word[i] = vowels[rand () % vlen];
+				if (rnd_int (rnd, 30))
+					word[i] = kc->vowels[rnd_int (rnd, kc->n_vowels)];
 				else
-					word[i] = consonants[rand () % clen];
-			else if (rand () % 50)	/* consonant */
-				word[i] = consonants[rand () % clen];
+					word[i] = kc->consonants[rnd_int (rnd, kc->n_consonants)];
+			else if (rnd_int (rnd, 50))	/* consonant */
+				word[i] = kc->consonants[rnd_int (rnd, kc->n_consonants)];
 			else
-				word[i] = vowels[rand () % vlen];
-			if (i == 0 && !(rand () % 7))	/* capital */
+				word[i] = kc->vowels[rnd_int (rnd, kc->n_vowels)];
+			if (i == 0 && !rnd_int (rnd, 7))	/* capital */
 				word[0] = keyb_unichar_toupper (word[0]);
 		}
 		else
 		{
 			/* Symbol */
-			word[i] = symbols[rand () % slen];
+			word[i] = kc->symbols[rnd_int (rnd, kc->n_symbols)];
 			if (word[i] == L'\\' && i > 0)
 				word[i] = L'-';
 			if (word[i] == L'´' && i > 0)
 				word[i] = L'`';
-			if (rand () % 5 || word[i] == L'-' || word[i] == L'\\')
+			if (rnd_int (rnd, 5) || word[i] == L'-' || word[i] == L'\\')
 			{	/* space after symbol ==> end of word (most often) */
 				word[i + 1] = L'\0';
 				return;
@@ -147,21 +193,19 @@ adapt_create_word (gunichar word[MAX_WORD_LEN + 1])
 		/* Avoid double diacritics */
 		if (i > 0)
 			if (keyb_is_diacritic (word[i - 1]) && keyb_is_diacritic (word[i]))
-				word[i] = vowels[rand () % vlen];
+				word[i] = kc->vowels[rnd_int (rnd, kc->n_vowels)];
 	}
 	/*
 	 * Last char
 	 */
-	if (rand () % 20)
-		word[n] = vowels[rand () % vlen];
+	if (rnd_int (rnd, 20))
+		word[n] = kc->vowels[rnd_int (rnd, kc->n_vowels)];
 	else
 	{
-		hlp = main_preferences_get_string ("interface", "language");
-		if (g_str_has_prefix (hlp, "ur"))
+		if (lang_flags.urdu)
 			word[n] = URDU_COMMA;
-		else if (trans_lang_has_stopmark ())
+		else if (lang_flags.stopmark)
 			word[n] = L',';
-		g_free (hlp);
 	}
 
 	/*
@@ -174,24 +218,24 @@ adapt_create_word (gunichar word[MAX_WORD_LEN + 1])
  * Creates a random number
  */
 void
-adapt_create_number (gunichar ucs4_word[MAX_WORD_LEN + 1])
+adapt_create_number (gunichar ucs4_word[MAX_WORD_LEN + 1], Rnd *rnd)
 {
 	gint i;
-	gint alen;
 	gboolean arabic;
 	const gchar digits[11] = "0123456789";
-	gunichar altnums[30];
+	const KeybClasses *kc;
+
+	kc = keyb_get_classes ();
 
 	arabic = TRUE;
-	alen = keyb_get_altnums (altnums);
-	if (alen > 5)
-		arabic = rand () % 7 ? FALSE : TRUE;
+	if (kc->n_altnums > 5)
+		arabic = rnd_int (rnd, 7) ? FALSE : TRUE;
 	for (i = 0; i < 4; i++)
 	{
 		if (arabic)
-			ucs4_word[i] = digits[rand () % 10];
+			ucs4_word[i] = digits[rnd_int (rnd, 10)];
 		else
-			ucs4_word[i] = altnums[rand () % alen];
+			ucs4_word[i] = kc->altnums[rnd_int (rnd, kc->n_altnums)];
 	}
 	ucs4_word[4] = L'\0';
 }
@@ -14,10 +14,12 @@
 #define WORDS 22
 #define MAX_WORD_LEN 9
 
-void adapt_draw_random_pattern (void);
+gboolean adapt_get_special (void);
 
-void adapt_create_word (gunichar *);
+void adapt_create_random_pattern (GString *text, gboolean special, const gchar *lang, Rnd *rnd);
 
-void adapt_create_number (gunichar *);
+void adapt_create_word (gunichar *, Rnd *);
+
+void adapt_create_number (gunichar *, Rnd *);
 
 void adapt_comment (gdouble accuracy);
@@ -51,18 +51,39 @@ get_win (gchar *name)
 	return (GTK_WINDOW (obj));
 }
 
-/* Set an image widget with the name of the file provided in the data dir
+/* Set an image widget with the name of the file provided in the data dir.
+ * The images are decoded only once, as the hints change at every touch.
  */
 void
 set_pixmap (gchar *widget, gchar *image)
 {
+	static GHashTable *pixbufs = NULL;
 	gchar *tmp;
 	GtkImage *img;
+	GdkPixbuf *pxb;
+	GError *error = NULL;
+
+	if (pixbufs == NULL)
+		pixbufs = g_hash_table_new (g_str_hash, g_str_equal);
 
-	tmp = g_build_filename (main_path_data (), image, NULL);
 	img = GTK_IMAGE (get_wg (widget));
-	gtk_image_set_from_file (img, tmp);
-	g_free (tmp);
+	if (!g_hash_table_lookup_extended (pixbufs, image, NULL, (gpointer *) &pxb))
+	{
+		tmp = g_build_filename (main_path_data (), image, NULL);
+		pxb = gdk_pixbuf_new_from_file (tmp, &error);
+		if (pxb == NULL)
+		{
+			g_message ("could not load the image %s: %s", tmp, error->message);
+			g_error_free (error);
+		}
+		g_free (tmp);
+		g_hash_table_insert (pixbufs, g_strdup (image), pxb);
+	}
+
+	if (pxb == NULL)
+		gtk_image_set_from_icon_name (img, "image-missing", GTK_ICON_SIZE_BUTTON);
+	else if (gtk_image_get_storage_type (img) != GTK_IMAGE_PIXBUF || gtk_image_get_pixbuf (img) != pxb)
+		gtk_image_set_from_pixbuf (img, pxb);
 }
 
 /* Search for the user directory and create it if not found
@@ -91,3 +112,96 @@ compare_string_function (gconstpointer a, gconstpointer b)
 {
 	return (strcasecmp (a, b));
 }
+
+/**********************************************************************
+ * Pseudo-random numbers
+ */
+static struct
+{
+	guint64 next;
+	gboolean set;
+} session_seed = { 0, FALSE };
+
+static guint64
+rnd_splitmix64 (guint64 *x)
+{
+	guint64 z;
+
+	z = (*x += G_GUINT64_CONSTANT (0x9e3779b97f4a7c15));
+	z = (z ^ (z >> 30)) * G_GUINT64_CONSTANT (0xbf58476d1ce4e5b9);
+	z = (z ^ (z >> 27)) * G_GUINT64_CONSTANT (0x94d049bb133111eb);
+	return (z ^ (z >> 31));
+}
+
+static inline guint64
+rnd_rotl (guint64 x, gint k)
+{
+	return ((x << k) | (x >> (64 - k)));
+}
+
+/* Expand a single seed into the whole state
+ */
+void
+rnd_seed (Rnd *rnd, guint64 seed)
+{
+	gint i;
+
+	for (i = 0; i < 4; i++)
+		rnd->s[i] = rnd_splitmix64 (&seed);
+}
+
+guint64
+rnd_next (Rnd *rnd)
+{
+	guint64 *s = rnd->s;
+	guint64 result;
+	guint64 t;
+
+	result = rnd_rotl (s[1] * 5, 7) * 9;
+	t = s[1] << 17;
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = rnd_rotl (s[3], 45);
+	return (result);
+}
+
+/* Uniform integer in [0, n), by multiplying instead of taking the modulus
+ */
+gint
+rnd_int (Rnd *rnd, gint n)
+{
+	if (n <= 0)
+		return (0);
+	return ((gint) (((rnd_next (rnd) >> 32) * (guint64) n) >> 32));
+}
+
+/* The seed given in the command line: the first exercise uses exactly it
+ */
+void
+rnd_set_session_seed (guint64 seed)
+{
+	session_seed.next = seed;
+	session_seed.set = TRUE;
+}
+
+/* Seed for a new exercise (main thread only)
+ */
+guint64
+rnd_new_seed ()
+{
+	guint64 seed;
+	guint64 x;
+
+	if (!session_seed.set)
+	{
+		session_seed.next = ((guint64) g_random_int () << 32) | g_random_int ();
+		session_seed.set = TRUE;
+	}
+	seed = session_seed.next;
+	x = seed;
+	session_seed.next = rnd_splitmix64 (&x);
+	return (seed);
+}
@@ -59,3 +59,21 @@ void assert_user_dir (void);
 /* Compare two strings, so that it applies to other sorting functions.
  */
 gint compare_string_function (gconstpointer a, gconstpointer b);
+
+/* Pseudo-random numbers for the exercises (xoshiro256**): every exercise
+ * is drawn from its own seed, so that it can be created again.
+ */
+typedef struct
+{
+	guint64 s[4];
+} Rnd;
+
+void rnd_seed (Rnd *rnd, guint64 seed);
+
+guint64 rnd_next (Rnd *rnd);
+
+gint rnd_int (Rnd *rnd, gint n);
+
+void rnd_set_session_seed (guint64 seed);
+
+guint64 rnd_new_seed (void);
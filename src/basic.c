@@ -31,7 +31,7 @@
 struct
 {
 	gint lesson;
-	gunichar char_set[MAX_BASIC_CHAR_SET];
+	gunichar char_set[MAX_BASIC_CHAR_SET + 1];
 	glong char_set_size;
 	gboolean lesson_increased;
 } basic;
@@ -91,17 +91,89 @@ basic_init ()
 }
 
 /**********************************************************************
- * Read the characters to be used with the current basic.lesson
+ * The standard lessons, parsed only once from basic_lessons.txt into key
+ * masks: bit j of lo[i] (up[i]) tells if the key at row i, column j of
+ * the lower (upper) level belongs to the lesson. They don't depend on the
+ * keyboard layout, which is only looked up when building the char set.
+ * Custom lessons are cached as their char sets, until they are saved again.
+ */
+static struct
+{
+	gint n;
+	struct
+	{
+		guint16 lo[4];
+		guint16 up[4];
+	} mask[MAX_BASIC_LESSONS + 1];
+	struct
+	{
+		gunichar *char_set;
+		glong size;
+	} custom[MAX_BASIC_LESSONS + 1];
+} lessons = { -1 };
+
+static guint16
+basic_parse_mask_line (gchar *line)
+{
+	gint j;
+	guint16 mask = 0;
+
+	for (j = 0; j < 14 && line[j] != '\0'; j++)
+		if (line[j] == '1')
+			mask |= 1 << j;
+	return (mask);
+}
+
+static void
+basic_load_lessons ()
+{
+	gint i, n;
+	gchar **line;
+	gchar *lesson_file;
+	gchar *contents;
+
+	lesson_file = g_build_filename (main_path_data (), "basic_lessons.txt", NULL);
+	if (!g_file_get_contents (lesson_file, &contents, NULL, NULL))
+		g_error ("couldn't find the basic lessons' file.");
+	g_free (lesson_file);
+
+	/* Each lesson takes 11 lines: heading, 4 masks of the lower level,
+	 * blank line, 4 masks of the upper level, blank line
+	 */
+	line = g_strsplit (contents, "\n", -1);
+	g_free (contents);
+	for (n = 0; n < MAX_BASIC_LESSONS; n++)
+	{
+		for (i = 0; i < 10; i++)
+			if (line[11 * n + i] == NULL)
+				break;
+		if (i < 10)
+			break;
+		for (i = 0; i < 4; i++)
+		{
+			lessons.mask[n + 1].lo[i] = basic_parse_mask_line (line[11 * n + 1 + i]);
+			lessons.mask[n + 1].up[i] = basic_parse_mask_line (line[11 * n + 6 + i]);
+		}
+		if (line[11 * n + 10] == NULL)
+		{
+			n++;
+			break;
+		}
+	}
+	g_strfreev (line);
+	lessons.n = n;
+}
+
+/**********************************************************************
+ * Set the characters to be used with the current basic.lesson
  */
 gint
 basic_init_char_set ()
 {
 	gint i, j, k;
-	gchar line_str[16];
 	gchar *lesson_file;
 	gchar *lesson_str;
 	gunichar *tmpuc;
-	FILE *fh;
 	GtkWidget *wg;
 
 	/*
@@ -110,29 +182,43 @@ basic_init_char_set ()
 	wg = get_wg ("togglebutton_edit_basic_lesson");
 	if (basic.lesson > 43 && basic.lesson <= MAX_BASIC_LESSONS)
 	{
-		lesson_file = g_strdup_printf ("%s" G_DIR_SEPARATOR_S "basic_lesson_%i.txt",
-			       	main_path_user (), basic.lesson);
-		if (g_file_get_contents (lesson_file, &lesson_str, NULL, NULL))
+		if (lessons.custom[basic.lesson].char_set == NULL)
 		{
-			tmpuc = g_utf8_to_ucs4_fast (lesson_str, -1, &basic.char_set_size);
-			if (basic.char_set_size > MAX_BASIC_CHAR_SET)
-				basic.char_set_size = MAX_BASIC_CHAR_SET;
-			for (i = j = 0; i < basic.char_set_size; i++)
-				if (g_unichar_isgraph (tmpuc[i]))
-					basic.char_set[j++] = tmpuc[i];
-			basic.char_set[j] = L'\0';
-			basic.char_set_size = j;
-			g_free (tmpuc);
-			g_free (lesson_str);
+			lesson_file = g_strdup_printf ("%s" G_DIR_SEPARATOR_S "basic_lesson_%i.txt",
+					main_path_user (), basic.lesson);
+			if (g_file_get_contents (lesson_file, &lesson_str, NULL, NULL))
+			{
+				tmpuc = g_utf8_to_ucs4_fast (lesson_str, -1, &basic.char_set_size);
+				if (basic.char_set_size > MAX_BASIC_CHAR_SET)
+					basic.char_set_size = MAX_BASIC_CHAR_SET;
+				for (i = j = 0; i < basic.char_set_size; i++)
+					if (g_unichar_isgraph (tmpuc[i]))
+						basic.char_set[j++] = tmpuc[i];
+				basic.char_set[j] = L'\0';
+				basic.char_set_size = j;
+				g_free (tmpuc);
+				g_free (lesson_str);
+			}
+			else
+			{
+				basic.char_set[0] = L' ';
+				basic.char_set[1] = L' ';
+				basic.char_set[2] = L'\0';
+				basic.char_set_size = 2;
+			}
+			g_free (lesson_file);
+
+			lessons.custom[basic.lesson].size = basic.char_set_size;
+			lessons.custom[basic.lesson].char_set = g_new (gunichar, basic.char_set_size + 1);
+			memcpy (lessons.custom[basic.lesson].char_set, basic.char_set,
+					(basic.char_set_size + 1) * sizeof (gunichar));
 		}
 		else
 		{
-			basic.char_set[0] = L' ';
-			basic.char_set[1] = L' ';
-			basic.char_set[2] = L'\0';
-			basic.char_set_size = 2;
+			basic.char_set_size = lessons.custom[basic.lesson].size;
+			memcpy (basic.char_set, lessons.custom[basic.lesson].char_set,
+					(basic.char_set_size + 1) * sizeof (gunichar));
 		}
-		g_free (lesson_file);
 
 		gtk_widget_set_sensitive (wg, TRUE);
 		return (-1);
@@ -140,80 +226,27 @@ basic_init_char_set ()
 	gtk_widget_set_sensitive (wg, FALSE);
 
 	/*
-	 * Open the lesson file
+	 * Standard lessons
 	 */
-	lesson_file = g_build_filename (main_path_data (), "basic_lessons.txt", NULL);
-	fh = (FILE *) g_fopen (lesson_file, "r");
-	g_free (lesson_file);
-	if (!fh)
-		g_error ("couldn't find the basic lessons' file.");
+	if (lessons.n < 0)
+		basic_load_lessons ();
 
-	/*
-	 * Search the lesson
-	 */
-	for (i = 1; i < basic.lesson; i++)
-		for (j = 0; j < 11; j++)
-			if (!(fgets (line_str, 16, fh)))
-				break;
-
-	/*
-	 * Pass heading line
-	 */
-	if (!(fgets (line_str, 16, fh)))
+	if (basic.lesson < 1 || basic.lesson > lessons.n)
 	{
 		basic.char_set[0] = L'\0';
 		basic.char_set_size = 0;
-		fclose (fh);
 		return (-1);
 	}
 
-	/*
-	 * Get chars, lower set
-	 */
 	for (k = 0, i = 0; i < 4; i++)
-	{
-		if (!(fgets (line_str, 16, fh)))
-		{
-			basic.char_set[0] = L'\0';
-			basic.char_set_size = 0;
-			fclose (fh);
-			return (-1);
-		}
 		for (j = 0; j < 14; j++)
-		{
-			if (line_str[j] == '1' && g_unichar_isgraph (keyb_get_lochars (i, j)))
+			if ((lessons.mask[basic.lesson].lo[i] & (1 << j)) && g_unichar_isgraph (keyb_get_lochars (i, j)))
 				basic.char_set[k++] = g_unichar_tolower (keyb_get_lochars (i, j));
-		}
-	}
 
-	/*
-	 * Pass blank line
-	 */
-	if (!(fgets (line_str, 16, fh)))
-	{
-		basic.char_set[0] = L'\0';
-		basic.char_set_size = 0;
-		fclose (fh);
-		return (-1);
-	}
-
-	/*
-	 * Get chars, upper set
-	 */
 	for (i = 0; i < 4; i++)
-	{
-		if (!(fgets (line_str, 16, fh)))
-		{
-			basic.char_set[0] = L'\0';
-			basic.char_set_size = 0;
-			fclose (fh);
-			return (-1);
-		}
 		for (j = 0; j < 14; j++)
-			if (line_str[j] == '1' && g_unichar_isgraph (keyb_get_upchars (i, j)))
+			if ((lessons.mask[basic.lesson].up[i] & (1 << j)) && g_unichar_isgraph (keyb_get_upchars (i, j)))
 				basic.char_set[k++] = g_unichar_tolower (keyb_get_upchars (i, j));
-	}
-	fclose (fh);
 
 	basic.char_set[k] = L'\0';
 	basic.char_set_size = k;
@@ -230,6 +263,12 @@ basic_save_lesson (gchar * charset)
 	gchar *lesson_file;
 	FILE *fh;
 
+	if (basic.lesson <= MAX_BASIC_LESSONS)
+	{
+		g_free (lessons.custom[basic.lesson].char_set);
+		lessons.custom[basic.lesson].char_set = NULL;
+	}
+
 	lesson_file = g_strdup_printf ("%s" G_DIR_SEPARATOR_S "basic_lesson_%i.txt", main_path_user (), basic.lesson);
 	fh = (FILE *) g_fopen (lesson_file, "w");
 	if (fh == NULL)
@@ -245,22 +284,21 @@ basic_save_lesson (gchar * charset)
 }
 
 /**********************************************************************
- * Put the lesson's characters at the main screen
+ * Append the lesson's characters to 'text', drawn from a copy of the
+ * character set: it doesn't touch any widget, so that the next exercise
+ * may be prepared off the main loop (see tutor_prefetch_start).
  */
 #define N_LINES 8
 void
-basic_draw_lesson ()
+basic_create_lesson (GString *text, const gunichar *char_set, gint char_set_size, Rnd *rnd)
 {
 	gint i, j, k, len;
-	gint idx, rnd;
+	gint idx, pick;
 	gchar *ut8_tmp;
 	gunichar sentence[9 * 6 + 4];
 	gunichar char_pool[N_LINES * 9 * 5];
-	GtkTextBuffer *buf;
-
-	buf = gtk_text_view_get_buffer (GTK_TEXT_VIEW (get_wg ("text_tutor")));
 
-	len = basic.char_set_size;
+	len = char_set_size;
 	if (len < 2)
 	{
 		g_warning ("no character set for this lesson.");
@@ -270,7 +308,7 @@ basic_draw_lesson ()
 	/*
 	 * Draw the lines as sentences
 	 */
-	memmove (char_pool, basic.char_set, len * sizeof (gunichar));
+	memmove (char_pool, char_set, len * sizeof (gunichar));
 	sentence[9 * 6] = L'\n';
 	sentence[9 * 6 + 1] = L'\0';
 	sentence[9 * 6 + 2] = L'\0';
@@ -281,13 +319,13 @@ basic_draw_lesson ()
 		{		/* words */
 			for (k = 0; k < 5; k++)
 			{	/* letters */
-				rnd = rand () % len;
-				sentence[idx++] = char_pool[rnd];
-				char_pool[rnd] = char_pool[--len];
+				pick = rnd_int (rnd, len);
+				sentence[idx++] = char_pool[pick];
+				char_pool[pick] = char_pool[--len];
 				if (len == 0)
 				{
-					len = basic.char_set_size;
-					memmove (char_pool, basic.char_set, len * sizeof (gunichar));
+					len = char_set_size;
+					memmove (char_pool, char_set, len * sizeof (gunichar));
 				}
 				if (keyb_is_diacritic (sentence[idx-1]))
 					sentence[idx-1] = L' ';
@@ -295,7 +333,7 @@ basic_draw_lesson ()
 			sentence[idx++] = (j < 8) ? L' ' : UPSYM;
 		}
 		ut8_tmp = g_ucs4_to_utf8 (sentence, -1, NULL, NULL, NULL);
-		gtk_text_buffer_insert_at_cursor (buf, ut8_tmp, -1);
+		g_string_append (text, ut8_tmp);
 		g_free (ut8_tmp);
 		if (len == 2 && i >= N_LINES/2-1)
 			break;
@@ -34,6 +34,6 @@ gint basic_init_char_set (void);
 
 void basic_save_lesson (gchar * charset);
 
-void basic_draw_lesson (void);
+void basic_create_lesson (GString *text, const gunichar *char_set, gint char_set_size, Rnd *rnd);
 
 void basic_comment (gdouble accuracy);
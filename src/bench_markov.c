@@ -0,0 +1,102 @@
+/*****************************************************************************/
+/*  Klavaro - a flexible touch typing tutor                                  */
+/*  Copyright (C) 2005, 2006, 2007, 2008 Felipe Castro                       */
+/*  Copyright (C) 2009, 2010, 2011, 2012, 2013 The Free Software Foundation  */
+/*                                                                           */
+/*  This program is free software, licensed under the terms of the GNU       */
+/*  General Public License as published by the Free Software Foundation,     */
+/*  either version 3 of the License, or (at your option) any later version.  */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
+/*****************************************************************************/
+
+/*
+ * Benchmark of the pseudo-words: trains the model of each language on its
+ * bundled dictionary (data/xx.words) and reports the training time and how
+ * many words per second markov_walk makes.
+ *
+ *   make bench_markov && ./bench_markov [words per language] [lang ...]
+ */
+#include <stdlib.h>
+#include <glib.h>
+#include <glib/gprintf.h>
+
+#include "markov.c"
+
+#define BENCH_WORDS 1000000	/* walked per language */
+
+/* What markov.c and auxiliar.c take from the rest of the program
+ */
+GtkBuilder *gui = NULL;
+
+gchar *
+main_path_data ()
+{
+	return (BENCH_DATA_DIR);
+}
+
+gchar *
+main_path_user ()
+{
+	return (".");
+}
+
+gchar *
+trans_lang_get_similar_file_name (const gchar * file_end)
+{
+	return (g_strconcat (BENCH_DATA_DIR, G_DIR_SEPARATOR_S, "C", file_end, NULL));
+}
+
+gboolean
+keyb_is_inset (gunichar chr)
+{
+	return (TRUE);
+}
+
+int
+main (int argc, char *argv[])
+{
+	static const gchar *default_langs[] = { "C", "de", "es", "fr", "ru", "vi", NULL };
+	const gchar **langs;
+	gint i;
+	gint n, total;
+	gint n_words = BENCH_WORDS;
+	gdouble train_secs, walk_secs;
+	gunichar word[MARKOV_MAX_LEN + 1];
+	GTimer *tmr;
+	Rnd rnd;
+	Markov *mk;
+
+	if (argc > 1)
+		n_words = MAX (atoi (argv[1]), 1);
+	langs = argc > 2 ? (const gchar **) argv + 2 : default_langs;
+
+	g_printf ("%-6s %5s %7s %7s %9s %12s %7s\n",
+		  "lang", "order", "states", "trans", "train ms", "words/s", "length");
+	tmr = g_timer_new ();
+	for (i = 0; langs[i]; i++)
+	{
+		g_timer_start (tmr);
+		mk = markov_train (langs[i]);
+		train_secs = g_timer_elapsed (tmr, NULL);
+		if (mk == NULL)
+		{
+			g_printf ("%-6s no model\n", langs[i]);
+			continue;
+		}
+
+		rnd_seed (&rnd, 0);
+		total = 0;
+		g_timer_start (tmr);
+		for (n = 0; n < n_words; n++)
+			total += MAX (markov_walk (mk, word, MARKOV_MAX_LEN, &rnd), 0);
+		walk_secs = g_timer_elapsed (tmr, NULL);
+
+		g_printf ("%-6s %5i %7i %7i %9.1f %12.0f %7.2f\n", langs[i], mk->order,
+			  mk->n_states, mk->n_trans, 1000 * train_secs,
+			  n_words / MAX (walk_secs, 1e-9), (gdouble) total / n_words);
+	}
+	g_timer_destroy (tmr);
+
+	return (0);
+}
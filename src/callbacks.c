@@ -27,6 +27,7 @@
 #include "tutor.h"
 #include "cursor.h"
 #include "plot.h"
+#include "stats.h"
 #include "basic.h"
 #include "velocity.h"
 #include "fluidness.h"
@@ -149,6 +150,7 @@ on_combobox_kbd_country_changed (GtkComboBox *cmb, gpointer user_data)
 {
 	if (callbacks_shield)
 		return;
+	tutor_prefetch_discard ();
 	if (keyb_get_name ()) accur_close ();
 	keyb_set_combo_kbd_variant ("combobox_kbd_country", "combobox_kbd_variant");
 	accur_init ();
@@ -172,6 +174,7 @@ on_combobox_kbd_variant_changed (GtkComboBox *cmb, gpointer user_data)
 		keyb_mode_edit ();
 	else
 	{
+		tutor_prefetch_discard ();
 		if (keyb_get_name ()) accur_close ();
 		keyb_update_from_variant ("combobox_kbd_country", "combobox_kbd_variant");
 		accur_init ();
@@ -831,6 +834,7 @@ on_button_top10_noexpand_clicked (GtkButton * button, gpointer user_data)
 G_MODULE_EXPORT void
 on_button_top10_close_clicked (GtkButton * button, gpointer user_data)
 {
+	top10_transfer_cancel (FALSE);
 	top10_message (NULL);
 	window_save ("top10");
 	gtk_widget_hide (get_wg ("window_top10"));
@@ -1107,7 +1111,6 @@ on_dialog_confirm_show (GtkWidget * widget, gpointer user_data)
 G_MODULE_EXPORT void
 on_button_confirm_yes_clicked (GtkButton * button, gpointer user_data)
 {
-	gchar *file;
 	gchar *action;
 	GtkWidget *wg;
 
@@ -1129,21 +1132,8 @@ on_button_confirm_yes_clicked (GtkButton * button, gpointer user_data)
 
 	else if (g_str_equal (action, "RESET"))
 	{
-		file = g_build_filename (main_path_stats (), "stat_basic.txt", NULL);
-		g_unlink (file);
-		g_free (file);
-		file = g_build_filename (main_path_stats (), "stat_adapt.txt", NULL);
-		g_unlink (file);
-		g_free (file);
-		file = g_build_filename (main_path_stats (), "stat_velo.txt", NULL);
-		g_unlink (file);
-		g_free (file);
-		file = g_build_filename (main_path_stats (), "stat_fluid.txt", NULL);
-		g_unlink (file);
-		g_free (file);
-		file = g_build_filename (main_path_stats (), "scores_fluid.txt", NULL);
-		g_unlink (file);
-		g_free (file);
+		tutor_prefetch_discard ();
+		stats_reset ();
 		accur_reset ();
 
 		basic_set_lesson (1);
@@ -1310,6 +1300,15 @@ on_combobox_stat_type_changed (GtkComboBox *cmb, gpointer user_data)
 		plot_draw_chart (active + 1);
 }
 
+G_MODULE_EXPORT void
+on_combobox_stat_aver_changed (GtkComboBox *cmb, gpointer user_data)
+{
+	if (callbacks_shield)
+		return;
+
+	on_combobox_stat_type_changed (NULL, NULL);
+}
+
 G_MODULE_EXPORT void
 on_spinbutton_stat_lesson_value_changed (GtkSpinButton * spinbutton, gpointer user_data)
 {
@@ -1342,6 +1341,29 @@ on_databox_hovered (GtkDatabox *dbox, GdkEventMotion *event, gpointer user_data)
 	plot_pointer_update (event->x);
 }
 
+G_MODULE_EXPORT void
+on_databox_zoomed (GtkDatabox *dbox, gpointer user_data)
+{
+	plot_zoom_update ();
+}
+
+G_MODULE_EXPORT void
+on_databox_size_allocate (GtkWidget *wg, GdkRectangle *alloc, gpointer user_data)
+{
+	static gint width = 0;
+
+	if (alloc->width == width)
+		return;
+	width = alloc->width;
+	plot_zoom_update ();
+}
+
+G_MODULE_EXPORT void
+on_databox_scrolled (GtkAdjustment *adj, gpointer user_data)
+{
+	plot_zoom_update ();
+}
+
 /**********************************************************************
  * 7 - Other texts popup
  **********************************************************************/
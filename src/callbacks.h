@@ -54,12 +54,20 @@ void on_combobox_stat_module_changed (GtkComboBox *cmb, gpointer user_data);
 
 void on_combobox_stat_type_changed (GtkComboBox *cmb, gpointer user_data);
 
+void on_combobox_stat_aver_changed (GtkComboBox *cmb, gpointer user_data);
+
 void on_button_confirm_yes_clicked (GtkButton *button, gpointer user_data);
 
 void on_button_other_apply_clicked (GtkButton *button, gpointer user_data);
 
 void on_databox_hovered (GtkDatabox *dbox, GdkEventMotion *event, gpointer user_data);
 
+void on_databox_zoomed (GtkDatabox *dbox, gpointer user_data);
+
+void on_databox_size_allocate (GtkWidget *wg, GdkRectangle *alloc, gpointer user_data);
+
+void on_databox_scrolled (GtkAdjustment *adj, gpointer user_data);
+
 
 void window_restore (gchar *who);
 
@@ -52,6 +52,7 @@ fluid_get_paragraph_name ()
 void
 fluid_reset_paragraph ()
 {
+	tutor_prefetch_discard ();
 	g_free (par.buffer);
 	par.buffer = NULL;
 	par.len = 0;
@@ -64,6 +65,15 @@ fluid_reset_paragraph ()
  */
 gchar *
 get_par (gint index)
+{
+	return (fluid_get_par (index, main_preferences_get_boolean ("tutor", "double_spaces")));
+}
+
+/* Same as above, with the 'double_spaces' preference given by the caller,
+ * so that the preferences aren't touched off the main loop.
+ */
+gchar *
+fluid_get_par (gint index, gboolean double_spaces)
 {
 	gint i;
 	gint size;
@@ -101,7 +111,7 @@ get_par (gint index)
 		par_i[size] = '\0';
 		//g_message ("Paragraph %i: %i stops", index, stops);
 
-		if (main_preferences_get_boolean ("tutor", "double_spaces"))
+		if (double_spaces)
 		{
 			for (i = 0; i < size - 1; i++)
 			{
@@ -175,6 +185,7 @@ fluid_init_paragraph_list (gchar * list_name)
 	gchar str_9000[9001];
 	FILE *fh;
 
+	tutor_prefetch_discard ();
 	if (list_name && !g_str_equal (list_name, OTHER_DEFAULT))
 	{
 		main_preferences_set_string ("tutor", "paragraph_list", list_name);
@@ -242,24 +253,17 @@ fluid_init_paragraph_list (gchar * list_name)
 }
 
 /**********************************************************************
- * Draw random sentences selected from a '.paragraphs' file
+ * Append to 'text' random sentences selected from a '.paragraphs' file.
+ * 'par_num' is the number of paragraphs, 0 meaning all the text.
+ * The paragraphs aren't changed here, so it may run off the main loop.
  */
+#define FLUID_PARBUF 50
 void
-fluid_draw_random_paragraphs ()
+fluid_create_random_paragraphs (GString *text, gint par_num, gboolean double_spaces, Rnd *rnd)
 {
 	gint i, j;
-	gint par_num;
 	gint rand_i[10];
-#	define FLUID_PARBUF 50
-	static gchar *text[FLUID_PARBUF] = {
-		NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, 
-		NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
-		NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
-		NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
-		NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL
-	};
-
-	par_num = main_preferences_get_int ("tutor", "fluid_paragraphs");
+	gchar *par_i;
 
 	/* Use all the text, without mangling it
 	 */
@@ -267,27 +271,22 @@ fluid_draw_random_paragraphs ()
 	{
 		par_num = par.len > FLUID_PARBUF ? FLUID_PARBUF : par.len;
 
-		for (i = 0; i < par_num; i++)
-			g_free (text[i]);
-
 		for (i = 0; i < par_num; i++)
 		{
-			text[i] = get_par (i);
-			tutor_draw_paragraph (text[i]);
+			par_i = fluid_get_par (i, double_spaces);
+			tutor_format_paragraph (text, par_i);
+			g_free (par_i);
 		}
 		return;
 	}
 
 	/* Use some paragraphs, pseudo-randomly
 	 */
-	for (i = 0; (i < par_num) && (i < par.len); i++)
-		g_free (text[i]);
-
 	for (i = 0; (i < par_num) && (i < par.len); i++)
 	{
 		do
 		{
-			rand_i[i] = rand () % par.len;
+			rand_i[i] = rnd_int (rnd, par.len);
 			for (j = 0; j < i; j++)
 			{
 				if (rand_i[i] == rand_i[j])
@@ -296,8 +295,9 @@ fluid_draw_random_paragraphs ()
 		}
 		while (rand_i[i] == par.len);
 
-		text[i] = get_par (rand_i[i]);
-		tutor_draw_paragraph (text[i]);
+		par_i = fluid_get_par (rand_i[i], double_spaces);
+		tutor_format_paragraph (text, par_i);
+		g_free (par_i);
 	}
 }
 
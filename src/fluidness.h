@@ -22,6 +22,8 @@ void fluid_reset_paragraph (void);
 
 gchar *get_par (gint index);
 
+gchar *fluid_get_par (gint index, gboolean double_spaces);
+
 /*
  * Auxiliar functions
  */
@@ -29,7 +31,7 @@ void fluid_init (void);
 
 void fluid_init_paragraph_list (gchar * list_name);
 
-void fluid_draw_random_paragraphs (void);
+void fluid_create_random_paragraphs (GString *text, gint par_num, gboolean double_spaces, Rnd *rnd);
 
 gchar *fluid_filter_utf8 (gchar * text);
 
@@ -24,6 +24,7 @@
 #include "main.h"
 #include "callbacks.h"
 #include "translation.h"
+#include "tutor.h"
 #include "keyboard.h"
 
 #define KEY_DX 35
@@ -49,6 +50,9 @@ static struct
 	} pos;
 	gint cmb_n;
 	gint intro_step;
+	KeybClasses classes;
+	gboolean classes_ok;
+	KeybModel model;	/* the whole layout, lochars & upchars being its 4x14 view */
 } keyb;
 static guint x0[4] = {0, 49, 59, 43};
 
@@ -58,7 +62,22 @@ static struct
 	gint n_orig;
 	KeybLayout *cust; // Custom layouts created by the user
 	gint n_cust;
-} layouts;
+	gint64 user_mtime; // Of the user folder, when the custom ones were listed
+} layouts = { NULL, 0, NULL, 0, -1 };
+
+/* Reverse lookup, from character to key: open addressing table, with
+ * room for more than twice all the characters of the layout
+ */
+static struct
+{
+	gint bits;
+	gint size;
+	gunichar *chr;	/* 0 means empty slot */
+	KeybPos *pos;
+} keymap = { 0, 0, NULL, NULL };
+
+static gchar hints[4][KEY_LINE_LEN + 1];
+static gboolean hints_is_initialized = FALSE;
 
 /* Constants
  */
@@ -280,66 +299,448 @@ keyb_create_virtual_keys ()
 }
 
 /**********************************************************************
- * Read the character sets (keyb.lochars[] & keyb.upchars[])
- * for the keyboard currently selected.
+ * Layout model
  */
-void
-keyb_set_chars ()
+
+/* Key of the layout, or a blank one if out of it
+ */
+gunichar
+keyb_model_get (const KeybModel *km, gint level, gint row, gint col)
 {
-	gint i;
-	gchar *tmp_name = NULL;
-	gchar tmp_str[6 * KEY_LINE_LEN + 1];
+	if (level >= km->n_levels || row >= km->n_rows || col >= km->row_start[row + 1] - km->row_start[row])
+		return (L' ');
+	return (km->chars[level * km->n_keys + km->row_start[row] + col]);
+}
+
+static void
+keyb_model_set (KeybModel *km, gint level, gint row, gint col, gunichar chr)
+{
+	if (level >= km->n_levels || row >= km->n_rows || col >= km->row_start[row + 1] - km->row_start[row])
+		return;
+	km->chars[level * km->n_keys + km->row_start[row] + col] = chr;
+}
+
+static void
+keyb_model_free (KeybModel *km)
+{
+	g_free (km->row_start);
+	g_free (km->chars);
+	km->row_start = NULL;
+	km->chars = NULL;
+	km->n_rows = km->n_levels = km->n_keys = 0;
+}
+
+const KeybModel *
+keyb_get_model ()
+{
+	return (&keyb.model);
+}
+
+/* Build a model from the lines of a .kbd file: either the classic one
+ * (8 lines, 4 rows of 14 keys, without and with shift) or one beginning
+ * with the header line "klavaro-layout ROWS LEVELS", followed by the rows
+ * of each level, of any length.
+ */
+static gboolean
+keyb_model_parse (KeybModel *km, gchar **rows)
+{
+	gint r, l, k;
+	gint first;
+	gint len;
 	glong n_itens;
+	guint n_lines;
 	gunichar *uchs;
-	FILE *fh;
 
-	/* Search at home
-	 */
-	tmp_name = g_strconcat (main_path_user (), G_DIR_SEPARATOR_S, keyb.name, ".kbd", NULL);
-	fh = (FILE *) g_fopen (tmp_name, "r");
-	if (fh == NULL)
+	n_lines = g_strv_length (rows);
+	if (n_lines > 0 && g_str_has_prefix (rows[0], KEYB_HEADER " "))
 	{
-		/* Search at data
-		 */
-		g_free (tmp_name);
-		tmp_name = g_strconcat (main_path_data (), G_DIR_SEPARATOR_S, keyb.name, ".kbd", NULL);
-		fh = (FILE *) g_fopen (tmp_name, "r");
+		if (sscanf (rows[0] + strlen (KEYB_HEADER), "%i %i", &km->n_rows, &km->n_levels) != 2
+			|| km->n_rows < 1 || km->n_levels < 1
+			|| n_lines < 1 + (guint) (km->n_rows * km->n_levels))
+		{
+			g_message ("invalid keyboard layout header: %s", keyb.name);
+			return (FALSE);
+		}
+		km->classic = FALSE;
+		first = 1;
+	}
+	else
+	{
+		if (n_lines < KEYB_ROWS)
+		{
+			g_message ("incomplete keyboard layout: %s", keyb.name);
+			return (FALSE);
+		}
+		km->n_rows = 4;
+		km->n_levels = 2;
+		km->classic = TRUE;
+		first = 0;
 	}
-	g_free (tmp_name);
 
-	/* Success */
-	if (fh)
+	/* Index of the rows: each one as long as its longest level
+	 */
+	km->row_start = g_new (gint, km->n_rows + 1);
+	km->row_start[0] = 0;
+	for (r = 0; r < km->n_rows; r++)
 	{
-		for (i = 0; i < 4; i++)
+		len = km->classic ? KEY_LINE_LEN - 1 : 0;
+		for (l = 0; l < km->n_levels && !km->classic; l++)
+			len = MAX (len, g_utf8_strlen (rows[first + l * km->n_rows + r], -1));
+		km->row_start[r + 1] = km->row_start[r] + len;
+	}
+	km->n_keys = km->row_start[km->n_rows];
+
+	km->chars = g_new (gunichar, km->n_levels * km->n_keys);
+	for (l = 0; l < km->n_levels; l++)
+		for (r = 0; r < km->n_rows; r++)
 		{
-			tmp_name = fgets (tmp_str, 6 * KEY_LINE_LEN + 1, fh);
-			tmp_str[6 * KEY_LINE_LEN] = '\0';
-			uchs = g_utf8_to_ucs4_fast (tmp_str, -1, &n_itens);
-			if (n_itens > KEY_LINE_LEN)
+			uchs = g_utf8_to_ucs4_fast (rows[first + l * km->n_rows + r], -1, &n_itens);
+			len = km->row_start[r + 1] - km->row_start[r];
+			if (n_itens > len)
 				g_error ("invalid keyboard layout: %s\n"
 					 "invalid line: %i\n"
-					 "invalid number of chars: %li", keyb.name, i + 1, n_itens);
-			memcpy (keyb.lochars[i], uchs, (n_itens - 1) * sizeof (gunichar));
+					 "invalid number of chars: %li", keyb.name, first + l * km->n_rows + r + 1, n_itens);
+			for (k = 0; k < len; k++)
+				km->chars[l * km->n_keys + km->row_start[r] + k] = k < n_itens ? uchs[k] : L' ';
 			g_free (uchs);
-			for (; n_itens < KEY_LINE_LEN; n_itens++)
-				keyb.lochars[i][n_itens] = L' ';
 		}
-		for (i = 0; i < 4; i++)
+	return (TRUE);
+}
+
+/* Fill the classic 4x14 view of the two first levels, which is what the
+ * virtual keyboard, the hints and the basic lessons work on
+ */
+static void
+keyb_model_to_classic ()
+{
+	gint i, j;
+
+	for (i = 0; i < 4; i++)
+	{
+		for (j = 0; j < KEY_LINE_LEN - 1; j++)
 		{
-			tmp_name = fgets (tmp_str, 6 * KEY_LINE_LEN + 1, fh);
-			tmp_str[6 * KEY_LINE_LEN] = '\0';
-			uchs = g_utf8_to_ucs4_fast (tmp_str, -1, &n_itens);
-			if (n_itens > KEY_LINE_LEN)
-				g_error ("invalid keyboard layout: %s\n"
-					 "invalid line: %i\n"
-					 "invalid number of chars: %li", keyb.name, i + 5, n_itens);
-			memcpy (keyb.upchars[i], uchs, (n_itens - 1) * sizeof (gunichar));
-			g_free (uchs);
-			for (; n_itens < KEY_LINE_LEN; n_itens++)
-				keyb.upchars[i][n_itens] = L' ';
+			keyb.lochars[i][j] = keyb_model_get (&keyb.model, 0, i, j);
+			keyb.upchars[i][j] = keyb_model_get (&keyb.model, 1, i, j);
 		}
-		fclose (fh);
+		keyb.lochars[i][KEY_LINE_LEN - 1] = L'\0';
+		keyb.upchars[i][KEY_LINE_LEN - 1] = L'\0';
+	}
+}
+
+/**********************************************************************
+ * Reverse lookup table, rebuilt after any change of the character sets.
+ * The levels are taken in order, each one from the bottom row up: for
+ * duplicated characters, the first key wins.
+ */
+static guint
+keyb_map_slot (gunichar chr)
+{
+	return ((chr * 2654435761U) >> (32 - keymap.bits));
+}
+
+static void
+keyb_map_add (gunichar chr, gint row, gint col, gint level)
+{
+	guint k;
+
+	if (chr == 0)
+		return;
+	for (k = keyb_map_slot (chr); keymap.chr[k] != 0; k = (k + 1) & (keymap.size - 1))
+		if (keymap.chr[k] == chr)
+			return;
+	keymap.chr[k] = chr;
+	keymap.pos[k].row = row;
+	keymap.pos[k].col = col;
+	keymap.pos[k].level = level;
+	if (hints_is_initialized && row < 4 && col < KEY_LINE_LEN)
+		keymap.pos[k].finger = hints[row][col];
+	else
+		keymap.pos[k].finger = '0';
+}
+
+static void
+keyb_map_build ()
+{
+	gint bits;
+	gint l, r, k;
+	const KeybModel *km = &keyb.model;
+
+	for (bits = 8; (1 << bits) < 2 * km->n_levels * km->n_keys; bits++);
+	if (bits != keymap.bits)
+	{
+		g_free (keymap.chr);
+		g_free (keymap.pos);
+		keymap.bits = bits;
+		keymap.size = 1 << bits;
+		keymap.chr = g_new (gunichar, keymap.size);
+		keymap.pos = g_new (KeybPos, keymap.size);
+	}
+	memset (keymap.chr, 0, keymap.size * sizeof (gunichar));
+
+	for (l = 0; l < km->n_levels; l++)
+		for (r = km->n_rows - 1; r >= 0; r--)
+			for (k = 0; k < km->row_start[r + 1] - km->row_start[r]; k++)
+				keyb_map_add (km->chars[l * km->n_keys + km->row_start[r] + k], r, k, l);
+}
+
+/* Key of a character in the current layout, NULL if it has none
+ */
+const KeybPos *
+keyb_get_pos (gunichar chr)
+{
+	guint k;
+
+	if (chr == 0 || keymap.chr == NULL)
+		return (NULL);
+	for (k = keyb_map_slot (chr); keymap.chr[k] != 0; k = (k + 1) & (keymap.size - 1))
+		if (keymap.chr[k] == chr)
+			return (&keymap.pos[k]);
+	return (NULL);
+}
+
+/**********************************************************************
+ * Read the lines of a .kbd file (without the line ends), or NULL
+ */
+static gchar **
+keyb_read_rows (const gchar *path)
+{
+	gint i;
+	gsize len;
+	gchar *buf;
+	gchar **lines;
+
+	if (!g_file_get_contents (path, &buf, NULL, NULL))
+		return (NULL);
+	lines = g_strsplit (buf, "\n", -1);
+	g_free (buf);
+
+	for (i = 0; lines[i]; i++)
+	{
+		len = strlen (lines[i]);
+		if (len > 0 && lines[i][len - 1] == '\r')
+			lines[i][len - 1] = '\0';
+	}
+	if (i > 0 && lines[i - 1][0] == '\0')
+	{
+		g_free (lines[i - 1]);
+		lines[i - 1] = NULL;
+	}
+	return (lines);
+}
+
+/**********************************************************************
+ * Catalog of the original layouts: names, countries, variants and
+ * character sets, saved in the user folder so that the startup needn't
+ * open every .kbd file. It's rebuilt when the data folder changes.
+ * File format: a header line (version, data folder and its mtime), then for
+ * each layout a line "name<TAB>country<TAB>variant<TAB>N" and its N lines.
+ */
+#define CATALOG_FILE "layouts.cache"
+#define CATALOG_VERSION 2
+
+static gint64
+keyb_dir_mtime (const gchar *path)
+{
+	GStatBuf st;
+
+	if (g_stat (path, &st) != 0)
+		return (-1);
+	return ((gint64) st.st_mtime);
+}
+
+static gchar *
+keyb_catalog_header (gint64 mtime)
+{
+	return (g_strdup_printf ("%i\t%s\t%" G_GINT64_FORMAT, CATALOG_VERSION, main_path_data (), mtime));
+}
+
+static gboolean
+keyb_catalog_load (gint64 mtime)
+{
+	gint i, j, k, n, pass;
+	gchar *tmp;
+	gchar *buf;
+	gchar **lines;
+	gchar **fields;
+	guint n_lines;
+	guint line;
+	gboolean success;
+
+	tmp = g_build_filename (main_path_user (), CATALOG_FILE, NULL);
+	success = g_file_get_contents (tmp, &buf, NULL, NULL);
+	g_free (tmp);
+	if (!success)
+		return (FALSE);
+	lines = g_strsplit (buf, "\n", -1);
+	g_free (buf);
+
+	tmp = keyb_catalog_header (mtime);
+	n_lines = g_strv_length (lines);
+	success = n_lines >= 2 && g_str_equal (lines[0], tmp);
+	g_free (tmp);
+
+	/* First check the records, then take them
+	 */
+	n = 0;
+	for (pass = 0; success && pass < 2; pass++)
+	{
+		if (pass == 1)
+		{
+			layouts.n_orig = n;
+			layouts.orig = g_new (KeybLayout, n);
+		}
+		for (i = 0, line = 1; line < n_lines && lines[line][0] != '\0'; i++, line += k + 1)
+		{
+			fields = g_strsplit (lines[line], "\t", 4);
+			k = g_strv_length (fields) == 4 ? atoi (fields[3]) : 0;
+			if (k < 1 || line + k >= n_lines)
+			{
+				g_strfreev (fields);
+				success = FALSE;
+				break;
+			}
+			if (pass == 0)
+			{
+				g_strfreev (fields);
+				n++;
+				continue;
+			}
+			layouts.orig[i].name = fields[0];
+			layouts.orig[i].country = fields[1];
+			layouts.orig[i].variant = fields[2];
+			g_free (fields[3]);
+			g_free (fields);
+			layouts.orig[i].rows = g_new0 (gchar *, k + 1);
+			for (j = 0; j < k; j++)
+				layouts.orig[i].rows[j] = g_strdup (lines[line + 1 + j]);
+		}
+		success = success && n > 0;
+	}
+	g_strfreev (lines);
+	return (success);
+}
+
+static void
+keyb_catalog_build (gint64 mtime)
+{
+	gint i, k;
+	gchar *tmp;
+	GList *files, *l;
+	GString *cache;
+
+	files = keyb_get_layout_list_from_path (main_path_data ());
+	layouts.n_orig = g_list_length (files);
+	layouts.orig = g_new (KeybLayout, layouts.n_orig);
+
+	tmp = keyb_catalog_header (mtime);
+	cache = g_string_new (tmp);
+	g_string_append_c (cache, '\n');
+	g_free (tmp);
+	for (i = 0, l = files; l; i++, l = l->next)
+	{
+		layouts.orig[i].name = l->data;
+		layouts.orig[i].country = keyb_get_country (l->data);
+		layouts.orig[i].variant = keyb_get_variant (l->data);
+		tmp = g_strconcat (main_path_data (), G_DIR_SEPARATOR_S, l->data, ".kbd", NULL);
+		layouts.orig[i].rows = keyb_read_rows (tmp);
+		g_free (tmp);
+		if (layouts.orig[i].rows == NULL || layouts.orig[i].rows[0] == NULL)
+			continue;
+
+		g_string_append_printf (cache, "%s\t%s\t%s\t%u\n", layouts.orig[i].name,
+				layouts.orig[i].country, layouts.orig[i].variant,
+				g_strv_length (layouts.orig[i].rows));
+		for (k = 0; layouts.orig[i].rows[k]; k++)
+		{
+			g_string_append (cache, layouts.orig[i].rows[k]);
+			g_string_append_c (cache, '\n');
+		}
+	}
+	g_list_free (files);
+
+	assert_user_dir ();
+	tmp = g_build_filename (main_path_user (), CATALOG_FILE, NULL);
+	if (!g_file_set_contents (tmp, cache->str, cache->len, NULL))
+		g_message ("could not save the layout catalog:\n %s", tmp);
+	g_free (tmp);
+	g_string_free (cache, TRUE);
+}
+
+static void
+keyb_catalog_init ()
+{
+	gint64 mtime;
+
+	if (layouts.orig != NULL)
+		return;
+
+	mtime = keyb_dir_mtime (main_path_data ());
+	if (mtime < 0 || !keyb_catalog_load (mtime))
+		keyb_catalog_build (mtime);
+}
+
+static KeybLayout *
+keyb_catalog_find (const gchar *name)
+{
+	gint i;
+
+	keyb_catalog_init ();
+	for (i = 0; i < layouts.n_orig; i++)
+		if (g_str_equal (layouts.orig[i].name, name))
+			return (&layouts.orig[i]);
+	return (NULL);
+}
+
+/**********************************************************************
+ * Read the character sets (keyb.lochars[] & keyb.upchars[])
+ * for the keyboard currently selected.
+ */
+void
+keyb_set_chars ()
+{
+	gchar *tmp_name = NULL;
+	gchar **rows;
+	gboolean success = FALSE;
+	KeybLayout *orig;
+	KeybModel model;
+
+	tutor_prefetch_discard ();
+	keyb.classes_ok = FALSE;
+
+	/* Search at home
+	 */
+	tmp_name = g_strconcat (main_path_user (), G_DIR_SEPARATOR_S, keyb.name, ".kbd", NULL);
+	rows = keyb_read_rows (tmp_name);
+	g_free (tmp_name);
+
+	/* Search at data, through its catalog
+	 */
+	if (rows == NULL)
+	{
+		orig = keyb_catalog_find (keyb.name);
+		if (orig && orig->rows)
+			rows = g_strdupv (orig->rows);
+	}
+	if (rows == NULL)
+	{
+		tmp_name = g_strconcat (main_path_data (), G_DIR_SEPARATOR_S, keyb.name, ".kbd", NULL);
+		rows = keyb_read_rows (tmp_name);
+		g_free (tmp_name);
+	}
 
+	if (rows)
+	{
+		success = keyb_model_parse (&model, rows);
+		g_strfreev (rows);
+	}
+
+	/* Success */
+	if (success)
+	{
+		keyb_model_free (&keyb.model);
+		keyb.model = model;
+		keyb_model_to_classic ();
+		keyb_map_build ();
 		keyb_set_modified_status (FALSE);
 	}
 	/*
@@ -367,18 +768,7 @@ keyb_set_chars ()
  */
 gboolean keyb_is_inset (gunichar chr)
 {
-	register gint i, j;
-
-	for (i = 0; i < 4; i++)
-		for (j = 0; j <= KEY_LINE_LEN; j++)
-			if (chr == keyb.lochars[i][j])
-				return (TRUE);
-
-	for (i = 0; i < 4; i++)
-		for (j = 0; j <= KEY_LINE_LEN; j++)
-			if (chr == keyb.upchars[i][j])
-				return (TRUE);
-	return (FALSE);
+	return (keyb_get_pos (chr) != NULL);
 }
 
 /**********************************************************************
@@ -509,20 +899,39 @@ keyb_get_altnums (gunichar * altnums)
 	return (k);
 }
 
+/**********************************************************************
+ * Get the character classes above, scanned only once per layout change.
+ * As the exercises may be created in another thread, it's first called
+ * from the main loop (see tutor.c).
+ */
+const KeybClasses *
+keyb_get_classes ()
+{
+	if (keyb.classes_ok)
+		return (&keyb.classes);
+
+	keyb.classes.n_vowels = keyb_get_vowels (keyb.classes.vowels);
+	keyb.classes.n_consonants = keyb_get_consonants (keyb.classes.consonants);
+	keyb.classes.n_symbols = keyb_get_symbols (keyb.classes.symbols);
+	keyb.classes.n_altnums = keyb_get_altnums (keyb.classes.altnums);
+	keyb.classes_ok = TRUE;
+
+	return (&keyb.classes);
+}
+
 /**********************************************************************
  * Get the upper case of a letter, only if it's included in the keyboard (by shift)
  */
 gunichar
 keyb_unichar_toupper (gunichar uchar)
 {
-	gint i,j;
 	gunichar Uchar;
+	const KeybPos *pos;
 
 	Uchar = g_unichar_toupper (uchar);
-	for (i = 0; i < 4; i++)
-		for (j = 0; j < KEY_LINE_LEN; j++)
-			if (uchar == keyb.lochars[i][j] && Uchar == keyb.upchars[i][j])
-				return Uchar;
+	pos = keyb_get_pos (uchar);
+	if (pos && pos->level == 0 && Uchar == keyb_model_get (&keyb.model, 1, pos->row, pos->col))
+		return Uchar;
 	return uchar;
 }
 
@@ -532,8 +941,9 @@ keyb_unichar_toupper (gunichar uchar)
 void
 keyb_save_new_layout ()
 {
-	gint i;
+	gint i, l;
 	gchar *tmp_name = NULL;
+	const KeybModel *km;
 	FILE *fh;
 
 	assert_user_dir ();
@@ -541,20 +951,39 @@ keyb_save_new_layout ()
 	fh = (FILE *) g_fopen (tmp_name, "w");
 	g_free (tmp_name);
 
-	for (i = 0; i < 4; i++)
+	if (keyb.model.classic)
 	{
-		tmp_name = g_ucs4_to_utf8 (keyb.lochars[i], KEY_LINE_LEN - 1, NULL, NULL, NULL);
-		fprintf (fh, "%s\n", tmp_name);
-		g_free (tmp_name);
+		for (i = 0; i < 4; i++)
+		{
+			tmp_name = g_ucs4_to_utf8 (keyb.lochars[i], KEY_LINE_LEN - 1, NULL, NULL, NULL);
+			fprintf (fh, "%s\n", tmp_name);
+			g_free (tmp_name);
+		}
+		for (i = 0; i < 4; i++)
+		{
+			tmp_name = g_ucs4_to_utf8 (keyb.upchars[i], KEY_LINE_LEN - 1, NULL, NULL, NULL);
+			fprintf (fh, "%s\n", tmp_name);
+			g_free (tmp_name);
+		}
 	}
-	for (i = 0; i < 4; i++)
+	else
 	{
-		tmp_name = g_ucs4_to_utf8 (keyb.upchars[i], KEY_LINE_LEN - 1, NULL, NULL, NULL);
-		fprintf (fh, "%s\n", tmp_name);
-		g_free (tmp_name);
+		/* Keep the levels and keys out of the virtual keyboard
+		 */
+		km = &keyb.model;
+		fprintf (fh, "%s %i %i\n", KEYB_HEADER, km->n_rows, km->n_levels);
+		for (l = 0; l < km->n_levels; l++)
+			for (i = 0; i < km->n_rows; i++)
+			{
+				tmp_name = g_ucs4_to_utf8 (km->chars + l * km->n_keys + km->row_start[i],
+						km->row_start[i + 1] - km->row_start[i], NULL, NULL, NULL);
+				fprintf (fh, "%s\n", tmp_name);
+				g_free (tmp_name);
+			}
 	}
 	fclose (fh);
 
+	layouts.user_mtime = -1;
 	keyb_set_modified_status (FALSE);
 }
 
@@ -580,6 +1009,7 @@ keyb_remove_user_layout ()
 	g_unlink (tmp_name);
 	g_free (tmp_name);
 
+	layouts.user_mtime = -1;
 	keyb_set_keyboard_layouts ();
 
 	gtk_combo_box_set_active (cmb, -1);
@@ -702,62 +1132,36 @@ keyb_get_variant (const gchar *kbd)
 	return end;
 }
 
-/* Set the array of available keyboard layouts
+/* Set the array of available keyboard layouts: the original ones come
+ * from the catalog and the custom ones are listed again only if the
+ * user folder changed.
  */
-#define LAYOUT_BLOCK 64
 void
 keyb_set_keyboard_layouts ()
 {
-	static gboolean init = FALSE;
-	gchar *data;
 	gint i;
-	GList *files;
+	gint64 mtime;
+	GList *files, *l;
 
-	if (! init)
-	{
-
-		/* Read original layouts just once, now.
-		 */
-		files = keyb_get_layout_list_from_path (main_path_data ());
-		layouts.n_orig = g_list_length (files);
-		layouts.orig = g_malloc (layouts.n_orig * sizeof (KeybLayout));
-		//g_printf ("==> Data dir: %s\n", main_path_data ());
-		for (i = 0; i < layouts.n_orig; i++)
-		{
-			data = g_list_nth_data (files, i);
-			//g_printf ("kb(%i): %s\n", i, data);
-			layouts.orig[i].name = data;
-			layouts.orig[i].country = keyb_get_country (data);
-			layouts.orig[i].variant = keyb_get_variant (data);
-			//g_printf ("kb(%i): %s\t", i, layouts.orig[i].name);
-			//g_printf ("%s\t", layouts.orig[i].country);
-			//g_printf ("%s\n", layouts.orig[i].variant);
-		}
-		g_list_free (files);
+	keyb_catalog_init ();
 
-		init = TRUE;
-		layouts.n_cust = 0;
-		layouts.cust = g_malloc (LAYOUT_BLOCK * sizeof (KeybLayout));
-	}
+	assert_user_dir ();
+	mtime = keyb_dir_mtime (main_path_user ());
+	if (mtime >= 0 && mtime == layouts.user_mtime)
+		return;
+	layouts.user_mtime = mtime;
 
 	/*
 	 * Reads the list of custom files
 	 */
 	for (i = 0; i < layouts.n_cust; i++)
 		g_free (layouts.cust[i].name);
-	assert_user_dir ();
+	g_free (layouts.cust);
 	files = keyb_get_layout_list_from_path (main_path_user ());
 	layouts.n_cust = g_list_length (files);
-	if (layouts.n_cust == 0)
-		return;
-	if (layouts.n_cust > LAYOUT_BLOCK)
-		layouts.cust = g_realloc (layouts.cust, layouts.n_cust * sizeof (KeybLayout));
-	for (i = 0; i < layouts.n_cust; i++)
-	{
-		data = g_list_nth_data (files, i);
-		layouts.cust[i].name = data;
-		//g_printf ("kb(%i): %s\n", i, layouts.cust[i].name);
-	} 
+	layouts.cust = g_new0 (KeybLayout, layouts.n_cust);
+	for (i = 0, l = files; l; i++, l = l->next)
+		layouts.cust[i].name = l->data;
 	g_list_free (files);
 }
 
@@ -1525,6 +1929,9 @@ keyb_change_key (gunichar real_key)
 	key_lin = keyb.pos.i;
 	key_col = keyb.pos.j;
 
+	tutor_prefetch_discard ();
+	keyb.classes_ok = FALSE;
+
 	str_char = g_unichar_toupper (real_key);
 	tmp_utf8[g_unichar_to_utf8 (str_char, tmp_utf8)] = '\0';
 	gtk_label_set_text (GTK_LABEL (keyb.lab[key_lin][key_col]), tmp_utf8);
@@ -1543,7 +1950,10 @@ keyb_change_key (gunichar real_key)
 		if (str_char >= L'A' && str_char <= L'Z')
 			keyb.upchars[key_lin][key_col] = str_char;
 	}
+	keyb_model_set (&keyb.model, 0, key_lin, key_col, keyb.lochars[key_lin][key_col]);
+	keyb_model_set (&keyb.model, 1, key_lin, key_col, keyb.upchars[key_lin][key_col]);
 
+	keyb_map_build ();
 	keyb_set_modified_status (TRUE);
 	gtk_widget_set_sensitive (get_wg ("button_kb_save"), TRUE);
 	gtk_widget_set_sensitive (get_wg ("combobox_keyboard_country"), FALSE);
@@ -1570,9 +1980,6 @@ keyb_get_utf8_paragraph_symbol ()
 /*******************************************************************************
  * Initialize the hints mapping array
  */
-static gchar hints[4][KEY_LINE_LEN + 1];
-static gboolean hints_is_initialized = FALSE;
-
 void
 hints_init ()
 {
@@ -1602,6 +2009,8 @@ hints_init ()
 		for (i = 0; i < 4; i++)
 			tmp = fgets (hints[i], KEY_LINE_LEN + 1, fh);
 		fclose (fh);
+		tutor_prefetch_discard ();
+		keyb_map_build ();	/* now with the fingers */
 		hints_set_tips ();
 		hints_set_colors ();
 	}
@@ -1813,7 +2222,7 @@ void
 hints_update_from_char (gunichar character)
 {
 	gchar file_name[32];
-	gint i, j;
+	const KeybPos *pos;
 
 	if (! gtk_widget_get_visible (get_wg ("window_hints")))
 		return;
@@ -1827,24 +2236,8 @@ hints_update_from_char (gunichar character)
 	{
 		hints_init (); // if already initialized, do nothing
 
-		for (i = 3; i >= 0; i--)
-			for (j = 0; j < 15; j++)
-				if (character == keyb.lochars[i][j])
-				{
-					file_name[6] = hints[i][j];
-					set_pixmap ("pixmap_hints", file_name);
-					return;
-				}
-
-		for (i = 3; i >= 0; i--)
-			for (j = 0; j < 15; j++)
-				if (character == keyb.upchars[i][j])
-				{
-					file_name[6] = hints[i][j];
-					set_pixmap ("pixmap_hints", file_name);
-					return;
-				}
-		file_name[6] = '0';
+		pos = keyb_get_pos (character);
+		file_name[6] = pos ? pos->finger : '0';
 	}
 
 	set_pixmap ("pixmap_hints", file_name);
@@ -1888,7 +2281,7 @@ hints_demo_fingers (guint msec)
 gchar *
 hints_finger_name_from_char (gunichar uch)
 {
-	gint i, j;
+	const KeybPos *pos;
 
 	if (uch == UPSYM || uch == L'\n' || uch == L'\r')
 		return (hints_string_from_charcode ('9'));
@@ -1897,15 +2290,9 @@ hints_finger_name_from_char (gunichar uch)
 	
 	hints_init (); // if already initialized, do nothing
 
-	for (i = 3; i >= 0; i--)
-		for (j = 0; j < 15; j++)
-			if (uch == keyb.lochars[i][j])
-				return (hints_string_from_charcode (hints[i][j]));
-
-	for (i = 3; i >= 0; i--)
-		for (j = 0; j < 15; j++)
-			if (uch == keyb.upchars[i][j])
-				return (hints_string_from_charcode (hints[i][j]));
+	pos = keyb_get_pos (uch);
+	if (pos)
+		return (hints_string_from_charcode (pos->finger));
 
 	return (g_strdup (" "));
 }
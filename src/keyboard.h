@@ -14,6 +14,8 @@
 
 #define MAX_KEYBOARDS 200
 #define KEY_LINE_LEN (14 + 1)	/* 14 keys + 1 NULL char */
+#define KEYB_ROWS 8	/* lines of a classic .kbd file: 4 rows, without and with shift */
+#define KEYB_HEADER "klavaro-layout"	/* first line of the other ones: "klavaro-layout ROWS LEVELS" */
 
 #define UPSYM ((gunichar) 182)
 #define URDU_COMMA ((gunichar) 0x060C)
@@ -30,11 +32,51 @@
 #define KEYB_PURPLE "#ccaacc"
 #define KEYB_BLACK "#000000"
 
+/* Character classes of the current layout, for the exercise generators
+ */
+typedef struct _KEYBCLASSES
+{
+	gunichar vowels[20];
+	gint n_vowels;
+	gunichar consonants[8 * KEY_LINE_LEN];
+	gint n_consonants;
+	gunichar symbols[8 * KEY_LINE_LEN];
+	gint n_symbols;
+	gunichar altnums[8 * KEY_LINE_LEN];
+	gint n_altnums;
+} KeybClasses;
+
+/* Where a character is typed (see keyb_get_pos)
+ */
+typedef struct _KEYBPOS
+{
+	gint16 row;
+	gint16 col;
+	gint16 level;	/* 0: without shift, 1: with shift, 2: AltGr... */
+	gchar finger;	/* code of fingers_position.txt, '0' if unknown */
+} KeybPos;
+
+/* Any layout: 'n_levels' character sets (plain, shift, AltGr...) with
+ * 'n_rows' rows, each row with its own number of keys. The characters are
+ * in one array, level after level and row after row, so that
+ * chars[level * n_keys + row_start[row] + col] is the key.
+ */
+typedef struct _KEYBMODEL
+{
+	gint n_rows;
+	gint n_levels;
+	gint n_keys;		/* per level */
+	gint *row_start;	/* n_rows + 1 */
+	gunichar *chars;	/* n_levels * n_keys */
+	gboolean classic;	/* from an 8 line .kbd file */
+} KeybModel;
+
 typedef struct _KEYBLAYOUT
 {
 	gchar *name;
 	gchar *country;
 	gchar *variant;
+	gchar **rows;	/* lines of the .kbd file, if cached (see keyb_set_chars) */
 } KeybLayout;
 
 /*
@@ -69,6 +111,12 @@ gboolean keyb_is_diacritic (gunichar chr);
 
 gboolean keyb_is_inset (gunichar chr);
 
+const KeybPos *keyb_get_pos (gunichar chr);
+
+const KeybModel *keyb_get_model (void);
+
+gunichar keyb_model_get (const KeybModel *km, gint level, gint row, gint col);
+
 gint keyb_get_vowels (gunichar * vows);
 
 gint keyb_get_consonants (gunichar * consonants);
@@ -77,6 +125,8 @@ gint keyb_get_symbols (gunichar * symbols);
 
 gint keyb_get_altnums (gunichar * altnums);
 
+const KeybClasses *keyb_get_classes (void);
+
 gunichar keyb_unichar_toupper (gunichar uchar);
 
 void keyb_save_new_layout (void);
@@ -85,6 +135,8 @@ void keyb_remove_user_layout (void);
 
 void keyb_update_virtual_layout (void);
 
+GList * keyb_get_layout_list_from_path (gchar *path);
+
 gchar * keyb_get_country (const gchar *kbd);
 
 gchar * keyb_get_variant (const gchar *kbd);
@@ -0,0 +1,520 @@
+/*****************************************************************************/
+/*  Klavaro - a flexible touch typing tutor                                  */
+/*  Copyright (C) 2005, 2006, 2007, 2008 Felipe Castro                       */
+/*  Copyright (C) 2009, 2010, 2011, 2012, 2013 The Free Software Foundation  */
+/*                                                                           */
+/*  This program is free software, licensed under the terms of the GNU       */
+/*  General Public License as published by the Free Software Foundation,     */
+/*  either version 3 of the License, or (at your option) any later version.  */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
+/*****************************************************************************/
+
+/*
+ * Scores files and rankings, shared by the Top 10 and the leaderboard server
+ */
+
+#include <string.h>
+#include <time.h>
+#include <glib.h>
+
+#include "top10.h"
+#include "ksc.h"
+
+/* Compiled scores file: a header, fixed size records and a block with the names,
+ * all numbers little-endian. Files without the magic are in the old format.
+ */
+#define KSC_MAGIC "KLTOP10"
+#define KSC_VERSION 2
+#define KSC_HEADER_SIZE 32
+#define KSC_RECORD_SIZE 40
+#define KSC_OLD_END "KLAVARO!"
+#define NOBODY "xxx"
+
+/**************************************************
+ * Rankings
+ */
+
+/* Competitors are told apart by their names, without the keyboard suffix " [...]"
+ */
+gchar *
+ksc_name_key (const gchar * name)
+{
+	gchar *pos;
+
+	pos = strrchr (name, '[');
+	if (pos != NULL && pos > name + 1 && *(pos - 1) == ' ')
+		return (g_strndup (name, pos - name - 1));
+	return (g_strdup (name));
+}
+
+/* Ranking order: higher score, then older record, then name
+ */
+gint
+ksc_compare_stat (gconstpointer a, gconstpointer b, gpointer data)
+{
+	const Statistics *sa = a;
+	const Statistics *sb = b;
+
+	if (sa->score != sb->score)
+		return (sa->score > sb->score ? -1 : 1);
+	if (sa->when != sb->when)
+		return (sa->when < sb->when ? -1 : 1);
+	return (strcmp (sa->name, sb->name));
+}
+
+void
+ksc_board_init (KscBoard * board)
+{
+	if (board->seq == NULL)
+	{
+		board->seq = g_sequence_new (g_free);
+		board->by_name = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	}
+}
+
+void
+ksc_board_destroy (KscBoard * board)
+{
+	if (board->seq == NULL)
+		return;
+	g_hash_table_destroy (board->by_name);
+	g_sequence_free (board->seq);
+	board->seq = NULL;
+	board->by_name = NULL;
+}
+
+void
+ksc_board_clear (KscBoard * board)
+{
+	ksc_board_init (board);
+	g_hash_table_remove_all (board->by_name);
+	g_sequence_remove_range (g_sequence_get_begin_iter (board->seq),
+				 g_sequence_get_end_iter (board->seq));
+}
+
+static void
+ksc_board_remove (KscBoard * board, GSequenceIter * it)
+{
+	gchar *key;
+
+	key = ksc_name_key (((Statistics *) g_sequence_get (it))->name);
+	g_hash_table_remove (board->by_name, key);
+	g_free (key);
+	g_sequence_remove (it);
+}
+
+/* Keeps only the best record of each competitor, and the TOP10_BOARD_SIZE best ones
+ */
+gboolean
+ksc_board_insert (KscBoard * board, const Statistics * stat)
+{
+	gchar *key;
+	GSequenceIter *it;
+
+	if (stat->score <= 0)
+		return (FALSE);
+
+	ksc_board_init (board);
+	key = ksc_name_key (stat->name);
+	it = g_hash_table_lookup (board->by_name, key);
+	if (it != NULL)
+	{
+		if (ksc_compare_stat (g_sequence_get (it), stat, NULL) <= 0)
+		{
+			g_free (key);
+			return (FALSE);
+		}
+		ksc_board_remove (board, it);
+	}
+	else if (g_sequence_get_length (board->seq) >= TOP10_BOARD_SIZE)
+	{
+		it = g_sequence_iter_prev (g_sequence_get_end_iter (board->seq));
+		if (ksc_compare_stat (g_sequence_get (it), stat, NULL) <= 0)
+		{
+			g_free (key);
+			return (FALSE);
+		}
+		ksc_board_remove (board, it);
+	}
+
+	it = g_sequence_insert_sorted (board->seq, g_memdup (stat, sizeof (Statistics)),
+				       ksc_compare_stat, NULL);
+	g_hash_table_insert (board->by_name, key, it);
+	return (TRUE);
+}
+
+/**************************************************
+ * Scores files
+ */
+
+static guint32
+ksc_checksum (const guchar * data, gsize len)
+{
+	gsize i;
+	guint32 hash = 2166136261U;
+
+	/* FNV-1a */
+	for (i = 0; i < len; i++)
+	{
+		hash ^= data[i];
+		hash *= 16777619U;
+	}
+	return (hash);
+}
+
+static guint32
+ksc_get_le32 (const guchar * p)
+{
+	return ((guint32) p[0] | (guint32) p[1] << 8 | (guint32) p[2] << 16 | (guint32) p[3] << 24);
+}
+
+static void
+ksc_set_le32 (guchar * p, guint32 val)
+{
+	p[0] = val & 0xff;
+	p[1] = (val >> 8) & 0xff;
+	p[2] = (val >> 16) & 0xff;
+	p[3] = (val >> 24) & 0xff;
+}
+
+static void
+ksc_put_le32 (GByteArray * buf, guint32 val)
+{
+	guchar p[4];
+
+	ksc_set_le32 (p, val);
+	g_byte_array_append (buf, p, 4);
+}
+
+static gfloat
+ksc_get_float (const guchar * p)
+{
+	union { guint32 u; gfloat f; } val;
+
+	val.u = ksc_get_le32 (p);
+	return (val.f);
+}
+
+static void
+ksc_put_float (GByteArray * buf, gfloat f)
+{
+	union { guint32 u; gfloat f; } val;
+
+	val.f = f;
+	ksc_put_le32 (buf, val.u);
+}
+
+/* Sanity checks of a record read from any scores file, the name already copied
+ */
+static gboolean
+ksc_check_record (Statistics * st)
+{
+	gint j;
+
+	if (!g_ascii_isalpha (st->lang[0]))
+	{
+		g_message ("Problem: lang[0] = %c", st->lang[0]);
+		return (FALSE);
+	}
+	if (!g_ascii_isalpha (st->lang[1]))
+	{
+		st->lang[0] = 'e';
+		st->lang[1] = 'o';
+	}
+	if (st->genv != 'x' && st->genv != 'w')
+	{
+		g_message ("Problem: genv = %c", st->genv);
+		return (FALSE);
+	}
+	if (st->nchars < MIN_CHARS_TO_LOG)
+	{
+		g_message ("Problem: nchars = %i, < %i", st->nchars, MIN_CHARS_TO_LOG);
+		return (FALSE);
+	}
+	if (!(st->accur >= 0 && st->accur <= 100))
+	{
+		g_message ("Problem: accur = %f <> [0, 100]", st->accur);
+		return (FALSE);
+	}
+	if (!(st->velo >= 0 && st->velo <= 300))
+	{
+		g_message ("Problem: velo = %f <> [0, 300]", st->velo);
+		return (FALSE);
+	}
+	if (!(st->fluid >= 0 && st->fluid <= 100))
+	{
+		g_message ("Problem: fluid = %f <> [0, 100]", st->fluid);
+		return (FALSE);
+	}
+	if (!(st->score >= 0 && st->score <= 20))
+	{
+		g_message ("Problem: score = %f <> [0, 20]", st->score);
+		return (FALSE);
+	}
+	if (!g_utf8_validate (st->name, -1, NULL))
+	{
+		for (j = 0; j < st->name_len; j++)
+			if (!g_ascii_isalpha (st->name[j]))
+				st->name[j] = '?';
+	}
+	return (TRUE);
+}
+
+/* Old format: records written field by field, 31 bytes plus the name, closed by
+ * "KLAVARO!". It is still what the contest server hands out and takes in.
+ */
+static GArray *
+ksc_parse_old (const guchar * data, gsize len)
+{
+	gsize p;
+	Statistics st;
+	GArray *stats;
+
+	stats = g_array_new (FALSE, FALSE, sizeof (Statistics));
+	for (p = 0; p + 31 <= len;)
+	{
+		if (memcmp (data + p, KSC_OLD_END, 8) == 0)
+			break;
+
+		memset (&st, 0, sizeof (Statistics));
+		st.lang[0] = data[p];
+		st.lang[1] = data[p + 1];
+		st.genv = data[p + 2];
+		st.when = (gint32) ksc_get_le32 (data + p + 3);
+		st.nchars = (gint32) ksc_get_le32 (data + p + 7);
+		st.accur = ksc_get_float (data + p + 11);
+		st.velo = ksc_get_float (data + p + 15);
+		st.fluid = ksc_get_float (data + p + 19);
+		st.score = ksc_get_float (data + p + 23);
+		st.name_len = (gint32) ksc_get_le32 (data + p + 27);
+		p += 31;
+		if (st.name_len < 0 || st.name_len > MAX_NAME_LEN || st.name_len > len - p)
+		{
+			g_message ("Problem: name_len = %i <> [0, MAX_NAME_LEN]", st.name_len);
+			break;
+		}
+		memcpy (st.name, data + p, st.name_len);
+		st.name[st.name_len] = '\0';
+		p += st.name_len;
+
+		if (!ksc_check_record (&st))
+			break;
+		g_array_append_val (stats, st);
+	}
+
+	if (stats->len == 0)
+	{
+		g_array_free (stats, TRUE);
+		return (NULL);
+	}
+	return (stats);
+}
+
+/* Current format:
+ *   header  (32 bytes): magic "KLTOP10\0", version, number of records,
+ *                       size of the names block, checksum, 8 reserved bytes
+ *   records (40 bytes): lang[2], genv, pad, when (64 bits), nchars,
+ *                       accur, velo, fluid, score, name offset, name length
+ *   names block
+ * The checksum covers everything after the header.
+ */
+static GArray *
+ksc_parse_compiled (const guchar * data, gsize len, const gchar * file)
+{
+	guint32 i;
+	guint32 n;
+	guint32 version;
+	guint32 names_size;
+	guint32 name_off;
+	const guchar *rec;
+	const guchar *names;
+	Statistics st;
+	GArray *stats;
+
+	version = ksc_get_le32 (data + 8);
+	if (version != KSC_VERSION)
+	{
+		g_message ("Unknown version (%u) of the scores file '%s'", version, file);
+		return (NULL);
+	}
+	n = ksc_get_le32 (data + 12);
+	names_size = ksc_get_le32 (data + 16);
+	if ((len - KSC_HEADER_SIZE) / KSC_RECORD_SIZE < n ||
+	    len - KSC_HEADER_SIZE - (gsize) n * KSC_RECORD_SIZE < names_size)
+	{
+		g_message ("Truncated scores file: '%s'", file);
+		return (NULL);
+	}
+	if (ksc_checksum (data + KSC_HEADER_SIZE, (gsize) n * KSC_RECORD_SIZE + names_size)
+	    != ksc_get_le32 (data + 20))
+	{
+		g_message ("Corrupted scores file: '%s'", file);
+		return (NULL);
+	}
+
+	stats = g_array_sized_new (FALSE, FALSE, sizeof (Statistics), n);
+	names = data + KSC_HEADER_SIZE + (gsize) n * KSC_RECORD_SIZE;
+	for (i = 0; i < n; i++)
+	{
+		rec = data + KSC_HEADER_SIZE + (gsize) i * KSC_RECORD_SIZE;
+		memset (&st, 0, sizeof (Statistics));
+		st.lang[0] = rec[0];
+		st.lang[1] = rec[1];
+		st.genv = rec[2];
+		st.when = (time_t) (gint64) ((guint64) ksc_get_le32 (rec + 8) << 32 |
+					     ksc_get_le32 (rec + 4));
+		st.nchars = (gint32) ksc_get_le32 (rec + 12);
+		st.accur = ksc_get_float (rec + 16);
+		st.velo = ksc_get_float (rec + 20);
+		st.fluid = ksc_get_float (rec + 24);
+		st.score = ksc_get_float (rec + 28);
+		name_off = ksc_get_le32 (rec + 32);
+		st.name_len = (gint32) ksc_get_le32 (rec + 36);
+		if (st.name_len < 0 || st.name_len > MAX_NAME_LEN ||
+		    name_off > names_size || st.name_len > names_size - name_off)
+		{
+			g_message ("Problem: name_len = %i <> [0, MAX_NAME_LEN]", st.name_len);
+			continue;
+		}
+		memcpy (st.name, names + name_off, st.name_len);
+		st.name[st.name_len] = '\0';
+
+		if (ksc_check_record (&st))
+			g_array_append_val (stats, st);
+	}
+	return (stats);
+}
+
+/* Records of a scores file in any format, or NULL if it is not one;
+ * 'name' is only used in the messages
+ */
+GArray *
+ksc_parse (const guchar * data, gsize len, const gchar * name)
+{
+	if (len >= KSC_HEADER_SIZE && memcmp (data, KSC_MAGIC, sizeof (KSC_MAGIC)) == 0)
+		return (ksc_parse_compiled (data, len, name));
+	return (ksc_parse_old (data, len));
+}
+
+/* The whole file is mapped and parsed at once, whatever its format
+ */
+GArray *
+ksc_load_file (const gchar * file)
+{
+	gsize len;
+	const guchar *data;
+	GArray *stats;
+	GMappedFile *mf;
+
+	mf = g_mapped_file_new (file, FALSE, NULL);
+	if (mf == NULL)
+		return (NULL);
+
+	data = (const guchar *) g_mapped_file_get_contents (mf);
+	len = g_mapped_file_get_length (mf);
+	stats = ksc_parse (data, len, file);
+	g_mapped_file_unref (mf);
+
+	return (stats);
+}
+
+GByteArray *
+ksc_compile (GSequence * seq)
+{
+	gsize n;
+	GByteArray *buf;
+	GByteArray *names;
+	GSequenceIter *it;
+	Statistics *st;
+	const guchar header[KSC_HEADER_SIZE] = KSC_MAGIC;
+
+	n = g_sequence_get_length (seq);
+	buf = g_byte_array_sized_new (KSC_HEADER_SIZE + n * (KSC_RECORD_SIZE + 16));
+	names = g_byte_array_new ();
+
+	g_byte_array_append (buf, header, KSC_HEADER_SIZE);
+	ksc_set_le32 (buf->data + 8, KSC_VERSION);
+	ksc_set_le32 (buf->data + 12, n);
+
+	it = g_sequence_get_begin_iter (seq);
+	for (; !g_sequence_iter_is_end (it); it = g_sequence_iter_next (it))
+	{
+		st = g_sequence_get (it);
+		g_byte_array_append (buf, (guchar *) st->lang, 2);
+		g_byte_array_append (buf, (guchar *) &st->genv, 1);
+		g_byte_array_append (buf, (guchar *) "", 1);
+		ksc_put_le32 (buf, (guint64) st->when & 0xffffffff);
+		ksc_put_le32 (buf, (guint64) (gint64) st->when >> 32);
+		ksc_put_le32 (buf, st->nchars);
+		ksc_put_float (buf, st->accur);
+		ksc_put_float (buf, st->velo);
+		ksc_put_float (buf, st->fluid);
+		ksc_put_float (buf, st->score);
+		ksc_put_le32 (buf, names->len);
+		ksc_put_le32 (buf, st->name_len);
+		g_byte_array_append (names, (guchar *) st->name, st->name_len);
+	}
+	g_byte_array_append (buf, names->data, names->len);
+	ksc_set_le32 (buf->data + 16, names->len);
+	ksc_set_le32 (buf->data + 20, ksc_checksum (buf->data + KSC_HEADER_SIZE,
+							buf->len - KSC_HEADER_SIZE));
+	g_byte_array_free (names, TRUE);
+
+	return (buf);
+}
+
+/* Old format record, as the contest server takes them
+ */
+void
+ksc_append_old (GByteArray * buf, const Statistics * st)
+{
+	g_byte_array_append (buf, (guchar *) st->lang, 2);
+	g_byte_array_append (buf, (guchar *) &st->genv, 1);
+	ksc_put_le32 (buf, (gint32) st->when);
+	ksc_put_le32 (buf, st->nchars);
+	ksc_put_float (buf, st->accur);
+	ksc_put_float (buf, st->velo);
+	ksc_put_float (buf, st->fluid);
+	ksc_put_float (buf, st->score);
+	ksc_put_le32 (buf, st->name_len);
+	g_byte_array_append (buf, (guchar *) st->name, st->name_len);
+}
+
+/* The contest server only knows the old format, with ten records
+ */
+GByteArray *
+ksc_compile_old (KscBoard * board)
+{
+	gint i;
+	GByteArray *buf;
+	GSequenceIter *it;
+	const Statistics *st;
+	Statistics nobody;
+
+	memset (&nobody, 0, sizeof (Statistics));
+	nobody.lang[0] = 'x';
+	nobody.lang[1] = 'x';
+	nobody.genv = 'x';
+	nobody.nchars = MIN_CHARS_TO_LOG;
+	nobody.name_len = strlen (NOBODY);
+	strcpy (nobody.name, NOBODY);
+
+	ksc_board_init (board);
+	buf = g_byte_array_new ();
+	it = g_sequence_get_begin_iter (board->seq);
+	for (i = 0; i < TOP10_SHOWN; i++)
+	{
+		if (g_sequence_iter_is_end (it))
+			st = &nobody;
+		else
+		{
+			st = g_sequence_get (it);
+			it = g_sequence_iter_next (it);
+		}
+		ksc_append_old (buf, st);
+	}
+	g_byte_array_append (buf, (guchar *) KSC_OLD_END, 8);
+
+	return (buf);
+}
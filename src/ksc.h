@@ -0,0 +1,42 @@
+/*****************************************************************************/
+/*  Klavaro - a flexible touch typing tutor                                  */
+/*  Copyright (C) 2005, 2006, 2007, 2008 Felipe Castro                       */
+/*  Copyright (C) 2009, 2010, 2011, 2012, 2013 The Free Software Foundation  */
+/*                                                                           */
+/*  This program is free software, licensed under the terms of the GNU       */
+/*  General Public License as published by the Free Software Foundation,     */
+/*  either version 3 of the License, or (at your option) any later version.  */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
+/*****************************************************************************/
+
+/**************************************************
+ * Scores files and rankings
+ */
+typedef struct
+{
+	GSequence *seq;		/* Statistics *, best score first */
+	GHashTable *by_name;	/* competitor name -> GSequenceIter * */
+} KscBoard;
+
+gchar *ksc_name_key (const gchar * name);
+
+gint ksc_compare_stat (gconstpointer a, gconstpointer b, gpointer data);
+
+void ksc_board_init (KscBoard * board);
+
+void ksc_board_destroy (KscBoard * board);
+
+void ksc_board_clear (KscBoard * board);
+
+gboolean ksc_board_insert (KscBoard * board, const Statistics * stat);
+
+GArray *ksc_parse (const guchar * data, gsize len, const gchar * name);
+
+GArray *ksc_load_file (const gchar * file);
+
+GByteArray *ksc_compile (GSequence * seq);
+
+void ksc_append_old (GByteArray * buf, const Statistics * st);
+
+GByteArray *ksc_compile_old (KscBoard * board);
@@ -13,6 +13,7 @@
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <errno.h>
 #include <glib.h>
 #include <glib/gstdio.h>
 #include <pango/pango-attributes.h>
@@ -26,6 +27,7 @@
 #include "tutor.h"
 #include "accuracy.h"
 #include "top10.h"
+#include "stats.h"
 #include "main.h"
 
 /*******************************************************************************
@@ -421,9 +423,15 @@ main (int argc, char *argv[])
 	gchar *tmp;
 	gboolean success = FALSE;
 	gboolean show_version = FALSE;
+	gchar *seed = NULL;
+	gchar *seed_end;
+	guint64 seed_value;
+	gchar *export_dir = NULL;
 	GOptionContext *opct;
 	GOptionEntry option[] = {
 		{"version", 'v', 0, G_OPTION_ARG_NONE, &show_version, "Versio", NULL},
+		{"seed", 's', 0, G_OPTION_ARG_STRING, &seed, "Seed for the random exercises", "N"},
+		{"export-stats", 'e', 0, G_OPTION_ARG_FILENAME, &export_dir, "Export the progress data as text files", "DIR"},
 		{NULL}
 	};
 	GError *gerr;
@@ -454,6 +462,21 @@ main (int argc, char *argv[])
 	curl_ok = curl_global_init (CURL_GLOBAL_WIN32) == CURLE_OK ? TRUE : FALSE;
 
 	main_initialize_global_variables ();	/* Here the locale is got. */
+	if (seed != NULL)
+	{
+		/* Logged seeds use the whole 64 bits, beyond the option parser's gint64 */
+		errno = 0;
+		seed_value = g_ascii_strtoull (seed, &seed_end, 10);
+		if (errno != 0 || seed_end == seed || *seed_end != '\0')
+		{
+			g_printerr ("Invalid seed: %s\n", seed);
+			return 1;
+		}
+		rnd_set_session_seed (seed_value);
+		g_free (seed);
+	}
+	if (export_dir != NULL)
+		return (stats_export_tsv (export_dir) ? 0 : 1);
 
 	/* Create all the interface stuff
 	 */
@@ -485,9 +508,11 @@ main (int argc, char *argv[])
 void
 main_window_pass_away ()
 {
+	tutor_prefetch_discard ();
 	main_preferences_save ();
 	accur_close ();
 	g_rmdir ("tmp/klavaro");
+	top10_transfer_cancel (TRUE);
 	if (curl_ok) curl_global_cleanup ();
 	g_print ("\nAdiaux!\n");
 	exit (0);
@@ -0,0 +1,347 @@
+/*****************************************************************************/
+/*  Klavaro - a flexible touch typing tutor                                  */
+/*  Copyright (C) 2005, 2006, 2007, 2008 Felipe Castro                       */
+/*  Copyright (C) 2009, 2010, 2011, 2012, 2013 The Free Software Foundation  */
+/*                                                                           */
+/*  This program is free software, licensed under the terms of the GNU       */
+/*  General Public License as published by the Free Software Foundation,     */
+/*  either version 3 of the License, or (at your option) any later version.  */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
+/*****************************************************************************/
+
+/*
+ * Pseudo-words: character n-gram model of a language, trained from its
+ * dictionary (.words file) and walked at random.
+ */
+#include <string.h>
+#include <glib.h>
+
+#include "auxiliar.h"
+#include "main.h"
+#include "translation.h"
+#include "keyboard.h"
+#include "markov.h"
+
+/* Transition tables in compressed rows: the transitions of state 's' are
+ * those from row[s] to row[s+1]-1, sorted by character, each one with the
+ * cumulative weight of the row up to it. The character 0 ends the word.
+ * State 0 is the beginning of a word.
+ */
+struct _MARKOV
+{
+	gint order;
+	gint n_states;
+	gint n_trans;
+	gint *row;
+	gunichar *chr;
+	gint *next;
+	guint32 *cumul;
+};
+
+static GHashTable *models = NULL;	/* language code -> Markov (or NULL if failed) */
+
+/**********************************************************************
+ * Training
+ */
+typedef struct
+{
+	gint order;
+	GHashTable *ids;	/* context -> state id + 1 */
+	GArray *ctx;		/* 'order' chars per state */
+	GPtrArray *count;	/* per state: char -> count */
+} Trainer;
+
+static gint
+markov_state_id (Trainer *tr, const gunichar *ctx)
+{
+	gint id;
+	GBytes *key;
+
+	key = g_bytes_new (ctx, tr->order * sizeof (gunichar));
+	id = GPOINTER_TO_INT (g_hash_table_lookup (tr->ids, key)) - 1;
+	if (id >= 0)
+	{
+		g_bytes_unref (key);
+		return (id);
+	}
+	id = tr->count->len;
+	g_hash_table_insert (tr->ids, key, GINT_TO_POINTER (id + 1));
+	g_array_append_vals (tr->ctx, ctx, tr->order);
+	g_ptr_array_add (tr->count, g_hash_table_new (NULL, NULL));
+	return (id);
+}
+
+static void
+markov_shift (gunichar *ctx, gint order, gunichar c)
+{
+	memmove (ctx, ctx + 1, (order - 1) * sizeof (gunichar));
+	ctx[order - 1] = c;
+}
+
+static void
+markov_count_word (Trainer *tr, const gunichar *word, glong len)
+{
+	glong i;
+	gint state;
+	gunichar c;
+	gunichar ctx[MARKOV_MAX_ORDER];
+	GHashTable *count;
+
+	memset (ctx, 0, sizeof (ctx));
+	for (i = 0; i <= len; i++)
+	{
+		c = i < len ? word[i] : 0;
+		state = markov_state_id (tr, ctx);
+		count = g_ptr_array_index (tr->count, state);
+		g_hash_table_insert (count, GUINT_TO_POINTER (c),
+				GUINT_TO_POINTER (GPOINTER_TO_UINT (g_hash_table_lookup (count, GUINT_TO_POINTER (c))) + 1));
+		markov_shift (ctx, tr->order, c);
+	}
+}
+
+static gint
+compare_unichar (gconstpointer a, gconstpointer b)
+{
+	gunichar x = GPOINTER_TO_UINT (*(gconstpointer *) a);
+	gunichar y = GPOINTER_TO_UINT (*(gconstpointer *) b);
+
+	return (x < y ? -1 : (x > y ? 1 : 0));
+}
+
+/* Only lowercase words made of letters (and marks) are taken
+ */
+static gunichar *
+markov_clean_word (const gchar *line, glong *len)
+{
+	glong i;
+	gunichar *word;
+
+	if (!g_utf8_validate (line, -1, NULL))
+		return (NULL);
+	word = g_utf8_to_ucs4_fast (line, -1, len);
+	if (*len < MARKOV_MIN_LEN || *len > MARKOV_MAX_LEN)
+	{
+		g_free (word);
+		return (NULL);
+	}
+	for (i = 0; i < *len; i++)
+	{
+		if (!g_unichar_isalpha (word[i]) && !g_unichar_ismark (word[i]))
+		{
+			g_free (word);
+			return (NULL);
+		}
+		word[i] = g_unichar_tolower (word[i]);
+	}
+	return (word);
+}
+
+static Markov *
+markov_build (Trainer *tr)
+{
+	gint s, t, k;
+	guint32 sum;
+	gunichar c;
+	gunichar ctx[MARKOV_MAX_ORDER];
+	GList *keys, *l;
+	GPtrArray *sorted;
+	GHashTable *count;
+	Markov *mk;
+
+	mk = g_new0 (Markov, 1);
+	mk->order = tr->order;
+	mk->n_states = tr->count->len;
+	for (s = 0; s < mk->n_states; s++)
+		mk->n_trans += g_hash_table_size (g_ptr_array_index (tr->count, s));
+	mk->row = g_new (gint, mk->n_states + 1);
+	mk->chr = g_new (gunichar, mk->n_trans);
+	mk->next = g_new (gint, mk->n_trans);
+	mk->cumul = g_new (guint32, mk->n_trans);
+
+	t = 0;
+	sorted = g_ptr_array_new ();
+	for (s = 0; s < mk->n_states; s++)
+	{
+		mk->row[s] = t;
+		count = g_ptr_array_index (tr->count, s);
+		keys = g_hash_table_get_keys (count);
+		g_ptr_array_set_size (sorted, 0);
+		for (l = keys; l; l = l->next)
+			g_ptr_array_add (sorted, l->data);
+		g_list_free (keys);
+		g_ptr_array_sort (sorted, compare_unichar);
+
+		sum = 0;
+		for (k = 0; k < (gint) sorted->len; k++, t++)
+		{
+			c = GPOINTER_TO_UINT (g_ptr_array_index (sorted, k));
+			sum += GPOINTER_TO_UINT (g_hash_table_lookup (count, GUINT_TO_POINTER (c)));
+			mk->chr[t] = c;
+			mk->cumul[t] = sum;
+			if (c == 0)
+				mk->next[t] = -1;
+			else
+			{
+				memcpy (ctx, &g_array_index (tr->ctx, gunichar, s * tr->order),
+						tr->order * sizeof (gunichar));
+				markov_shift (ctx, tr->order, c);
+				mk->next[t] = markov_state_id (tr, ctx);
+			}
+		}
+	}
+	mk->row[s] = t;
+	g_ptr_array_free (sorted, TRUE);
+	return (mk);
+}
+
+static Markov *
+markov_train (const gchar *lang)
+{
+	gint i;
+	gint n_words;
+	glong len;
+	gchar *path;
+	gchar *buf;
+	gchar **lines;
+	gunichar *word;
+	Trainer tr;
+	Markov *mk;
+
+	path = g_strconcat (main_path_data (), G_DIR_SEPARATOR_S, lang, ".words", NULL);
+	if (!g_file_test (path, G_FILE_TEST_IS_REGULAR))
+	{
+		g_free (path);
+		path = trans_lang_get_similar_file_name (".words");
+	}
+	if (!g_file_get_contents (path, &buf, NULL, NULL))
+	{
+		g_message ("could not open the file: %s", path);
+		g_free (path);
+		return (NULL);
+	}
+	g_free (path);
+	lines = g_strsplit_set (buf, "\r\n", -1);
+	g_free (buf);
+
+	for (n_words = 0, i = 0; lines[i]; i++)
+		n_words += lines[i][0] != '\0';
+	tr.order = n_words >= MARKOV_RICH_CORPUS ? 3 : 2;
+	tr.ids = g_hash_table_new_full (g_bytes_hash, g_bytes_equal, (GDestroyNotify) g_bytes_unref, NULL);
+	tr.ctx = g_array_new (FALSE, FALSE, sizeof (gunichar));
+	tr.count = g_ptr_array_new_with_free_func ((GDestroyNotify) g_hash_table_destroy);
+
+	for (i = 0; lines[i]; i++)
+	{
+		word = markov_clean_word (lines[i], &len);
+		if (word == NULL)
+			continue;
+		markov_count_word (&tr, word, len);
+		g_free (word);
+	}
+	g_strfreev (lines);
+
+	if (tr.count->len > 1)
+		mk = markov_build (&tr);
+	else
+		mk = NULL;
+
+	g_hash_table_destroy (tr.ids);
+	g_array_free (tr.ctx, TRUE);
+	g_ptr_array_free (tr.count, TRUE);
+	return (mk);
+}
+
+/**********************************************************************
+ * Generation
+ */
+
+/* Random walk from the beginning of a word: returns its length, or -1 if
+ * it gets longer than 'max_len'. O(length * log(transitions per state)).
+ */
+static gint
+markov_walk (const Markov *mk, gunichar *word, gint max_len, Rnd *rnd)
+{
+	gint n;
+	gint state;
+	gint lo, hi, mid;
+	guint32 r;
+
+	state = 0;
+	for (n = 0; n <= max_len; n++)
+	{
+		lo = mk->row[state];
+		hi = mk->row[state + 1] - 1;
+		r = rnd_int (rnd, mk->cumul[hi]);
+		while (lo < hi)
+		{
+			mid = (lo + hi) / 2;
+			if (mk->cumul[mid] > r)
+				hi = mid;
+			else
+				lo = mid + 1;
+		}
+		if (mk->chr[lo] == 0)
+			return (n);
+		if (n == max_len)
+			break;
+		word[n] = mk->chr[lo];
+		state = mk->next[lo];
+	}
+	return (-1);
+}
+
+/* Creates a pronounceable pseudo-word typeable on the current keyboard.
+ * Thread safe, as long as the keyboard isn't changed meanwhile.
+ */
+gboolean
+markov_create_word (const Markov *mk, gunichar *word, gint max_len, Rnd *rnd)
+{
+	gint i, n;
+	gint attempt;
+
+	if (mk == NULL)
+		return (FALSE);
+
+	for (attempt = 0; attempt < 8; attempt++)
+	{
+		n = markov_walk (mk, word, max_len, rnd);
+		if (n < MARKOV_MIN_LEN)
+			continue;
+		for (i = 0; i < n; i++)
+			if (!keyb_is_inset (word[i]))
+				break;
+		if (i < n)
+			continue;
+		word[n] = L'\0';
+		return (TRUE);
+	}
+	return (FALSE);
+}
+
+/**********************************************************************
+ * Cache of models, one per language: trained once, on the main thread
+ */
+void
+markov_prepare (const gchar *lang)
+{
+	Markov *mk;
+
+	if (models == NULL)
+		models = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	if (g_hash_table_contains (models, lang))
+		return;
+
+	mk = markov_train (lang);
+	g_hash_table_insert (models, g_strdup (lang), mk);
+	if (mk == NULL)
+		g_message ("no pseudo-words for '%s': using weird ones.", lang);
+}
+
+const Markov *
+markov_get (const gchar *lang)
+{
+	if (models == NULL)
+		return (NULL);
+	return (g_hash_table_lookup (models, lang));
+}
@@ -0,0 +1,24 @@
+/*****************************************************************************/
+/*  Klavaro - a flexible touch typing tutor                                  */
+/*  Copyright (C) 2005, 2006, 2007, 2008 Felipe Castro                       */
+/*  Copyright (C) 2009, 2010, 2011, 2012, 2013 The Free Software Foundation  */
+/*                                                                           */
+/*  This program is free software, licensed under the terms of the GNU       */
+/*  General Public License as published by the Free Software Foundation,     */
+/*  either version 3 of the License, or (at your option) any later version.  */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
+/*****************************************************************************/
+
+#define MARKOV_MAX_ORDER 3
+#define MARKOV_RICH_CORPUS 3000	/* words needed for order 3 */
+#define MARKOV_MIN_LEN 2
+#define MARKOV_MAX_LEN 32
+
+typedef struct _MARKOV Markov;
+
+void markov_prepare (const gchar *lang);
+
+const Markov * markov_get (const gchar *lang);
+
+gboolean markov_create_word (const Markov *mk, gunichar *word, gint max_len, Rnd *rnd);
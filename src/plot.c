@@ -16,7 +16,7 @@
 #include <math.h>
 #include <stdio.h>
 #include <string.h>
-#include <locale.h>
+#include <time.h>
 #include <glib.h>
 #include <glib/gstdio.h>
 #include <gdk/gdk.h>
@@ -36,6 +36,7 @@
 #include "accuracy.h"
 #include "keyboard.h"
 #include "translation.h"
+#include "stats.h"
 #include "plot.h"
 
 static struct
@@ -76,17 +77,40 @@ static struct
 		gfloat y[2];
 	} lim;
 	GtkDataboxGraph *limits;
+
+	struct
+	{
+		StatsHistory *data;	/* The whole history of the series, shared by its charts */
+		gint value;		/* Accuracy, velocity, fluidness or score */
+		gfloat *val;		/* and the values being plot */
+		gint n;
+		gfloat x[PLOT_SAMPLES];	/* Sampled to the visible width */
+		gfloat y[PLOT_SAMPLES];
+		gint len;
+	} hist;
+
+	struct
+	{
+		gint kind;		/* PLOT_AVER_* */
+		gfloat *vx;		/* Daily or weekly: at the last session of each period */
+		gfloat *vy;
+		gint n;
+		gfloat x[PLOT_SAMPLES];
+		gfloat y[PLOT_SAMPLES];
+		gint len;
+	} aver;
+	GtkDataboxGraph *line_aver;
+
+	struct
+	{
+		gboolean valid;
+		gdouble a;		/* value = a + b * days */
+		gdouble b;
+		gfloat y[PLOT_SAMPLES];	/* At the sampled sessions */
+	} trend;
+	GtkDataboxGraph *line_trend;
 } plot;
 
-gfloat accur[DATA_POINTS+1];
-gfloat velo[DATA_POINTS+1];
-gfloat fluid[DATA_POINTS+1];
-gfloat score[DATA_POINTS+1];
-gchar date[DATA_POINTS+1][20];
-gchar hour[DATA_POINTS+1][20];
-gint nchars[DATA_POINTS+1];
-gchar lesson[DATA_POINTS+1][299];
-gchar language[DATA_POINTS+1][80+1];
 glong n_points;
 gint plot_type; /* used to communicate the plotting type, for updating the cursor marker, etc */
 
@@ -122,6 +146,227 @@ plot_clip_data (gint i)
 }
  */
 
+/* Largest-Triangle-Three-Buckets: the count points from first become at most
+ * threshold points in (x, y), keeping the look of the whole line.
+ * Without vx, point j is at x = j + 1.
+ */
+static gint
+plot_lttb (const gfloat * vx, const gfloat * vy, gint first, gint count, gint threshold,
+	   gfloat * x, gfloat * y)
+{
+	gint i, j;
+	gint a = 0;
+	gint next_a = 0;
+	gint start, end;
+	gdouble every;
+	gdouble avg_x, avg_y;
+	gdouble area, max_area;
+	const gfloat *v;
+
+	v = vy + first;
+	if (count <= threshold || threshold < 3)
+	{
+		for (i = 0; i < count; i++)
+		{
+			x[i] = vx ? vx[first + i] : first + i + 1;
+			y[i] = v[i];
+		}
+		return (count);
+	}
+
+	every = (gdouble) (count - 2) / (threshold - 2);
+	x[0] = vx ? vx[first] : first + 1;
+	y[0] = v[0];
+	for (i = 0; i < threshold - 2; i++)
+	{
+		/* Average point of the next bucket */
+		start = (gint) ((i + 1) * every) + 1;
+		end = MIN ((gint) ((i + 2) * every) + 1, count);
+		avg_x = avg_y = 0;
+		for (j = start; j < end; j++)
+		{
+			avg_x += vx ? vx[first + j] : j;
+			avg_y += v[j];
+		}
+		avg_x /= end - start;
+		avg_y /= end - start;
+
+		/* The point of this bucket making the largest triangle */
+		start = (gint) (i * every) + 1;
+		end = (gint) ((i + 1) * every) + 1;
+		max_area = -1;
+		for (j = start; j < end; j++)
+		{
+			if (vx)
+				area = fabs ((vx[first + a] - avg_x) * (v[j] - v[a]) -
+					     (vx[first + a] - vx[first + j]) * (avg_y - v[a]));
+			else
+				area = fabs ((a - avg_x) * (v[j] - v[a]) - (a - j) * (avg_y - v[a]));
+			if (area > max_area)
+			{
+				max_area = area;
+				next_a = j;
+			}
+		}
+		x[i + 1] = vx ? vx[first + next_a] : first + next_a + 1;
+		y[i + 1] = v[next_a];
+		a = next_a;
+	}
+	x[i + 1] = vx ? vx[first + count - 1] : first + count;
+	y[i + 1] = v[count - 1];
+	return (threshold);
+}
+
+/* First of the n increasing values in vx not less than x
+ */
+static gint
+plot_search (const gfloat * vx, gint n, gfloat x)
+{
+	gint lo, hi, mid;
+
+	lo = 0;
+	hi = n;
+	while (lo < hi)
+	{
+		mid = (lo + hi) / 2;
+		if (vx[mid] < x)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return (lo);
+}
+
+static void
+plot_set_length (GtkDataboxGraph * graph, gint len)
+{
+	g_object_set (G_OBJECT (graph), "maxlen", len, "length", len, NULL);
+}
+
+/* Sample the visible sessions to the width of the chart
+ */
+static void
+plot_resample ()
+{
+	gint i;
+	gint first;
+	gint last;
+	gint width;
+	gfloat left, right, top, bottom;
+
+	if (plot.hist.n < 1 || plot.line_outter == NULL)
+		return;
+
+	gtk_databox_get_visible_limits (GTK_DATABOX (plot.databox), &left, &right, &top, &bottom);
+	if (left > right)
+	{
+		top = left;
+		left = right;
+		right = top;
+	}
+	/* Session i is at x = i + 1; take one more at both sides, so that the lines reach the borders */
+	first = CLAMP ((gint) floorf (left) - 2, 0, plot.hist.n - 1);
+	last = CLAMP ((gint) ceilf (right), 0, plot.hist.n - 1);
+
+	width = gtk_widget_get_allocated_width (plot.databox);
+	if (width < 3)
+		width = 600;
+	width = MIN (width, PLOT_SAMPLES);
+	plot.hist.len = plot_lttb (NULL, plot.hist.val, first, last - first + 1, width,
+			plot.hist.x, plot.hist.y);
+
+	plot_set_length (plot.point_kernel, plot.hist.len);
+	plot_set_length (plot.point_frame, plot.hist.len);
+	plot_set_length (plot.line_kernel, plot.hist.len);
+	plot_set_length (plot.line_frame, plot.hist.len);
+	plot_set_length (plot.line_outter, plot.hist.len);
+
+	/* The averages: the moving one is kept by the store for every session */
+	if (plot.line_aver != NULL)
+	{
+		if (plot.aver.kind == PLOT_AVER_MOVING)
+			plot.aver.len = plot_lttb (NULL,
+					(gfloat *) plot.hist.data->trend[plot.hist.value].moving->data,
+					first, last - first + 1, width, plot.aver.x, plot.aver.y);
+		else
+		{
+			first = MAX (plot_search (plot.aver.vx, plot.aver.n, left) - 1, 0);
+			last = MIN (plot_search (plot.aver.vx, plot.aver.n, right), plot.aver.n - 1);
+			plot.aver.len = plot_lttb (plot.aver.vx, plot.aver.vy, first, last - first + 1, width,
+					plot.aver.x, plot.aver.y);
+		}
+		plot_set_length (plot.line_aver, plot.aver.len);
+	}
+
+	/* The trend is straight along the time, not along the sessions */
+	if (plot.line_trend != NULL)
+	{
+		for (i = 0; i < plot.hist.len; i++)
+			plot.trend.y[i] = plot.trend.a + plot.trend.b *
+				stats_history_days (plot.hist.data, (gint) plot.hist.x[i] - 1);
+		plot_set_length (plot.line_trend, plot.hist.len);
+	}
+}
+
+/* Index of the drawn point nearest to the session number x, -1 if none
+ */
+static gint
+plot_nearest_sample (gfloat x)
+{
+	gint lo, hi, mid;
+
+	if (plot.hist.len < 1 || x < 0.5 || x > plot.hist.n + 0.5)
+		return (-1);
+
+	lo = 0;
+	hi = plot.hist.len - 1;
+	while (hi - lo > 1)
+	{
+		mid = (lo + hi) / 2;
+		if (plot.hist.x[mid] < x)
+			lo = mid;
+		else
+			hi = mid;
+	}
+	return ((x - plot.hist.x[lo] < plot.hist.x[hi] - x) ? lo : hi);
+}
+
+/* Slope of the trend, and when it reaches the goal, if ever
+ */
+static void
+plot_trend_tooltip ()
+{
+	gdouble days;
+	gchar *tip;
+	gchar date[32];
+	time_t tmp_time;
+	struct tm *ltime;
+	const StatsRecord *first;
+
+	first = &g_array_index (plot.hist.data->recs, StatsRecord, 0);
+	if (plot.goal.y[0] < 0)
+		tip = g_strdup_printf (_("Trend: %+.3f a day"), plot.trend.b);
+	else if (plot.trend.a + plot.trend.b * stats_history_days (plot.hist.data, plot.hist.n - 1)
+		 >= plot.goal.y[0])
+		tip = g_strdup_printf (_("Trend: %+.2f a day, the goal (%.0f) is reached"),
+			       	plot.trend.b, plot.goal.y[0]);
+	else if (plot.trend.b <= 0)
+		tip = g_strdup_printf (_("Trend: %+.2f a day, not towards the goal (%.0f)"),
+			       	plot.trend.b, plot.goal.y[0]);
+	else
+	{
+		days = (plot.goal.y[0] - plot.trend.a) / plot.trend.b;
+		tmp_time = (time_t) (first->when + days * 86400);
+		ltime = localtime (&tmp_time);
+		g_snprintf (date, 32, "%i-%2.2i-%2.2i",
+			    (ltime->tm_year) + 1900, (ltime->tm_mon) + 1, ltime->tm_mday);
+		tip = g_strdup_printf (_("Trend: %+.2f a day, the goal (%.0f) may be reached by %s"),
+			       	plot.trend.b, plot.goal.y[0], date);
+	}
+	gtk_widget_set_tooltip_text (plot.databox, tip);
+	g_free (tip);
+}
+
 static void
 plot_error_frequencies ()
 {
@@ -180,6 +425,7 @@ plot_error_frequencies ()
 	/* Data marker
 	 */
 	plot.point_marker = gtk_databox_points_new (1, plot.mark.x, plot.mark.y, &color_black, 7);
+	gtk_databox_graph_set_overlay (plot.point_marker, TRUE);
 	gtk_databox_graph_add (box, plot.point_marker);
 
 	/* Redraw the plot
@@ -245,6 +491,7 @@ plot_touch_times ()
 	/* Data marker
 	 */
 	plot.point_marker = gtk_databox_points_new (1, plot.mark.x, plot.mark.y, &color_black, 7);
+	gtk_databox_graph_set_overlay (plot.point_marker, TRUE);
 	gtk_databox_graph_add (box, plot.point_marker);
 
 	/* Redraw the plot
@@ -275,6 +522,13 @@ plot_initialize ()
 	gtk_databox_create_box_with_scrollbars_and_rulers (&plot.databox, &plot.gtkgrid, FALSE, FALSE, FALSE, FALSE);
 	gtk_container_add (GTK_CONTAINER (get_wg ("frame_stat")), plot.gtkgrid);
 	g_signal_connect (G_OBJECT (plot.databox), "motion_notify_event", G_CALLBACK (on_databox_hovered), NULL);
+	g_signal_connect (G_OBJECT (plot.databox), "zoomed", G_CALLBACK (on_databox_zoomed), NULL);
+	g_signal_connect (G_OBJECT (plot.databox), "size-allocate", G_CALLBACK (on_databox_size_allocate), NULL);
+	/* Panning (scrollbars, mouse wheel) moves the visible range without zooming */
+	g_signal_connect (G_OBJECT (gtk_databox_get_adjustment_x (GTK_DATABOX (plot.databox))), "value-changed",
+			  G_CALLBACK (on_databox_scrolled), NULL);
+	g_signal_connect (G_OBJECT (gtk_databox_get_adjustment_y (GTK_DATABOX (plot.databox))), "value-changed",
+			  G_CALLBACK (on_databox_scrolled), NULL);
 
 	/* Y labels
 	 */
@@ -293,16 +547,16 @@ plot_initialize ()
 void
 plot_draw_chart (gint field)
 {
-	gint i, len;
+	gint i;
 	gint lesson_n;
+	gint module;
 	gchar *kb_name;
-	gchar *tmp_name;
-	gchar *tmp_locale;
-	gchar *tmp_lang;
 	gchar tmp_str[2000];
-	FILE *fh;
+	GArray *buckets;
+	StatsBucket *bk;
 	GdkRGBA color, color2, color3;
 	GdkRGBA color_black;
+	GdkRGBA color_aver;
 	GtkDatabox *box;
 
 	box = GTK_DATABOX (plot.databox);
@@ -311,6 +565,10 @@ plot_draw_chart (gint field)
 	n_points = 0;
 	gtk_databox_graph_remove_all (box);
 	gtk_widget_hide (plot.gtkgrid);
+	plot.point_kernel = plot.point_frame = NULL;
+	plot.line_kernel = plot.line_frame = plot.line_outter = NULL;
+	plot.line_aver = plot.line_trend = NULL;
+	gtk_widget_set_tooltip_text (plot.databox, NULL);
 
 	/* Set plot type for external reference */
 	plot_type = field;
@@ -319,6 +577,7 @@ plot_draw_chart (gint field)
 	 */
 	gtk_widget_set_tooltip_text (get_wg ("entry_stat_x"), _("Character"));
 	gtk_widget_hide (get_wg ("box_grid_label_y"));
+	gtk_widget_hide (get_wg ("combobox_stat_aver"));
 	if (field == 6)
 	{
 		plot_error_frequencies ();
@@ -331,6 +590,7 @@ plot_draw_chart (gint field)
 	}
 	gtk_widget_set_tooltip_text (get_wg ("entry_stat_x"), _("Date & Time"));
 	gtk_widget_show (get_wg ("box_grid_label_y"));
+	gtk_widget_show (get_wg ("combobox_stat_aver"));
 
 	/* Auxiliar variable to track the lesson to be plot
 	 */
@@ -347,180 +607,58 @@ plot_draw_chart (gint field)
 		gtk_widget_hide (get_wg ("spinbutton_stat_lesson"));
 	}
 
-	/* Get the file name
-	 */
-	if (field < 4)
-		tmp_name = g_strconcat (main_path_stats (), G_DIR_SEPARATOR_S "stat_",
-			       	tutor_get_type_name (), ".txt", NULL);
-	else
-		tmp_name = g_build_filename (main_path_stats (), "scores_fluid.txt", NULL);
-
-	/* Open the data file
-	 */
-	fh = (FILE *) g_fopen (tmp_name, "r");
-	if (!fh)
-	{
-		g_message ("no data yet, no statistic file:\n%s", tmp_name);
-		g_free (tmp_name);
-		return;
-	}
-	
-	/* Change to "C" locale, but keep current language
-	 */
-        tmp_lang = trans_get_current_language ();
-	tmp_locale = g_strdup (setlocale (LC_NUMERIC, NULL));
-	if (tmp_locale != NULL)
-		setlocale (LC_NUMERIC, "C");
-
 	/* Keyboard names are compared without spaces (may be needed for custom files)
 	 */
 	kb_name = g_strdup (keyb_get_name ());
 	for (i=0; kb_name[i]; i++)
 		kb_name[i] = (kb_name[i] == ' ') ? '_' : kb_name[i];
 
-	/* Read the first line (header)
+	/* The whole history of the series being plot
 	 */
-	if (!fgets (tmp_str, 2000, fh))
-	{
-		g_message ("no data on the statistic file:\n%s", tmp_name);
-		g_free (tmp_name);
-		fclose (fh);
-		return;
-	}
-
-	/* Read the first DATA_POINTS points
-	 */
-	for (i = 0; i < DATA_POINTS; i++)
-		plot.data.y[i] = -1000;
-	i = 0;
-	while (1)
-	{
-		gint itens;
-		gchar *lang_extra;
-
-		language[i][0] = '\0';
-		if (field < 4)
-		{
-			itens = fscanf (fh, "%f%f%f%s%s%s\t", &accur[i], &velo[i], &fluid[i],
-				       	date[i], hour[i], lesson[i]);
-			if (itens != 6)	break;
-		}
-		else
-		{
-			itens = fscanf (fh, "%f%s%s%i\t", &score[i], date[i], hour[i], &nchars[i]);
-			if (itens != 4)	break;
-		}
-		lang_extra = fgets (language[i], 80, fh); 
-		if (language[i][len = (strlen(language[i])-1)] == '\n')
-			language[i][len] = '\0';
+	stats_history_unref (plot.hist.data);
+	g_free (plot.hist.val);
+	module = (field < 4) ? tutor_get_type () : STATS_SCORES;
+	if (tutor_get_type () == TT_BASIC)
+		plot.hist.data = stats_get_history (module, lesson_n, kb_name);
+	else if (tutor_get_type () == TT_ADAPT)
+		plot.hist.data = stats_get_history (module, 0, kb_name);
+	else
+		plot.hist.data = stats_get_history (module, 0, trans_get_current_language ());
+	g_free (kb_name);
+	plot.hist.n = plot.hist.data ? plot.hist.data->recs->len : 0;
+	plot.hist.value = field - 1;
 
-		//plot_clip_data (i);
+	plot.hist.val = g_new (gfloat, MAX (plot.hist.n, 1));
+	for (i = 0; i < plot.hist.n; i++)
+		plot.hist.val[i] = stats_record_value (&g_array_index (plot.hist.data->recs, StatsRecord, i),
+				plot.hist.value);
 
-		if (tutor_get_type () == TT_BASIC)
-		{
-			if (g_ascii_strtoll (lesson[i], NULL, 10) != lesson_n)
-				continue;
-			if (strcmp (language[i], kb_name) != 0)
-				continue;
-		}
-		if (tutor_get_type () == TT_ADAPT && strcmp (lesson[i], kb_name) != 0)
-			continue;
-		if (tutor_get_type () == TT_VELO && strcmp (language[i], tmp_lang) != 0)
-			continue;
-		if (tutor_get_type () == TT_FLUID && strcmp (language[i], tmp_lang) != 0)
-			continue;
-		switch (field)
-		{
-		case 1:
-			plot.data.y[i] = accur[i];
-			break;
-		case 2:
-			plot.data.y[i] = velo[i];
-			break;
-		case 3:
-			plot.data.y[i] = fluid[i];
-			break;
-		case 4:
-			plot.data.y[i] = score[i];
-			break;
-		}
-		if (++i == DATA_POINTS)
-			break;
-	}
-
-	/* Read until the end, keeping the last DATA_POINTS points 
+	/* Averages by day or by week, placed at the last session of each period
 	 */
-	while (1)
+	g_free (plot.aver.vx);
+	g_free (plot.aver.vy);
+	plot.aver.vx = plot.aver.vy = NULL;
+	plot.aver.n = 0;
+	plot.aver.kind = gtk_combo_box_get_active (GTK_COMBO_BOX (get_wg ("combobox_stat_aver")));
+	if (plot.hist.n > 0 && (plot.aver.kind == PLOT_AVER_DAILY || plot.aver.kind == PLOT_AVER_WEEKLY))
 	{
-		gint itens;
-		gchar *lang_extra;
-
-		language[i][0] = '\0';
-		if (field < 4)
-		{
-			itens = fscanf (fh, "%f%f%f%s%s%s\t", &accur[i], &velo[i], &fluid[i],
-				       	date[i], hour[i], lesson[i]);
-			if (itens != 6)	break;
-		}
+		if (plot.aver.kind == PLOT_AVER_DAILY)
+			buckets = plot.hist.data->trend[plot.hist.value].daily;
 		else
+			buckets = plot.hist.data->trend[plot.hist.value].weekly;
+		plot.aver.n = buckets->len;
+		plot.aver.vx = g_new (gfloat, plot.aver.n);
+		plot.aver.vy = g_new (gfloat, plot.aver.n);
+		for (i = 0; i < plot.aver.n; i++)
 		{
-			itens = fscanf (fh, "%f%s%s%i\t", &score[i], date[i], hour[i], &nchars[i]);
-			if (itens != 4)	break;
+			bk = &g_array_index (buckets, StatsBucket, i);
+			plot.aver.vx[i] = bk->last + 1;
+			plot.aver.vy[i] = bk->sum / bk->count;
 		}
-		lang_extra = fgets (language[i], 80, fh); 
-		if (language[i][len = (strlen(language[i])-1)] == '\n')
-			language[i][len] = '\0';
-
-		//plot_clip_data (i);
-
-		if (tutor_get_type () == TT_BASIC)
-		{
-			if (g_ascii_strtoll (lesson[i], NULL, 10) != lesson_n)
-				continue;
-			if (strcmp (language[i], kb_name) != 0)
-				continue;
-		}
-		if (tutor_get_type () == TT_ADAPT && strcmp (lesson[i], kb_name) != 0)
-			continue;
-		if (tutor_get_type () == TT_VELO && strcmp (language[i], tmp_lang) != 0)
-			continue;
-		if (tutor_get_type () == TT_FLUID && strcmp (language[i], tmp_lang) != 0)
-			continue;
-		for (i = 0; i < DATA_POINTS - 1; i++)
-		{
-			plot.data.y[i] = plot.data.y[i + 1];
-			strcpy (date[i], date[i + 1]);
-			strcpy (hour[i], hour[i + 1]);
-		}
-		strcpy (date[i], date[i + 1]);
-		strcpy (hour[i], hour[i + 1]);
-
-		switch (field)
-		{
-		case 1:
-			plot.data.y[i] = accur[i + 1];
-			break;
-		case 2:
-			plot.data.y[i] = velo[i + 1];
-			break;
-		case 3:
-			plot.data.y[i] = fluid[i + 1];
-			break;
-		case 4:
-			plot.data.y[i] = score[i + 1];
-			break;
-		}
-		i = DATA_POINTS;
 	}
-	fclose (fh);
-	g_free (kb_name);
-	g_free (tmp_name);
-
-	/* Coming back to the right locale
-	 */
-	if (tmp_locale != NULL)
-		setlocale (LC_NUMERIC, tmp_locale);
-	g_free (tmp_locale);
+	plot.trend.valid = plot.hist.n > 0 &&
+		stats_trend_fit (plot.hist.data, plot.hist.value, &plot.trend.a, &plot.trend.b);
+	i = plot.hist.n;
 
 	/* Set apropriate background
 	 */
@@ -543,7 +681,7 @@ plot_draw_chart (gint field)
 	plot.mark.x[0] = -7;
 	plot.mark.y[0] = -7;
 	plot.goal.x[0] = plot.lim.x[0] = 0;
-	plot.goal.x[1] = plot.lim.x[1] = DATA_POINTS + 2;
+	plot.goal.x[1] = plot.lim.x[1] = plot.hist.n + 1;
 	plot.lim.y[0] = 0;
 	plot.lim.y[1] = 100;
 	 
@@ -585,29 +723,50 @@ plot_draw_chart (gint field)
 	gtk_databox_auto_rescale (box, 0.0);
 
 	/* Point kernel */
-	plot.point_kernel = gtk_databox_points_new (i, plot.data.x, plot.data.y, &color, 3);
+	plot.point_kernel = gtk_databox_points_new (1, plot.hist.x, plot.hist.y, &color, 3);
 	gtk_databox_graph_add (box, plot.point_kernel);
 
 	/* Point frame */
-	plot.point_frame = gtk_databox_points_new (i, plot.data.x, plot.data.y, &color_black, 5);
+	plot.point_frame = gtk_databox_points_new (1, plot.hist.x, plot.hist.y, &color_black, 5);
 	gtk_databox_graph_add (box, plot.point_frame);
 
 	/* Data marker */
 	plot.point_marker = gtk_databox_points_new (1, plot.mark.x, plot.mark.y, &color_black, 7);
+	gtk_databox_graph_set_overlay (plot.point_marker, TRUE);
 	gtk_databox_graph_add (box, plot.point_marker);
 
+	/* Moving, daily or weekly average */
+	if (plot.aver.kind == PLOT_AVER_MOVING || plot.aver.n > 0)
+	{
+		gdk_rgba_parse (&color_aver, "#555555");
+		plot.line_aver = gtk_databox_lines_new (1, plot.aver.x, plot.aver.y, &color_aver, 2);
+		gtk_databox_graph_add (box, plot.line_aver);
+	}
+
+	/* Trend line */
+	if (plot.trend.valid)
+	{
+		gdk_rgba_parse (&color_aver, PLOT_PURPLE);
+		plot.line_trend = gtk_databox_lines_new (1, plot.hist.x, plot.trend.y, &color_aver, 1);
+		gtk_databox_graph_add (box, plot.line_trend);
+		plot_trend_tooltip ();
+	}
+
 	/* Kernel line */
-	plot.line_kernel = gtk_databox_lines_new (i, plot.data.x, plot.data.y, &color, 1);
+	plot.line_kernel = gtk_databox_lines_new (1, plot.hist.x, plot.hist.y, &color, 1);
 	gtk_databox_graph_add (box, plot.line_kernel);
 
 	/* Frame line */
-	plot.line_frame = gtk_databox_lines_new (i, plot.data.x, plot.data.y, &color2, 3);
+	plot.line_frame = gtk_databox_lines_new (1, plot.hist.x, plot.hist.y, &color2, 3);
 	gtk_databox_graph_add (box, plot.line_frame);
 
 	/* Outter line */
-	plot.line_outter = gtk_databox_lines_new (i, plot.data.x, plot.data.y, &color3, 5);
+	plot.line_outter = gtk_databox_lines_new (1, plot.hist.x, plot.hist.y, &color3, 5);
 	gtk_databox_graph_add (box, plot.line_outter);
 
+	/* All the history is in sight, till some zooming */
+	plot_resample ();
+
 	/* Goal limit */
 	gdk_rgba_parse (&color3, "#999999");
 	plot.line_goal = gtk_databox_lines_new (2, plot.goal.x, plot.goal.y, &color3, 1);
@@ -662,44 +821,84 @@ plot_draw_chart (gint field)
 	gtk_widget_show_all (plot.gtkgrid);
 }
 
+/* Zooming goes only along the time, since the labels of the y axis are fixed
+ */
+void
+plot_zoom_update ()
+{
+	static gboolean busy = FALSE;
+	gfloat left, right, top, bottom;
+	gfloat total_left, total_right, total_top, total_bottom;
+	GtkDatabox *box;
+
+	if (busy || plot_type > 4 || plot.line_outter == NULL)
+		return;
+	busy = TRUE;
+
+	box = GTK_DATABOX (plot.databox);
+	gtk_databox_get_visible_limits (box, &left, &right, &top, &bottom);
+	gtk_databox_get_total_limits (box, &total_left, &total_right, &total_top, &total_bottom);
+	if (top != total_top || bottom != total_bottom)
+		gtk_databox_set_visible_limits (box, left, right, total_top, total_bottom);
+	plot_resample ();
+	gtk_widget_queue_draw (plot.databox);
+
+	busy = FALSE;
+}
+
 void
 plot_pointer_update (gdouble x)
 {
 	static glong n_prev = 0;
 	glong n = 0;
+	gint k;
 	gchar *xstr;
 	gchar *ystr;
 	GtkDatabox *box;
 	gint width;
+	time_t tmp_time;
+	struct tm *ltime;
 
 	box = GTK_DATABOX (plot.databox);
 
-	gtk_window_get_size (get_win ("window_stat"), &width, NULL);
-	if (plot_type > 4)
-		width -= 25;
+	if (plot_type < 6)
+	{
+		/* Session number of the nearest point drawn */
+		k = plot_nearest_sample (gtk_databox_pixel_to_value_x (box, x));
+		n = (k < 0) ? -1 : (glong) plot.hist.x[k];
+	}
 	else
-		width -= 50;
-
-	n = rintf (x / width * (DATA_POINTS + 2)) - 1; // Round integer from float
+	{
+		gtk_window_get_size (get_win ("window_stat"), &width, NULL);
+		width -= 25;
+		n = rintf (x / width * (DATA_POINTS + 2)) - 1; // Round integer from float
+		k = (n < 0 || n >= n_points || n >= DATA_POINTS) ? -1 : n;
+	}
 	if (n == n_prev)
 		return;
 	n_prev = n;
 
-	if (n < 0 || n >= n_points || n >= DATA_POINTS) 
+	if (k < 0)
 	{
 		xstr = g_strdup ("--");
 		ystr = g_strdup ("--");
 		plot.mark.x[0] = -7;
 		plot.mark.y[0] = -7;
 	}
+	else if (plot_type < 6)
+	{
+		tmp_time = (time_t) g_array_index (plot.hist.data->recs, StatsRecord, n - 1).when;
+		ltime = localtime (&tmp_time);
+		xstr = g_strdup_printf ("%i-%2.2i-%2.2i - %2.2i:%2.2i",
+				(ltime->tm_year) + 1900, (ltime->tm_mon) + 1, ltime->tm_mday,
+				ltime->tm_hour, ltime->tm_min);
+		ystr = g_strdup_printf ("%.2f", plot.hist.y[k]);
+		plot.mark.x[0] = plot.hist.x[k];
+		plot.mark.y[0] = plot.hist.y[k];
+	}
 	else
 	{
-		if (plot_type < 6)
-		{
-			xstr = g_strdup_printf ("%s - %s", date[n], hour[n]);
-			ystr = g_strdup_printf ("%.2f", plot.data.y[n]);
-		}
-		else if (plot_type == 6)
+		if (plot_type == 6)
 		{
 			xstr = accur_terror_char_utf8 (n);
 			ystr = g_strdup_printf ("%.0f/%.lu", plot.data.y[n], accur_error_total ());
@@ -14,8 +14,17 @@
  * Number of points for charts
  */
 #define DATA_POINTS 50
+#define PLOT_SAMPLES 4096	/* Most points drawn for the progress along the time */
 #define MAX_Y_LABELS 13
 
+/*
+ * Averages drawn along the sessions
+ */
+#define PLOT_AVER_NONE 0
+#define PLOT_AVER_MOVING 1
+#define PLOT_AVER_DAILY 2
+#define PLOT_AVER_WEEKLY 3
+
 #define PLOT_GREEN "#ddffee"
 #define PLOT_GREEN_2 "#66aa88"
 #define PLOT_GREEN_3 "#aaeebb"
@@ -36,4 +45,6 @@ void plot_initialize (void);
 
 void plot_draw_chart (gint field);
 
+void plot_zoom_update (void);
+
 void plot_pointer_update (gdouble x);
@@ -0,0 +1,501 @@
+/*****************************************************************************/
+/*  Klavaro - a flexible touch typing tutor                                  */
+/*  Copyright (C) 2005, 2006, 2007, 2008 Felipe Castro                       */
+/*  Copyright (C) 2009, 2010, 2011, 2012, 2013 The Free Software Foundation  */
+/*                                                                           */
+/*  This program is free software, licensed under the terms of the GNU       */
+/*  General Public License as published by the Free Software Foundation,     */
+/*  either version 3 of the License, or (at your option) any later version.  */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
+/*****************************************************************************/
+
+/*
+ * Leaderboard server for a local network (classrooms, labs...)
+ *
+ * It speaks the protocol of the contest server: scores files are uploaded
+ * with PUT to any path with "?lingvo=xx" and the rankings are downloaded as
+ * ".../global_xx.ksc". Point Klavaro to it with the [game] "server" preference.
+ * Rankings live in memory; every accepted record is appended to a log per
+ * language, which is replayed (and compacted) on the next start.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <gio/gio.h>
+
+#include "top10.h"
+#include "ksc.h"
+
+#define RANGILO_PORT 8080
+#define RANGILO_TIMEOUT 30	/* seconds */
+#define RANGILO_MAX_LINES 64
+#define RANGILO_MAX_LINE 2048
+#define RANGILO_MAX_BODY 65536
+
+/**************************************************
+ * Rankings
+ */
+typedef struct
+{
+	KscBoard board;
+	guint version;		/* changes after every accepted record */
+	GByteArray *page;	/* the ranking, as downloaded */
+	FILE *log;
+} Ranking;
+
+static struct
+{
+	gchar *dir;
+	gint64 started;
+	GHashTable *rankings;	/* language code -> Ranking * */
+} rangilo = { NULL, 0, NULL };
+
+static gboolean
+rangilo_lang_ok (const gchar * lang)
+{
+	return (lang != NULL && g_ascii_isalpha (lang[0]) && g_ascii_isalpha (lang[1]) && lang[2] == '\0');
+}
+
+static Ranking *
+rangilo_ranking (const gchar * lang)
+{
+	guint i;
+	gchar *tmp;
+	gchar *path;
+	GArray *stats;
+	GByteArray *buf;
+	GSequenceIter *it;
+	Ranking *rnk;
+
+	if ((rnk = g_hash_table_lookup (rangilo.rankings, lang)))
+		return (rnk);
+
+	rnk = g_new0 (Ranking, 1);
+	ksc_board_init (&rnk->board);
+
+	tmp = g_strconcat (lang, ".log", NULL);
+	path = g_build_filename (rangilo.dir, tmp, NULL);
+	g_free (tmp);
+
+	/* Replay the log, then rewrite it with only what is still ranked
+	 */
+	if ((stats = ksc_load_file (path)))
+	{
+		for (i = 0; i < stats->len; i++)
+			ksc_board_insert (&rnk->board, &g_array_index (stats, Statistics, i));
+		g_array_free (stats, TRUE);
+	}
+	buf = g_byte_array_new ();
+	it = g_sequence_get_begin_iter (rnk->board.seq);
+	for (; !g_sequence_iter_is_end (it); it = g_sequence_iter_next (it))
+		ksc_append_old (buf, g_sequence_get (it));
+	if (!g_file_set_contents (path, (gchar *) buf->data, buf->len, NULL))
+		g_warning ("Could not write the log %s", path);
+	g_byte_array_free (buf, TRUE);
+
+	rnk->log = g_fopen (path, "ab");
+	if (rnk->log == NULL)
+		g_warning ("Could not open the log %s: records won't survive a restart", path);
+	g_free (path);
+
+	g_hash_table_insert (rangilo.rankings, g_strdup (lang), rnk);
+	g_message ("%s: %u records", lang, g_sequence_get_length (rnk->board.seq));
+	return (rnk);
+}
+
+static guint
+rangilo_ranking_add (Ranking * rnk, GArray * stats)
+{
+	guint i;
+	guint n = 0;
+	GByteArray *buf;
+	Statistics *st;
+
+	buf = g_byte_array_new ();
+	for (i = 0; i < stats->len; i++)
+	{
+		st = &g_array_index (stats, Statistics, i);
+		if (ksc_board_insert (&rnk->board, st))
+		{
+			ksc_append_old (buf, st);
+			n++;
+		}
+	}
+	if (n > 0)
+	{
+		if (rnk->log)
+		{
+			fwrite (buf->data, 1, buf->len, rnk->log);
+			fflush (rnk->log);
+		}
+		rnk->version++;
+		if (rnk->page)
+			g_byte_array_free (rnk->page, TRUE);
+		rnk->page = NULL;
+	}
+	g_byte_array_free (buf, TRUE);
+	return (n);
+}
+
+/**************************************************
+ * HTTP, just what the Top 10 transfers need; one request per connection
+ */
+typedef struct
+{
+	GSocketConnection *conn;
+	GDataInputStream *in;
+	guint lines;
+	gchar *method;
+	gchar *path;
+	gchar *etag;		/* If-None-Match */
+	gboolean expect;	/* 100-continue */
+	gsize length;
+	guchar *body;
+	gsize got;
+	GString *out;
+	gsize sent;
+	gboolean last;
+} Client;
+
+static void
+rangilo_client_free (Client * cl)
+{
+	g_object_unref (cl->in);
+	g_io_stream_close (G_IO_STREAM (cl->conn), NULL, NULL);
+	g_object_unref (cl->conn);
+	g_free (cl->method);
+	g_free (cl->path);
+	g_free (cl->etag);
+	g_free (cl->body);
+	if (cl->out)
+		g_string_free (cl->out, TRUE);
+	g_free (cl);
+}
+
+static void rangilo_read_body (Client * cl);
+
+static void
+rangilo_written (GObject * stream, GAsyncResult * res, gpointer data)
+{
+	gssize n;
+	Client *cl = data;
+
+	n = g_output_stream_write_finish (G_OUTPUT_STREAM (stream), res, NULL);
+	if (n <= 0)
+	{
+		rangilo_client_free (cl);
+		return;
+	}
+	cl->sent += n;
+	if (cl->sent < cl->out->len)
+		g_output_stream_write_async (G_OUTPUT_STREAM (stream), cl->out->str + cl->sent,
+					     cl->out->len - cl->sent, G_PRIORITY_DEFAULT, NULL,
+					     rangilo_written, cl);
+	else if (cl->last)
+		rangilo_client_free (cl);
+	else
+		rangilo_read_body (cl);
+}
+
+/* 'last': the connection is closed once it is sent; else the body is read next
+ */
+static void
+rangilo_send (Client * cl, GString * out, gboolean last)
+{
+	if (cl->out)
+		g_string_free (cl->out, TRUE);
+	cl->out = out;
+	cl->sent = 0;
+	cl->last = last;
+	g_output_stream_write_async (g_io_stream_get_output_stream (G_IO_STREAM (cl->conn)),
+				     out->str, out->len, G_PRIORITY_DEFAULT, NULL, rangilo_written, cl);
+}
+
+static void
+rangilo_reply (Client * cl, gint code, const gchar * reason, const gchar * headers,
+	       const guchar * body, gsize len)
+{
+	GString *out;
+
+	out = g_string_new (NULL);
+	g_string_append_printf (out, "HTTP/1.1 %i %s\r\n", code, reason);
+	g_string_append_printf (out, "Content-Length: %" G_GSIZE_FORMAT "\r\n", body ? len : 0);
+	g_string_append (out, "Connection: close\r\n");
+	if (headers)
+		g_string_append (out, headers);
+	g_string_append (out, "\r\n");
+	if (body && g_strcmp0 (cl->method, "HEAD") != 0)
+		g_string_append_len (out, (const gchar *) body, len);
+	rangilo_send (cl, out, TRUE);
+}
+
+static void
+rangilo_download (Client * cl, const gchar * name)
+{
+	gchar *etag;
+	gchar *lang;
+	gchar *headers;
+	Ranking *rnk;
+
+	lang = g_strndup (name + strlen ("global_"), 2);
+	if (strlen (name) != strlen ("global_xx.ksc") || !g_str_has_prefix (name, "global_") ||
+	    !g_str_has_suffix (name, ".ksc") || !rangilo_lang_ok (lang))
+	{
+		g_free (lang);
+		rangilo_reply (cl, 404, "Not Found", NULL, NULL, 0);
+		return;
+	}
+	rnk = rangilo_ranking (lang);
+	g_free (lang);
+
+	etag = g_strdup_printf ("\"%" G_GINT64_FORMAT "-%u\"", rangilo.started, rnk->version);
+	headers = g_strdup_printf ("ETag: %s\r\nContent-Type: application/octet-stream\r\n", etag);
+	if (cl->etag && g_str_equal (cl->etag, etag))
+		rangilo_reply (cl, 304, "Not Modified", headers, NULL, 0);
+	else
+	{
+		if (rnk->page == NULL)
+			rnk->page = ksc_compile_old (&rnk->board);
+		rangilo_reply (cl, 200, "OK", headers, rnk->page->data, rnk->page->len);
+	}
+	g_free (headers);
+	g_free (etag);
+}
+
+static void
+rangilo_upload (Client * cl, const gchar * query)
+{
+	gint i;
+	guint n;
+	gchar *lang = NULL;
+	gchar **arg;
+	GArray *stats;
+
+	arg = g_strsplit (query ? query : "", "&", -1);
+	for (i = 0; arg[i] != NULL; i++)
+		if (g_str_has_prefix (arg[i], "lingvo="))
+			lang = g_strdup (arg[i] + strlen ("lingvo="));
+	g_strfreev (arg);
+
+	if (!rangilo_lang_ok (lang))
+	{
+		g_free (lang);
+		rangilo_reply (cl, 400, "Bad Request", NULL, (guchar *) "lingvo?\n", 8);
+		return;
+	}
+
+	n = 0;
+	if ((stats = ksc_parse (cl->body, cl->got, query)))
+	{
+		n = rangilo_ranking_add (rangilo_ranking (lang), stats);
+		g_array_free (stats, TRUE);
+	}
+	g_message ("%s: %u new records", lang, n);
+	g_free (lang);
+	rangilo_reply (cl, 200, "OK", "Content-Type: text/plain\r\n", (guchar *) "OK\n", 3);
+}
+
+static void
+rangilo_handle (Client * cl)
+{
+	gchar *name;
+	gchar *query;
+
+	query = strchr (cl->path, '?');
+	if (query)
+		*query++ = '\0';
+
+	if (g_str_equal (cl->method, "GET") || g_str_equal (cl->method, "HEAD"))
+	{
+		name = strrchr (cl->path, '/');
+		rangilo_download (cl, name ? name + 1 : cl->path);
+	}
+	else if (g_str_equal (cl->method, "PUT") || g_str_equal (cl->method, "POST"))
+		rangilo_upload (cl, query);
+	else
+		rangilo_reply (cl, 405, "Method Not Allowed", "Allow: GET, HEAD, PUT, POST\r\n", NULL, 0);
+}
+
+static void
+rangilo_body_read (GObject * stream, GAsyncResult * res, gpointer data)
+{
+	gssize n;
+	Client *cl = data;
+
+	n = g_input_stream_read_finish (G_INPUT_STREAM (stream), res, NULL);
+	if (n <= 0)
+	{
+		rangilo_client_free (cl);
+		return;
+	}
+	cl->got += n;
+	if (cl->got < cl->length)
+		rangilo_read_body (cl);
+	else
+		rangilo_handle (cl);
+}
+
+static void
+rangilo_read_body (Client * cl)
+{
+	if (cl->body == NULL)
+		cl->body = g_malloc (cl->length + 1);
+	g_input_stream_read_async (G_INPUT_STREAM (cl->in), cl->body + cl->got, cl->length - cl->got,
+				   G_PRIORITY_DEFAULT, NULL, rangilo_body_read, cl);
+}
+
+static void
+rangilo_line_read (GObject * stream, GAsyncResult * res, gpointer data)
+{
+	gsize len;
+	gchar *line;
+	gchar **word;
+	Client *cl = data;
+
+	line = g_data_input_stream_read_line_finish (G_DATA_INPUT_STREAM (stream), res, &len, NULL);
+	if (line == NULL)
+	{
+		rangilo_client_free (cl);
+		return;
+	}
+	if (len > 0 && line[len - 1] == '\r')
+		line[--len] = '\0';
+
+	if (++cl->lines > RANGILO_MAX_LINES || len > RANGILO_MAX_LINE)
+	{
+		g_free (line);
+		rangilo_reply (cl, 400, "Bad Request", NULL, NULL, 0);
+		return;
+	}
+
+	if (cl->method == NULL)
+	{
+		/* Request line */
+		word = g_strsplit (line, " ", 3);
+		if (word[0] && word[1])
+		{
+			cl->method = g_strdup (word[0]);
+			cl->path = g_strdup (word[1]);
+		}
+		g_strfreev (word);
+		if (cl->method == NULL)
+		{
+			g_free (line);
+			rangilo_reply (cl, 400, "Bad Request", NULL, NULL, 0);
+			return;
+		}
+	}
+	else if (len == 0)
+	{
+		/* End of the header */
+		g_free (line);
+		if (cl->length > RANGILO_MAX_BODY)
+			rangilo_reply (cl, 413, "Payload Too Large", NULL, NULL, 0);
+		else if (cl->length == 0)
+			rangilo_handle (cl);
+		else if (cl->expect)
+			rangilo_send (cl, g_string_new ("HTTP/1.1 100 Continue\r\n\r\n"), FALSE);
+		else
+			rangilo_read_body (cl);
+		return;
+	}
+	else if (g_ascii_strncasecmp (line, "Content-Length:", 15) == 0)
+		cl->length = g_ascii_strtoull (line + 15, NULL, 10);
+	else if (g_ascii_strncasecmp (line, "If-None-Match:", 14) == 0)
+		cl->etag = g_strstrip (g_strdup (line + 14));
+	else if (g_ascii_strncasecmp (line, "Expect:", 7) == 0)
+		cl->expect = TRUE;
+
+	g_free (line);
+	g_data_input_stream_read_line_async (cl->in, G_PRIORITY_DEFAULT, NULL, rangilo_line_read, cl);
+}
+
+static gboolean
+rangilo_incoming (GSocketService * service, GSocketConnection * conn, GObject * source,
+		  gpointer data)
+{
+	Client *cl;
+
+	g_socket_set_timeout (g_socket_connection_get_socket (conn), RANGILO_TIMEOUT);
+
+	cl = g_new0 (Client, 1);
+	cl->conn = g_object_ref (conn);
+	cl->in = g_data_input_stream_new (g_io_stream_get_input_stream (G_IO_STREAM (conn)));
+	g_data_input_stream_read_line_async (cl->in, G_PRIORITY_DEFAULT, NULL, rangilo_line_read, cl);
+	return (FALSE);
+}
+
+/**************************************************
+ * Main program
+ */
+int
+main (int argc, char *argv[])
+{
+	gint port = RANGILO_PORT;
+	gchar *dir = NULL;
+	gchar *lang;
+	const gchar *name;
+	GDir *gdir;
+	GError *gerr = NULL;
+	GMainLoop *loop;
+	GSocketService *service;
+	GOptionContext *opct;
+	GOptionEntry option[] = {
+		{"port", 'p', 0, G_OPTION_ARG_INT, &port, "TCP port to listen to", "N"},
+		{"dir", 'd', 0, G_OPTION_ARG_FILENAME, &dir, "Folder of the ranking logs", "DIR"},
+		{NULL}
+	};
+
+	opct = g_option_context_new ("- Klavaro leaderboard server");
+	g_option_context_add_main_entries (opct, option, NULL);
+	if (!g_option_context_parse (opct, &argc, &argv, &gerr))
+	{
+		g_printerr ("%s\n", gerr->message);
+		return 1;
+	}
+	g_option_context_free (opct);
+
+	rangilo.dir = dir ? dir : g_build_filename (g_get_user_data_dir (), "klavaro", "rangilo", NULL);
+	rangilo.started = g_get_real_time () / G_USEC_PER_SEC;
+	rangilo.rankings = g_hash_table_new (g_str_hash, g_str_equal);
+	if (g_mkdir_with_parents (rangilo.dir, 0755) != 0)
+	{
+		g_printerr ("Could not create %s\n", rangilo.dir);
+		return 1;
+	}
+
+	/* Load the rankings already logged
+	 */
+	if ((gdir = g_dir_open (rangilo.dir, 0, NULL)))
+	{
+		while ((name = g_dir_read_name (gdir)))
+		{
+			if (!g_str_has_suffix (name, ".log"))
+				continue;
+			lang = g_strndup (name, strlen (name) - strlen (".log"));
+			if (rangilo_lang_ok (lang))
+				rangilo_ranking (lang);
+			g_free (lang);
+		}
+		g_dir_close (gdir);
+	}
+
+	service = g_socket_service_new ();
+	if (!g_socket_listener_add_inet_port (G_SOCKET_LISTENER (service), port, NULL, &gerr))
+	{
+		g_printerr ("%s\n", gerr->message);
+		return 1;
+	}
+	g_signal_connect (service, "incoming", G_CALLBACK (rangilo_incoming), NULL);
+	g_socket_service_start (service);
+	g_message ("Serving Klavaro rankings on port %i, logs in %s", port, rangilo.dir);
+
+	loop = g_main_loop_new (NULL, FALSE);
+	g_main_loop_run (loop);
+
+	return 0;
+}
@@ -0,0 +1,1135 @@
+/*****************************************************************************/
+/*  Klavaro - a flexible touch typing tutor                                  */
+/*  Copyright (C) 2005, 2006, 2007, 2008 Felipe Castro                       */
+/*  Copyright (C) 2009, 2010, 2011, 2012, 2013 The Free Software Foundation  */
+/*                                                                           */
+/*  This program is free software, licensed under the terms of the GNU       */
+/*  General Public License as published by the Free Software Foundation,     */
+/*  either version 3 of the License, or (at your option) any later version.  */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
+/*****************************************************************************/
+
+/*
+ * Session statistics store, shown in the progress charts
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "main.h"
+#include "stats.h"
+
+/* Data file: a header and fixed size records, appended in the order of the sessions,
+ * each one pointing to the previous record of its series.
+ * Index file: the last record of every series, rebuilt from the data when stale.
+ * Names file: one name per line, the line number being the id used by the records.
+ * All numbers little-endian.
+ */
+#define STATS_DATA_FILE "sessions.dat"
+#define STATS_INDEX_FILE "sessions.idx"
+#define STATS_NAMES_FILE "sessions.names"
+#define STATS_MAGIC "KLSESS"
+#define STATS_INDEX_MAGIC "KLSIDX"
+#define STATS_VERSION 1
+#define STATS_HEADER_SIZE 32
+#define STATS_RECORD_SIZE 56
+#define STATS_SERIES_SIZE 24
+#define STATS_BLOCK_RECORDS 128
+
+typedef struct
+{
+	guint64 id;		/* module, lesson and key packed together */
+	guint32 module;
+	guint32 lesson;
+	guint32 key;
+	guint32 count;
+	guint32 first;
+	guint32 last;
+} StatsSeries;
+
+/* Records read together, backwards from the one asked for
+ */
+typedef struct
+{
+	FILE *fh;
+	guint32 first;
+	guint32 n;
+	guchar data[STATS_BLOCK_RECORDS * STATS_RECORD_SIZE];
+} StatsBlock;
+
+static struct
+{
+	gboolean loaded;
+	gboolean indexed;	/* The series are known, else they are searched from the end */
+	goffset size;		/* Of the data file, when last read */
+	gint64 mtime;
+	guint32 n;
+	GPtrArray *names;	/* id -> name */
+	GHashTable *name_ids;	/* name -> id + 1 */
+	GHashTable *series;	/* &id -> StatsSeries * */
+	GHashTable *cache;	/* series id -> StatsHistory * */
+} store;
+
+/* The text files of the previous versions, which may still be exported
+ */
+static const gchar *legacy_file[STATS_N_MODULES] = {
+	"stat_basic.txt",
+	"stat_adapt.txt",
+	"stat_velo.txt",
+	"stat_fluid.txt",
+	"scores_fluid.txt"
+};
+
+static const gchar *legacy_header[STATS_N_MODULES] = {
+	"Accuracy\tVelocity\tFluidness\tDate\tHour\tLesson\tKeyboard\tSeed\n",
+	"Accuracy\tVelocity\tFluidness\tDate\tHour\tKeyboard\tLanguage\tSeed\n",
+	"Accuracy\tVelocity\tFluidness\tDate\tHour\tLesson\tLanguage\tSeed\n",
+	"Accuracy\tVelocity\tFluidness\tDate\tHour\tLesson\tLanguage\tSeed\n",
+	"Score\tDate\tTime\tNumber of chars\tLanguage\n"
+};
+
+/**************************************************
+ * Records
+ */
+
+static guint32
+stats_get_le32 (const guchar * p)
+{
+	return ((guint32) p[0] | (guint32) p[1] << 8 | (guint32) p[2] << 16 | (guint32) p[3] << 24);
+}
+
+static void
+stats_set_le32 (guchar * p, guint32 val)
+{
+	p[0] = val & 0xff;
+	p[1] = (val >> 8) & 0xff;
+	p[2] = (val >> 16) & 0xff;
+	p[3] = (val >> 24) & 0xff;
+}
+
+static gfloat
+stats_get_float (const guchar * p)
+{
+	union { guint32 u; gfloat f; } val;
+
+	val.u = stats_get_le32 (p);
+	return (val.f);
+}
+
+static void
+stats_set_float (guchar * p, gfloat f)
+{
+	union { guint32 u; gfloat f; } val;
+
+	val.f = f;
+	stats_set_le32 (p, val.u);
+}
+
+static void
+stats_encode (guchar * p, const StatsRecord * rec)
+{
+	memset (p, 0, STATS_RECORD_SIZE);
+	stats_set_le32 (p, (guint64) rec->when & 0xffffffff);
+	stats_set_le32 (p + 4, (guint64) rec->when >> 32);
+	stats_set_le32 (p + 8, rec->seed & 0xffffffff);
+	stats_set_le32 (p + 12, rec->seed >> 32);
+	stats_set_float (p + 16, rec->accur);
+	stats_set_float (p + 20, rec->velo);
+	stats_set_float (p + 24, rec->fluid);
+	stats_set_float (p + 28, rec->score);
+	stats_set_le32 (p + 32, rec->nchars);
+	stats_set_le32 (p + 36, rec->prev);
+	stats_set_le32 (p + 40, rec->key);
+	stats_set_le32 (p + 44, rec->name);
+	p[48] = rec->module;
+	p[50] = rec->lesson & 0xff;
+	p[51] = rec->lesson >> 8;
+}
+
+static void
+stats_decode (const guchar * p, StatsRecord * rec)
+{
+	rec->when = (gint64) ((guint64) stats_get_le32 (p) | (guint64) stats_get_le32 (p + 4) << 32);
+	rec->seed = (guint64) stats_get_le32 (p + 8) | (guint64) stats_get_le32 (p + 12) << 32;
+	rec->accur = stats_get_float (p + 16);
+	rec->velo = stats_get_float (p + 20);
+	rec->fluid = stats_get_float (p + 24);
+	rec->score = stats_get_float (p + 28);
+	rec->nchars = stats_get_le32 (p + 32);
+	rec->prev = stats_get_le32 (p + 36);
+	rec->key = stats_get_le32 (p + 40);
+	rec->name = stats_get_le32 (p + 44);
+	rec->module = p[48];
+	rec->lesson = p[50] | p[51] << 8;
+}
+
+static gchar *
+stats_path (const gchar * file)
+{
+	return (g_build_filename (main_path_stats (), file, NULL));
+}
+
+static gboolean
+stats_block_open (StatsBlock * blk)
+{
+	gchar *file;
+
+	file = stats_path (STATS_DATA_FILE);
+	blk->fh = (FILE *) g_fopen (file, "rb");
+	g_free (file);
+	if (blk->fh == NULL)
+		return (FALSE);
+	/* The blocks are the buffer */
+	setvbuf (blk->fh, NULL, _IONBF, 0);
+	blk->first = 0;
+	blk->n = 0;
+	return (TRUE);
+}
+
+/* Raw record recno: the charts go from the end to the beginning, so a block
+ * is read with the record asked for at its end
+ */
+static const guchar *
+stats_block_get (StatsBlock * blk, guint32 recno)
+{
+	if (recno >= store.n)
+		return (NULL);
+
+	if (recno < blk->first || recno >= blk->first + blk->n)
+	{
+		blk->first = (recno + 1 > STATS_BLOCK_RECORDS) ? recno + 1 - STATS_BLOCK_RECORDS : 0;
+		blk->n = recno + 1 - blk->first;
+		if (fseek (blk->fh, STATS_HEADER_SIZE + (glong) blk->first * STATS_RECORD_SIZE, SEEK_SET) != 0 ||
+		    fread (blk->data, STATS_RECORD_SIZE, blk->n, blk->fh) != blk->n)
+		{
+			blk->n = 0;
+			return (NULL);
+		}
+	}
+	return (blk->data + (recno - blk->first) * STATS_RECORD_SIZE);
+}
+
+/**************************************************
+ * Series index
+ */
+
+static guint64
+stats_series_id (guint32 module, guint32 lesson, guint32 key)
+{
+	return ((guint64) (module & 0xff) << 48 | (guint64) (lesson & 0xffff) << 32 | key);
+}
+
+static StatsSeries *
+stats_series_get (guint32 module, guint32 lesson, guint32 key, gboolean create)
+{
+	guint64 id;
+	StatsSeries *ser;
+
+	id = stats_series_id (module, lesson, key);
+	ser = g_hash_table_lookup (store.series, &id);
+	if (ser != NULL || !create)
+		return (ser);
+
+	ser = g_new0 (StatsSeries, 1);
+	ser->id = id;
+	ser->module = module;
+	ser->lesson = lesson;
+	ser->key = key;
+	ser->first = STATS_NONE;
+	ser->last = STATS_NONE;
+	g_hash_table_insert (store.series, &ser->id, ser);
+	return (ser);
+}
+
+/* Chain a new record, number recno, to the end of its series
+ */
+static void
+stats_series_link (StatsRecord * rec, guint32 recno)
+{
+	StatsSeries *ser;
+
+	ser = stats_series_get (rec->module, rec->lesson, rec->key, TRUE);
+	rec->prev = ser->last;
+	if (ser->first == STATS_NONE)
+		ser->first = recno;
+	ser->last = recno;
+	ser->count++;
+}
+
+static gboolean
+stats_read_index ()
+{
+	gsize len;
+	gsize i;
+	guint32 n_series;
+	gchar *file;
+	gchar *data;
+	guchar *p;
+	StatsSeries *ser;
+
+	file = stats_path (STATS_INDEX_FILE);
+	if (!g_file_get_contents (file, &data, &len, NULL))
+	{
+		g_free (file);
+		return (FALSE);
+	}
+	g_free (file);
+
+	p = (guchar *) data;
+	n_series = len < STATS_HEADER_SIZE ? 0 : stats_get_le32 (p + 16);
+	if (len < STATS_HEADER_SIZE || memcmp (p, STATS_INDEX_MAGIC, strlen (STATS_INDEX_MAGIC)) != 0 ||
+	    stats_get_le32 (p + 8) != STATS_VERSION || stats_get_le32 (p + 12) != store.n ||
+	    len != STATS_HEADER_SIZE + (gsize) n_series * STATS_SERIES_SIZE)
+	{
+		g_free (data);
+		return (FALSE);
+	}
+
+	for (i = 0; i < n_series; i++)
+	{
+		p = (guchar *) data + STATS_HEADER_SIZE + i * STATS_SERIES_SIZE;
+		ser = stats_series_get (stats_get_le32 (p), stats_get_le32 (p + 4),
+				stats_get_le32 (p + 8), TRUE);
+		ser->count = stats_get_le32 (p + 12);
+		ser->first = stats_get_le32 (p + 16);
+		ser->last = stats_get_le32 (p + 20);
+	}
+	g_free (data);
+	return (TRUE);
+}
+
+static void
+stats_write_index ()
+{
+	gchar *file;
+	guchar *p;
+	GByteArray *buf;
+	GHashTableIter iter;
+	StatsSeries *ser;
+	const guchar header[STATS_HEADER_SIZE] = STATS_INDEX_MAGIC;
+
+	buf = g_byte_array_sized_new (STATS_HEADER_SIZE +
+			g_hash_table_size (store.series) * STATS_SERIES_SIZE);
+	g_byte_array_append (buf, header, STATS_HEADER_SIZE);
+	stats_set_le32 (buf->data + 8, STATS_VERSION);
+	stats_set_le32 (buf->data + 12, store.n);
+	stats_set_le32 (buf->data + 16, g_hash_table_size (store.series));
+
+	g_hash_table_iter_init (&iter, store.series);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &ser))
+	{
+		g_byte_array_set_size (buf, buf->len + STATS_SERIES_SIZE);
+		p = buf->data + buf->len - STATS_SERIES_SIZE;
+		stats_set_le32 (p, ser->module);
+		stats_set_le32 (p + 4, ser->lesson);
+		stats_set_le32 (p + 8, ser->key);
+		stats_set_le32 (p + 12, ser->count);
+		stats_set_le32 (p + 16, ser->first);
+		stats_set_le32 (p + 20, ser->last);
+	}
+
+	file = stats_path (STATS_INDEX_FILE);
+	if (!g_file_set_contents (file, (gchar *) buf->data, buf->len, NULL))
+		g_message ("not able to write the statistics index:\n %s", file);
+	g_free (file);
+	g_byte_array_free (buf, TRUE);
+}
+
+/* Only when the index is missing or out of date: a single pass over the records
+ */
+static void
+stats_rebuild_index ()
+{
+	guint32 i;
+	gsize len;
+	const guchar *data;
+	gchar *file;
+	GMappedFile *mf;
+	StatsRecord rec;
+
+	file = stats_path (STATS_DATA_FILE);
+	mf = g_mapped_file_new (file, FALSE, NULL);
+	g_free (file);
+	if (mf == NULL)
+		return;
+
+	data = (const guchar *) g_mapped_file_get_contents (mf);
+	len = g_mapped_file_get_length (mf);
+	g_hash_table_remove_all (store.series);
+	for (i = 0; i < store.n && STATS_HEADER_SIZE + (gsize) (i + 1) * STATS_RECORD_SIZE <= len; i++)
+	{
+		stats_decode (data + STATS_HEADER_SIZE + (gsize) i * STATS_RECORD_SIZE, &rec);
+		stats_series_link (&rec, i);
+	}
+	g_mapped_file_unref (mf);
+}
+
+/**************************************************
+ * Names
+ */
+
+static void
+stats_read_names ()
+{
+	gint i;
+	gchar *file;
+	gchar *data;
+	gchar **lines;
+
+	file = stats_path (STATS_NAMES_FILE);
+	if (g_file_get_contents (file, &data, NULL, NULL))
+	{
+		/* The last piece is empty, or else an unfinished line */
+		lines = g_strsplit (data, "\n", -1);
+		for (i = 0; lines[i] && lines[i + 1]; i++)
+		{
+			g_ptr_array_add (store.names, g_strdup (lines[i]));
+			g_hash_table_insert (store.name_ids, g_ptr_array_index (store.names, i),
+					GUINT_TO_POINTER (i + 1));
+		}
+		g_strfreev (lines);
+		g_free (data);
+	}
+	g_free (file);
+}
+
+static guint32
+stats_name_lookup (const gchar * name)
+{
+	gpointer id;
+
+	id = g_hash_table_lookup (store.name_ids, name);
+	return (id ? GPOINTER_TO_UINT (id) - 1 : STATS_NONE);
+}
+
+static guint32
+stats_name_add (const gchar * name)
+{
+	gchar *tmp;
+	gchar *file;
+	guint32 id;
+	FILE *fh;
+
+	if (name == NULL)
+		return (STATS_NONE);
+	id = stats_name_lookup (name);
+	if (id != STATS_NONE)
+		return (id);
+
+	/* Names are kept free of the separators of the exported text files */
+	tmp = g_strdelimit (g_strdup (name), "\t\r\n", '_');
+	id = stats_name_lookup (tmp);
+	if (id != STATS_NONE)
+	{
+		g_free (tmp);
+		return (id);
+	}
+
+	file = stats_path (STATS_NAMES_FILE);
+	fh = (FILE *) g_fopen (file, "a");
+	if (fh == NULL)
+	{
+		g_message ("not able to write on this file:\n %s", file);
+		g_free (file);
+		g_free (tmp);
+		return (STATS_NONE);
+	}
+	fprintf (fh, "%s\n", tmp);
+	fclose (fh);
+	g_free (file);
+
+	id = store.names->len;
+	g_ptr_array_add (store.names, tmp);
+	g_hash_table_insert (store.name_ids, tmp, GUINT_TO_POINTER (id + 1));
+	return (id);
+}
+
+/**************************************************
+ * Migration of the text files
+ */
+
+static gint64
+stats_parse_time (const gchar * date, const gchar * hour)
+{
+	gint y, m, d, h, min;
+	struct tm ltime;
+
+	if (sscanf (date, "%d-%d-%d", &y, &m, &d) != 3)
+		return (-1);
+	if (sscanf (hour, "%d:%d", &h, &min) != 2)
+		return (-1);
+
+	memset (&ltime, 0, sizeof (struct tm));
+	ltime.tm_year = y - 1900;
+	ltime.tm_mon = m - 1;
+	ltime.tm_mday = d;
+	ltime.tm_hour = h;
+	ltime.tm_min = min;
+	ltime.tm_isdst = -1;
+	return ((gint64) mktime (&ltime));
+}
+
+/* Parse one of the old text files, appending its records to buf
+ */
+static void
+stats_migrate_file (gint module, const gchar * file, GByteArray * buf)
+{
+	gint i;
+	guint ncols;
+	gchar *data;
+	gchar **lines;
+	gchar **col;
+	StatsRecord rec;
+
+	if (!g_file_get_contents (file, &data, NULL, NULL))
+		return;
+
+	lines = g_strsplit (data, "\n", -1);
+	g_free (data);
+	for (i = 1; lines[0] && lines[i]; i++)
+	{
+		g_strchomp (lines[i]);
+		col = g_strsplit (lines[i], "\t", -1);
+		ncols = g_strv_length (col);
+		memset (&rec, 0, sizeof (StatsRecord));
+		rec.module = module;
+		rec.name = STATS_NONE;
+		if (module == STATS_SCORES)
+		{
+			if (ncols < 4 || (rec.when = stats_parse_time (col[1], col[2])) < 0)
+			{
+				g_strfreev (col);
+				continue;
+			}
+			rec.score = g_ascii_strtod (col[0], NULL);
+			rec.nchars = g_ascii_strtoll (col[3], NULL, 10);
+			rec.key = stats_name_add (ncols > 4 ? col[4] : "");
+		}
+		else
+		{
+			if (ncols < 6 || (rec.when = stats_parse_time (col[3], col[4])) < 0)
+			{
+				g_strfreev (col);
+				continue;
+			}
+			rec.accur = g_ascii_strtod (col[0], NULL);
+			rec.velo = g_ascii_strtod (col[1], NULL);
+			rec.fluid = g_ascii_strtod (col[2], NULL);
+			if (ncols > 7)
+				rec.seed = g_ascii_strtoull (col[7], NULL, 10);
+			switch (module)
+			{
+			case 0:	/* Basic: lesson, keyboard */
+				rec.lesson = g_ascii_strtoll (col[5], NULL, 10);
+				rec.key = stats_name_add (ncols > 6 ? col[6] : "");
+				break;
+			case 1:	/* Adaptability: keyboard, language */
+				rec.key = stats_name_add (col[5]);
+				rec.name = stats_name_add (ncols > 6 ? col[6] : "");
+				break;
+			default:	/* Dictionary or paragraphs, language */
+				rec.name = stats_name_add (col[5]);
+				rec.key = stats_name_add (ncols > 6 ? col[6] : "");
+			}
+		}
+		g_strfreev (col);
+		if (rec.key == STATS_NONE)
+			continue;
+
+		stats_series_link (&rec, store.n);
+		g_byte_array_set_size (buf, buf->len + STATS_RECORD_SIZE);
+		stats_encode (buf->data + buf->len - STATS_RECORD_SIZE, &rec);
+		store.n++;
+	}
+	g_strfreev (lines);
+}
+
+/* Create the data file, with the sessions of the old text files, if any
+ */
+static gboolean
+stats_migrate ()
+{
+	gint i;
+	gchar *file;
+	gchar *bak;
+	gboolean success;
+	GByteArray *buf;
+	const guchar header[STATS_HEADER_SIZE] = STATS_MAGIC;
+
+	/* Names of an unfinished previous attempt would only be orphans */
+	file = stats_path (STATS_NAMES_FILE);
+	g_unlink (file);
+	g_free (file);
+
+	buf = g_byte_array_new ();
+	g_byte_array_append (buf, header, STATS_HEADER_SIZE);
+	stats_set_le32 (buf->data + 8, STATS_VERSION);
+	stats_set_le32 (buf->data + 12, STATS_RECORD_SIZE);
+	for (i = 0; i < STATS_N_MODULES; i++)
+	{
+		file = stats_path (legacy_file[i]);
+		stats_migrate_file (i, file, buf);
+		g_free (file);
+	}
+
+	file = stats_path (STATS_DATA_FILE);
+	success = g_file_set_contents (file, (gchar *) buf->data, buf->len, NULL);
+	if (!success)
+		g_warning ("not able to create the statistics file:\n %s", file);
+	g_free (file);
+	g_byte_array_free (buf, TRUE);
+	if (!success)
+		return (FALSE);
+
+	/* Keep the old files as backups, out of the way of a new migration */
+	for (i = 0; i < STATS_N_MODULES; i++)
+	{
+		file = stats_path (legacy_file[i]);
+		if (g_file_test (file, G_FILE_TEST_IS_REGULAR))
+		{
+			bak = g_strconcat (file, ".bak", NULL);
+			if (g_rename (file, bak) == 0)
+				g_message ("statistics migrated, the old file now is:\n %s", bak);
+			g_free (bak);
+		}
+		g_free (file);
+	}
+	return (TRUE);
+}
+
+/**************************************************
+ * Series history and its analytics
+ */
+
+gfloat
+stats_record_value (const StatsRecord * rec, gint value)
+{
+	switch (value)
+	{
+	case 0:
+		return (rec->accur);
+	case 1:
+		return (rec->velo);
+	case 2:
+		return (rec->fluid);
+	}
+	return (rec->score);
+}
+
+/* Days from the first session of the history to session i
+ */
+gdouble
+stats_history_days (StatsHistory * hist, gint i)
+{
+	return ((g_array_index (hist->recs, StatsRecord, i).when -
+		 g_array_index (hist->recs, StatsRecord, 0).when) / 86400.0);
+}
+
+static void
+stats_bucket_add (GArray * buckets, gint period, gint i, gfloat val)
+{
+	StatsBucket *bk;
+	StatsBucket new_bk;
+
+	bk = buckets->len ? &g_array_index (buckets, StatsBucket, buckets->len - 1) : NULL;
+	if (bk != NULL && bk->period == period)
+	{
+		bk->last = i;
+		bk->count++;
+		bk->sum += val;
+		return;
+	}
+	new_bk.period = period;
+	new_bk.last = i;
+	new_bk.count = 1;
+	new_bk.sum = val;
+	g_array_append_val (buckets, new_bk);
+}
+
+/* Account session i, the last one of the history, in constant time
+ */
+static void
+stats_history_add (StatsHistory * hist, gint i)
+{
+	gint v;
+	gint day;
+	gfloat val;
+	gfloat avg;
+	gdouble x;
+	time_t tmp_time;
+	struct tm *ltime;
+	GDate date;
+	StatsRecord *rec;
+	StatsTrend *tr;
+
+	rec = &g_array_index (hist->recs, StatsRecord, i);
+	tmp_time = (time_t) rec->when;
+	ltime = localtime (&tmp_time);
+	g_date_clear (&date, 1);
+	g_date_set_dmy (&date, ltime->tm_mday, (GDateMonth) (ltime->tm_mon + 1), ltime->tm_year + 1900);
+	day = g_date_get_julian (&date);
+	x = stats_history_days (hist, i);
+
+	for (v = 0; v < STATS_N_VALUES; v++)
+	{
+		tr = &hist->trend[v];
+		val = stats_record_value (rec, v);
+
+		tr->moving_sum += val;
+		if (i >= STATS_MOVING_WINDOW)
+			tr->moving_sum -= stats_record_value (&g_array_index (hist->recs, StatsRecord,
+						i - STATS_MOVING_WINDOW), v);
+		avg = tr->moving_sum / MIN (i + 1, STATS_MOVING_WINDOW);
+		g_array_append_val (tr->moving, avg);
+
+		/* Julian day 1 is a Monday */
+		stats_bucket_add (tr->daily, day, i, val);
+		stats_bucket_add (tr->weekly, (day - 1) / 7, i, val);
+
+		tr->sx += x;
+		tr->sy += val;
+		tr->sxx += x * x;
+		tr->sxy += x * val;
+	}
+}
+
+static StatsHistory *
+stats_history_new (GArray * recs)
+{
+	gint v;
+	guint i;
+	StatsHistory *hist;
+
+	hist = g_new0 (StatsHistory, 1);
+	hist->ref = 1;
+	hist->recs = recs;
+	for (v = 0; v < STATS_N_VALUES; v++)
+	{
+		hist->trend[v].moving = g_array_sized_new (FALSE, FALSE, sizeof (gfloat), recs->len);
+		hist->trend[v].daily = g_array_new (FALSE, FALSE, sizeof (StatsBucket));
+		hist->trend[v].weekly = g_array_new (FALSE, FALSE, sizeof (StatsBucket));
+	}
+	for (i = 0; i < recs->len; i++)
+		stats_history_add (hist, i);
+	return (hist);
+}
+
+void
+stats_history_unref (StatsHistory * hist)
+{
+	gint v;
+
+	if (hist == NULL || --hist->ref > 0)
+		return;
+	for (v = 0; v < STATS_N_VALUES; v++)
+	{
+		g_array_free (hist->trend[v].moving, TRUE);
+		g_array_free (hist->trend[v].daily, TRUE);
+		g_array_free (hist->trend[v].weekly, TRUE);
+	}
+	g_array_free (hist->recs, TRUE);
+	g_free (hist);
+}
+
+/* Least squares line of a value along the time: value = a + b * days
+ */
+gboolean
+stats_trend_fit (StatsHistory * hist, gint value, gdouble * a, gdouble * b)
+{
+	gdouble n;
+	gdouble den;
+	StatsTrend *tr;
+
+	tr = &hist->trend[value];
+	n = hist->recs->len;
+	den = n * tr->sxx - tr->sx * tr->sx;
+	if (n < 2 || den < 1.0e-9)
+		return (FALSE);
+	*b = (n * tr->sxy - tr->sx * tr->sy) / den;
+	*a = (tr->sy - *b * tr->sx) / n;
+	return (TRUE);
+}
+
+/**************************************************
+ * Loading
+ */
+
+static void
+stats_clear ()
+{
+	if (store.names == NULL)
+	{
+		store.names = g_ptr_array_new_with_free_func (g_free);
+		store.name_ids = g_hash_table_new (g_str_hash, g_str_equal);
+		store.series = g_hash_table_new_full (g_int64_hash, g_int64_equal, NULL, g_free);
+		store.cache = g_hash_table_new_full (g_int64_hash, g_int64_equal, g_free,
+				(GDestroyNotify) stats_history_unref);
+	}
+	g_hash_table_remove_all (store.name_ids);
+	g_ptr_array_set_size (store.names, 0);
+	g_hash_table_remove_all (store.series);
+	g_hash_table_remove_all (store.cache);
+	store.n = 0;
+	store.size = 0;
+	store.loaded = FALSE;
+	store.indexed = FALSE;
+}
+
+/* Nothing is done while the data file keeps the size and time we know of,
+ * else everything is read again, and the series cached are dropped
+ */
+static gboolean
+stats_load ()
+{
+	gchar *file;
+	guchar header[STATS_HEADER_SIZE];
+	gboolean valid;
+	FILE *fh;
+	GStatBuf fs;
+
+	file = stats_path (STATS_DATA_FILE);
+	if (g_stat (file, &fs) == 0 && store.loaded && fs.st_size == store.size &&
+	    fs.st_mtime == store.mtime)
+	{
+		g_free (file);
+		return (TRUE);
+	}
+
+	stats_clear ();
+	if (!g_file_test (file, G_FILE_TEST_IS_REGULAR))
+	{
+		if (!stats_migrate ())
+		{
+			g_free (file);
+			return (FALSE);
+		}
+		stats_write_index ();
+		store.indexed = TRUE;
+		g_stat (file, &fs);
+		store.size = fs.st_size;
+		store.mtime = fs.st_mtime;
+		store.loaded = TRUE;
+		g_free (file);
+		return (TRUE);
+	}
+
+	valid = FALSE;
+	if ((fh = (FILE *) g_fopen (file, "rb")))
+	{
+		valid = fread (header, STATS_HEADER_SIZE, 1, fh) == 1 &&
+			memcmp (header, STATS_MAGIC, strlen (STATS_MAGIC)) == 0 &&
+			stats_get_le32 (header + 8) == STATS_VERSION &&
+			stats_get_le32 (header + 12) == STATS_RECORD_SIZE;
+		fclose (fh);
+	}
+	if (!valid || g_stat (file, &fs) != 0)
+	{
+		g_warning ("invalid statistics file:\n %s", file);
+		g_free (file);
+		return (FALSE);
+	}
+	g_free (file);
+
+	store.size = fs.st_size;
+	store.mtime = fs.st_mtime;
+	store.n = (fs.st_size - STATS_HEADER_SIZE) / STATS_RECORD_SIZE;
+	stats_read_names ();
+	store.indexed = stats_read_index ();
+	store.loaded = TRUE;
+	return (TRUE);
+}
+
+/**************************************************
+ * Interface functions
+ */
+guint32
+stats_intern (const gchar * name)
+{
+	if (!stats_load ())
+		return (STATS_NONE);
+	return (stats_name_add (name));
+}
+
+const gchar *
+stats_get_name (guint32 id)
+{
+	if (store.names == NULL || id >= store.names->len)
+		return ("");
+	return (g_ptr_array_index (store.names, id));
+}
+
+/* Append a session, the text columns already interned
+ */
+gboolean
+stats_append (StatsRecord * rec)
+{
+	gchar *file;
+	guchar p[STATS_RECORD_SIZE];
+	gboolean success;
+	guint64 id;
+	FILE *fh;
+	StatsHistory *hist;
+	GStatBuf fs;
+
+	if (!stats_load () || rec->key == STATS_NONE)
+		return (FALSE);
+
+	/* The writer needs the ends of all the series */
+	if (!store.indexed)
+	{
+		stats_rebuild_index ();
+		stats_write_index ();
+		store.indexed = TRUE;
+	}
+
+	file = stats_path (STATS_DATA_FILE);
+	/* Written right after the last whole record: what a torn write left is overwritten */
+	fh = (FILE *) g_fopen (file, "r+b");
+	if (fh != NULL && fseek (fh, STATS_HEADER_SIZE + (glong) store.n * STATS_RECORD_SIZE, SEEK_SET) != 0)
+	{
+		fclose (fh);
+		fh = NULL;
+	}
+	if (fh == NULL)
+	{
+		g_message ("not able to log on this file:\n %s", file);
+		g_free (file);
+		return (FALSE);
+	}
+	stats_series_link (rec, store.n);
+	stats_encode (p, rec);
+	success = fwrite (p, STATS_RECORD_SIZE, 1, fh) == 1;
+	if (fclose (fh) != 0)
+		success = FALSE;
+	if (!success)
+	{
+		/* Read it all again next time */
+		g_message ("not able to log on this file:\n %s", file);
+		store.loaded = FALSE;
+	}
+	else
+	{
+		store.n++;
+		if (g_stat (file, &fs) == 0)
+		{
+			store.size = fs.st_size;
+			store.mtime = fs.st_mtime;
+		}
+		stats_write_index ();
+
+		/* The series cached goes on being valid */
+		id = stats_series_id (rec->module, rec->lesson, rec->key);
+		if ((hist = g_hash_table_lookup (store.cache, &id)))
+		{
+			g_array_append_val (hist->recs, *rec);
+			stats_history_add (hist, hist->recs->len - 1);
+		}
+	}
+	g_free (file);
+	return (success);
+}
+
+/* Without the index, the last record of a series is searched from the end of the file
+ */
+static guint32
+stats_find_last (StatsBlock * blk, guint32 module, guint32 lesson, guint32 key)
+{
+	guint32 recno;
+	const guchar *p;
+
+	for (recno = store.n; recno-- > 0;)
+	{
+		if ((p = stats_block_get (blk, recno)) == NULL)
+			break;
+		if (p[48] == module && (guint32) (p[50] | p[51] << 8) == lesson &&
+		    stats_get_le32 (p + 40) == key)
+			return (recno);
+	}
+	return (STATS_NONE);
+}
+
+/* The whole history of a series, oldest first, to be released with stats_history_unref.
+ * It is read once and kept, while the data file doesn't change but for the sessions
+ * appended here: so all the charts of a series share the same records and analytics.
+ */
+StatsHistory *
+stats_get_history (gint module, gint lesson, const gchar * key)
+{
+	guint32 key_id;
+	guint32 recno;
+	guint64 id;
+	gint i;
+	const guchar *p;
+	StatsRecord rec;
+	StatsRecord tmp;
+	StatsBlock blk;
+	StatsSeries *ser;
+	StatsHistory *hist;
+	GArray *recs;
+
+	if (!stats_load ())
+		return (NULL);
+	key_id = stats_name_lookup (key);
+	if (key_id == STATS_NONE)
+		return (NULL);
+	id = stats_series_id (module, lesson, key_id);
+	if ((hist = g_hash_table_lookup (store.cache, &id)))
+	{
+		hist->ref++;
+		return (hist);
+	}
+	if (!stats_block_open (&blk))
+		return (NULL);
+
+	ser = NULL;
+	if (store.indexed)
+	{
+		ser = stats_series_get (module, lesson, key_id, FALSE);
+		recno = ser ? ser->last : STATS_NONE;
+	}
+	else
+		recno = stats_find_last (&blk, module, lesson, key_id);
+
+	recs = g_array_sized_new (FALSE, FALSE, sizeof (StatsRecord), ser ? ser->count : 64);
+	for (; (p = stats_block_get (&blk, recno)) && recs->len < store.n; recno = rec.prev)
+	{
+		stats_decode (p, &rec);
+		g_array_append_val (recs, rec);
+	}
+	fclose (blk.fh);
+
+	/* Read from the end */
+	for (i = 0; i < (gint) recs->len / 2; i++)
+	{
+		tmp = g_array_index (recs, StatsRecord, i);
+		g_array_index (recs, StatsRecord, i) = g_array_index (recs, StatsRecord, recs->len - 1 - i);
+		g_array_index (recs, StatsRecord, recs->len - 1 - i) = tmp;
+	}
+	hist = stats_history_new (recs);
+	g_hash_table_insert (store.cache, g_memdup (&id, sizeof (guint64)), hist);
+	hist->ref++;
+	return (hist);
+}
+
+static void
+stats_format_time (gint64 when, gchar * date, gchar * hour)
+{
+	time_t tmp_time;
+	struct tm *ltime;
+
+	tmp_time = (time_t) when;
+	ltime = localtime (&tmp_time);
+	g_snprintf (date, 32, "%i-%2.2i-%2.2i", (ltime->tm_year) + 1900, (ltime->tm_mon) + 1, ltime->tm_mday);
+	g_snprintf (hour, 16, "%2.2i:%2.2i", ltime->tm_hour, ltime->tm_min);
+}
+
+/* Write the sessions as the text files of the previous versions, into dir
+ */
+gboolean
+stats_export_tsv (const gchar * dir)
+{
+	gint m;
+	guint32 i;
+	gsize len;
+	gchar *file;
+	gchar date[32];
+	gchar hour[16];
+	gchar num[3][G_ASCII_DTOSTR_BUF_SIZE];
+	gboolean success = TRUE;
+	const guchar *data;
+	FILE *fh[STATS_N_MODULES] = { NULL };
+	GMappedFile *mf;
+	StatsRecord rec;
+
+	if (!stats_load ())
+		return (FALSE);
+
+	file = stats_path (STATS_DATA_FILE);
+	mf = g_mapped_file_new (file, FALSE, NULL);
+	g_free (file);
+	if (mf == NULL)
+		return (FALSE);
+	data = (const guchar *) g_mapped_file_get_contents (mf);
+	len = g_mapped_file_get_length (mf);
+
+	g_mkdir_with_parents (dir, DIR_PERM);
+	for (i = 0; STATS_HEADER_SIZE + (gsize) (i + 1) * STATS_RECORD_SIZE <= len; i++)
+	{
+		stats_decode (data + STATS_HEADER_SIZE + (gsize) i * STATS_RECORD_SIZE, &rec);
+		m = rec.module;
+		if (m >= STATS_N_MODULES)
+			continue;
+		if (fh[m] == NULL)
+		{
+			file = g_build_filename (dir, legacy_file[m], NULL);
+			fh[m] = (FILE *) g_fopen (file, "w");
+			if (fh[m] == NULL)
+			{
+				g_warning ("not able to export on this file:\n %s", file);
+				g_free (file);
+				success = FALSE;
+				break;
+			}
+			g_message ("exporting statistics to:\n %s", file);
+			g_free (file);
+			fputs (legacy_header[m], fh[m]);
+		}
+
+		stats_format_time (rec.when, date, hour);
+		if (m == STATS_SCORES)
+		{
+			fprintf (fh[m], "%s\t%s\t%s\t%i\t%s\n",
+				 g_ascii_formatd (num[0], G_ASCII_DTOSTR_BUF_SIZE, "%3.4f", rec.score),
+				 date, hour, rec.nchars, stats_get_name (rec.key));
+			continue;
+		}
+		fprintf (fh[m], "%s\t%s\t%s\t%s\t%s\t",
+			 g_ascii_formatd (num[0], G_ASCII_DTOSTR_BUF_SIZE, "%.2f", rec.accur),
+			 g_ascii_formatd (num[1], G_ASCII_DTOSTR_BUF_SIZE, "%.2f", rec.velo),
+			 g_ascii_formatd (num[2], G_ASCII_DTOSTR_BUF_SIZE, "%.2f", rec.fluid),
+			 date, hour);
+		if (m == 0)
+			fprintf (fh[m], "%2.2i\t%s\t", rec.lesson, stats_get_name (rec.key));
+		else if (m == 1)
+			fprintf (fh[m], "%s\t%s\t", stats_get_name (rec.key), stats_get_name (rec.name));
+		else
+			fprintf (fh[m], "%s\t%s\t", stats_get_name (rec.name), stats_get_name (rec.key));
+		fprintf (fh[m], "%" G_GUINT64_FORMAT "\n", rec.seed);
+	}
+	g_mapped_file_unref (mf);
+
+	for (m = 0; m < STATS_N_MODULES; m++)
+		if (fh[m] && fclose (fh[m]) != 0)
+			success = FALSE;
+	return (success);
+}
+
+/* Delete all the sessions, and the text files of old versions which still log there
+ */
+void
+stats_reset ()
+{
+	gint i;
+	gchar *file;
+
+	for (i = 0; i < STATS_N_MODULES; i++)
+	{
+		file = stats_path (legacy_file[i]);
+		g_unlink (file);
+		g_free (file);
+	}
+	file = stats_path (STATS_DATA_FILE);
+	g_unlink (file);
+	g_free (file);
+	file = stats_path (STATS_INDEX_FILE);
+	g_unlink (file);
+	g_free (file);
+	file = stats_path (STATS_NAMES_FILE);
+	g_unlink (file);
+	g_free (file);
+	stats_clear ();
+}
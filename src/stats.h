@@ -0,0 +1,89 @@
+/*****************************************************************************/
+/*  Klavaro - a flexible touch typing tutor                                  */
+/*  Copyright (C) 2005, 2006, 2007, 2008 Felipe Castro                       */
+/*  Copyright (C) 2009, 2010, 2011, 2012, 2013 The Free Software Foundation  */
+/*                                                                           */
+/*  This program is free software, licensed under the terms of the GNU       */
+/*  General Public License as published by the Free Software Foundation,     */
+/*  either version 3 of the License, or (at your option) any later version.  */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    */
+/*****************************************************************************/
+
+/**************************************************
+ * Session statistics store
+ */
+#define STATS_SCORES 4		/* Module of the fluidness scores, after the tutor types */
+#define STATS_N_MODULES 5
+#define STATS_NONE 0xffffffff	/* No name or no previous record */
+#define STATS_N_VALUES 4	/* Accuracy, velocity, fluidness and score */
+#define STATS_MOVING_WINDOW 10	/* Sessions in the moving average */
+
+/* A session: the series it belongs to is (module, lesson, key), where the key is
+ * the keyboard for the basic and adaptability modules, otherwise the language.
+ * The name is the other text column of the old files: the language for adaptability,
+ * the dictionary or the paragraphs for velocity and fluidness.
+ */
+typedef struct
+{
+	gint64 when;
+	guint64 seed;
+	gfloat accur;
+	gfloat velo;
+	gfloat fluid;
+	gfloat score;
+	gint32 nchars;
+	guint32 prev;		/* Previous record of the same series */
+	guint32 key;
+	guint32 name;
+	guint8 module;
+	guint16 lesson;
+} StatsRecord;
+
+/* Sessions of one day, or of one week
+ */
+typedef struct
+{
+	gint period;		/* Julian day, or week */
+	gint last;		/* Index of its last session */
+	gint count;
+	gdouble sum;
+} StatsBucket;
+
+/* Analytics of one of the values along a series, updated session by session
+ */
+typedef struct
+{
+	GArray *moving;		/* gfloat, the moving average at each session */
+	GArray *daily;		/* StatsBucket */
+	GArray *weekly;		/* StatsBucket */
+	gdouble moving_sum;
+	gdouble sx, sy, sxx, sxy;	/* Least squares sums, x in days since the first session */
+} StatsTrend;
+
+typedef struct
+{
+	gint ref;
+	GArray *recs;		/* StatsRecord, oldest first */
+	StatsTrend trend[STATS_N_VALUES];
+} StatsHistory;
+
+guint32 stats_intern (const gchar * name);
+
+const gchar *stats_get_name (guint32 id);
+
+gboolean stats_append (StatsRecord * rec);
+
+gfloat stats_record_value (const StatsRecord * rec, gint value);
+
+StatsHistory *stats_get_history (gint module, gint lesson, const gchar * key);
+
+void stats_history_unref (StatsHistory * hist);
+
+gdouble stats_history_days (StatsHistory * hist, gint i);
+
+gboolean stats_trend_fit (StatsHistory * hist, gint value, gdouble * a, gdouble * b);
+
+gboolean stats_export_tsv (const gchar * dir);
+
+void stats_reset (void);
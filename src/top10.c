@@ -30,12 +30,13 @@
 #include "main.h"
 #include "translation.h"
 #include "top10.h"
+#include "ksc.h"
 
 /**************************************************
  * Variables
  */
-Statistics top10_local[10];
-Statistics top10_global[10];
+static KscBoard board_local = { NULL, NULL };
+static KscBoard board_global = { NULL, NULL };
 GKeyFile *keyfile = NULL;
 
 /**************************************************
@@ -69,7 +70,7 @@ top10_init ()
 	column = gtk_tree_view_column_new_with_attributes (_("Score"), renderer, "text", 2, NULL);
 	gtk_tree_view_append_column (tv, column);
 
-	for (i = 0; i < 10; i++)
+	for (i = 0; i < TOP10_SHOWN; i++)
 	{
 		str = g_strdup_printf ("%02i", i + 1);
 		gtk_list_store_append (list, &iter);
@@ -95,7 +96,7 @@ top10_init ()
 	column = gtk_tree_view_column_new_with_attributes (_("When"), renderer, "text", 4, NULL);
 	gtk_tree_view_append_column (tv, column);
 
-	for (i = 0; i < 10; i++)
+	for (i = 0; i < TOP10_SHOWN; i++)
 	{
 		gtk_list_store_append (list, &iter);
 		gtk_list_store_set (list, &iter, 0, "--", 1, "--", 2, "--", 3, "--", 4, "--", -1);
@@ -123,6 +124,8 @@ top10_init ()
 	gtk_combo_box_text_remove (GTK_COMBO_BOX_TEXT (cmb), 0);
 	gtk_combo_box_text_append_text (GTK_COMBO_BOX_TEXT (cmb), _("Local scores"));
 	gtk_combo_box_text_append_text (GTK_COMBO_BOX_TEXT (cmb), _("External scores"));
+
+	top10_outbox_init ();
 }
 
 void
@@ -140,116 +143,57 @@ top10_message (gchar * msg)
 	gtk_statusbar_push (GTK_STATUSBAR (get_wg ("statusbar_top10_message")), 0, msg);
 }
 
-#define NOBODY "xxx"
-void
-top10_clean_stat (gint i, gboolean locally)
+static KscBoard *
+top10_board (gboolean locally)
 {
-	Statistics *top10;
-
-	top10 = locally ? top10_local : top10_global;
-
-	if (i > 9)
-		return;
+	KscBoard *board;
 
-	top10[i].lang[0] = 'x';
-	top10[i].lang[1] = 'x';
-	top10[i].genv = 'x';
-	top10[i].when = 0;
-	top10[i].nchars = MIN_CHARS_TO_LOG;
-	top10[i].accur = 0.0;
-	top10[i].velo = 0.0;
-	top10[i].fluid = 0.0;
-	top10[i].score = 0.0;
-	top10[i].name_len = strlen (NOBODY);
-	strcpy (top10[i].name, NOBODY);
+	board = locally ? &board_local : &board_global;
+	ksc_board_init (board);
+	return (board);
 }
 
 void
 top10_init_stats (gboolean locally)
 {
-	gint i;
-
-	for (i = 0; i < 10; i++)
-		top10_clean_stat (i, locally);
+	ksc_board_clear (top10_board (locally));
 }
 
-void
-top10_insert_stat (Statistics * stat, gint i, gboolean locally)
+gint
+top10_get_n_stats (gboolean locally)
 {
-	gint j;
-	Statistics *top10;
-
-	top10 = locally ? top10_local : top10_global;
-
-	if (i > 9)
-		return;
-
-	for (j = 8; j >= i; j--)
-		memmove (&top10[j + 1], &top10[j], sizeof (Statistics));
-
-	memmove (&top10[i], stat, sizeof (Statistics));
+	return (g_sequence_get_length (top10_board (locally)->seq));
 }
 
-gboolean
-top10_compare_insert_stat (Statistics * stat, gboolean locally)
+const Statistics *
+top10_get_stat (gint i, gboolean locally)
 {
-	gint i, j;
-	gint statnamelen;
-	gchar *pos;
-	Statistics *top10;
-
-	top10 = locally ? top10_local : top10_global;
+	KscBoard *board;
 
-	statnamelen = strlen (stat->name); 
-	pos = strrchr (stat->name, '[');
-	if (pos != NULL)
-		if (pos > stat->name && *(pos - 1) == ' ')
-		{
-			statnamelen = pos - stat->name - 1; 
-			if (statnamelen < 1)
-				statnamelen = strlen (stat->name); 
-		}
-	for (i = 0; i < 10; i++)
-	{
-		if (stat->score > top10[i].score)
-		{
-			for (j = i - 1; j >= 0; j--)
-			{
-				if (strncmp (stat->name, top10[j].name, statnamelen) == 0)
-					return (FALSE);
-			}
-
-			for (j = i; j < 10; j++)
-			{
-				if (strncmp (stat->name, top10[j].name, statnamelen) == 0 &&
-							stat->score > 0)
-				{
-					top10_delete_stat (j, locally);
-					j--;
-				}
-			}
-			top10_insert_stat (stat, i, locally);
-			return (TRUE);
-		}
-	}
-	return (FALSE);
+	board = top10_board (locally);
+	if (i < 0 || i >= g_sequence_get_length (board->seq))
+		return (NULL);
+	return (g_sequence_get (g_sequence_get_iter_at_pos (board->seq, i)));
 }
 
-void
-top10_delete_stat (gint i, gboolean locally)
+/* Position of the competitor of 'stat' in the ranking, or -1 if not there
+ */
+gint
+top10_get_rank (Statistics * stat, gboolean locally)
 {
-	gint j;
-	Statistics *top10;
-
-	top10 = locally ? top10_local : top10_global;
+	gchar *key;
+	GSequenceIter *it;
 
-	if (i > 9)
-		return;
-
-	for (j = i; j < 9; j++)
-		memmove (&top10[j], &top10[j + 1], sizeof (Statistics));
+	key = ksc_name_key (stat->name);
+	it = g_hash_table_lookup (top10_board (locally)->by_name, key);
+	g_free (key);
+	return (it ? g_sequence_iter_get_position (it) : -1);
+}
 
-	top10_clean_stat (9, locally);
+gboolean
+top10_compare_insert_stat (Statistics * stat, gboolean locally)
+{
+	return (ksc_board_insert (top10_board (locally), stat));
 }
 
 gfloat
@@ -319,230 +263,251 @@ top10_get_score_file (gboolean locally, gint lang)
 	return (ksc);
 }
 
-static void
-top10_merge_stats_from_file (gchar * file)
+gboolean
+top10_read_stats_from_file (gboolean locally, gchar * file)
 {
-	gint i, j;
-	gint32 n;
-	FILE *fh;
-	Statistics top10;
-
-	fh = g_fopen (file, "r");
-	if (fh == NULL)
-		return;
+	guint i;
+	gchar *key;
+	GArray *stats;
+	Statistics *st;
+	KscBoard *board;
+
+	stats = ksc_load_file (file);
+	if (stats == NULL)
+		return (FALSE);
 
-	for (i = 0; i < 10; i++)
+	/* Sorted once, then appended: no per record search
+	 */
+	top10_init_stats (locally);
+	board = top10_board (locally);
+	g_array_sort_with_data (stats, ksc_compare_stat, NULL);
+	for (i = 0; i < stats->len; i++)
 	{
-		/* lang[0] */
-		top10.lang[0] = getc (fh);
-		if (!g_ascii_isalpha (top10.lang[0]))
-		{
-			g_message ("Problem: lang[0] = %c", top10.lang[0]);
+		st = &g_array_index (stats, Statistics, i);
+		if (st->score <= 0 || g_sequence_get_length (board->seq) >= TOP10_BOARD_SIZE)
 			break;
-		}
-
-		/* lang[1] */
-		top10.lang[1] = getc (fh);
-		if (!g_ascii_isalpha (top10.lang[1]))
+		key = ksc_name_key (st->name);
+		if (g_hash_table_lookup (board->by_name, key))
 		{
-			top10.lang[0] = 'e';
-			top10.lang[1] = 'o';
+			g_free (key);
+			continue;
 		}
+		g_hash_table_insert (board->by_name, key,
+				     g_sequence_append (board->seq, g_memdup (st, sizeof (Statistics))));
+	}
+	g_array_free (stats, TRUE);
 
-		/* genv */
-		top10.genv = getc (fh);
-		if (top10.genv != 'x' && top10.genv != 'w')
-		{
-			g_message ("Problem: genv = %c", top10.genv);
-			break;
-		}
+	return (TRUE);
+}
 
-		/* when */
-		//n = fread (&top10.when, sizeof (time_t), 1, fh);
-		n = fread (&top10.when, sizeof (gint32), 1, fh);
-		if (n == 0)
-		{
-			g_message ("Problem: when = %li", top10.when);
-			break;
-		}
+/**************************************************
+ * Scores of the other users of this computer
+ */
+#define TOP10_RESCAN_TIME 300	/* seconds between looks into all the homes */
 
-		/* nchars */
-		n = fread (&top10.nchars, sizeof (gint32), 1, fh);
-		if (n == 0 || top10.nchars < MIN_CHARS_TO_LOG)
-		{
-			g_message ("Problem: nchars = %i, < %i", top10.nchars, MIN_CHARS_TO_LOG);
-			break;
-		}
+typedef struct
+{
+	time_t mtime;
+	GArray *stats;
+} Top10Source;
 
-		/* accur */
-		n = fread (&top10.accur, sizeof (gfloat), 1, fh);
-		if (n == 0 || top10.accur < 0 || top10.accur > 100)
-		{
-			g_message ("Problem: accur = %f <> [0, 100]", top10.accur);
-			break;
-		}
+typedef struct
+{
+	gint64 probed;		/* monotonic time all the homes were looked into, 0 for soon */
+	guint listing;		/* listing of /home whose users were all looked into */
+	GHashTable *sources;	/* path -> Top10Source * */
+	KscBoard merged;	/* best records found in the sources */
+} Top10Others;
 
-		/* velo */
-		n = fread (&top10.velo, sizeof (gfloat), 1, fh);
-		if (n == 0 || top10.velo < 0 || top10.velo > 300)
-		{
-			g_message ("Problem: velo = %f <> [0, 300]", top10.velo);
-			break;
-		}
+static struct
+{
+	time_t home_mtime;
+	guint listing;		/* counts the listings of /home, from 1 */
+	GPtrArray *users;	/* entries of /home worth looking into */
+	GHashTable *by_ksc;	/* scores file name -> Top10Others * */
+} others = { 0, 0, NULL, NULL };
 
-		/* fluid */
-		n = fread (&top10.fluid, sizeof (gfloat), 1, fh);
-		if (n == 0 || top10.fluid < 0 || top10.fluid > 100)
-		{
-			g_message ("Problem: fluid = %f <> [0, 100]", top10.fluid);
-			break;
-		}
+static void
+top10_source_free (gpointer data)
+{
+	Top10Source *src = data;
 
-		/* score */
-		n = fread (&top10.score, sizeof (gfloat), 1, fh);
-		if (n == 0 || top10.score < 0 || top10.score > 20)
-		{
-			g_message ("Problem: score = %f <> [0, 20]", top10.score);
-			break;
-		}
+	if (src->stats)
+		g_array_free (src->stats, TRUE);
+	g_free (src);
+}
 
-		/* name_len */
-		n = fread (&top10.name_len, sizeof (gint32), 1, fh);
-		if (n == 0 || top10.name_len < 0 || top10.name_len > MAX_NAME_LEN)
-		{
-			g_message ("Problem: name_len = %i <> [0, MAX_NAME_LEN]", top10.name_len);
-			break;
-		}
+static Top10Others *
+top10_others_get (const gchar * ksc)
+{
+	Top10Others *oth;
 
-		/* name */
-		n = fread (&top10.name, sizeof (gchar), top10.name_len, fh);
-		top10.name[top10.name_len] = '\0';
-		if (!g_utf8_validate (top10.name, -1, NULL))
-		{
-			for (j = 0; j < top10.name_len; j++)
-				if (!g_ascii_isalpha (top10.name[j]))
-					top10.name[j] = '?';
-		}
+	if (others.by_ksc == NULL)
+		others.by_ksc = g_hash_table_new (g_str_hash, g_str_equal);
 
-		top10_compare_insert_stat (&top10, TRUE);
+	oth = g_hash_table_lookup (others.by_ksc, ksc);
+	if (oth == NULL)
+	{
+		oth = g_new0 (Top10Others, 1);
+		oth->sources = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, top10_source_free);
+		ksc_board_init (&oth->merged);
+		g_hash_table_insert (others.by_ksc, g_strdup (ksc), oth);
 	}
-	fclose (fh);
+	return (oth);
 }
 
-gboolean
-top10_read_stats_from_file (gboolean locally, gchar * file)
+/* The listing of /home is only redone when the folder itself changes
+ */
+static void
+top10_others_list_users (void)
 {
-	gint i, j;
-	gint32 n;
-	gboolean success;
-	FILE *fh;
-	Statistics *top10;
+	const gchar *uname;
+	struct stat st;
+	GDir *home;
 
-	top10 = locally ? top10_local : top10_global;
+	if (g_stat ("/home", &st) != 0)
+		st.st_mtime = 0;
+	if (others.users != NULL && others.home_mtime == st.st_mtime)
+		return;
 
-	fh = g_fopen (file, "r");
-	if (fh == NULL)
-		return FALSE;
+	if (others.users == NULL)
+		others.users = g_ptr_array_new_with_free_func (g_free);
+	else
+		g_ptr_array_set_size (others.users, 0);
+	others.home_mtime = st.st_mtime;
+	others.listing++;
 
-	for (i = 0; i < 10; i++)
+	home = g_dir_open ("/home", 0, NULL);
+	if (home == NULL)
+		return;
+	while ((uname = g_dir_read_name (home)))
 	{
-		success = FALSE;
-
-		/* lang[0] */
-		top10[i].lang[0] = fgetc (fh);
-		if (!g_ascii_isalpha (top10[i].lang[0]))
-		{
-			g_message ("Problem: lang[0] = %c", top10[i].lang[0]);
-			break;
-		}
-
-		/* lang[1] */
-		top10[i].lang[1] = fgetc (fh);
-		if (!g_ascii_isalpha (top10[i].lang[1]))
-		{
-			top10[i].lang[0] = 'e';
-			top10[i].lang[1] = 'o';
-		}
-
-		/* genv */
-		top10[i].genv = fgetc (fh);
-		if (top10[i].genv != 'x' && top10[i].genv != 'w')
-		{
-			g_message ("Problem: genv = %c", top10[i].genv);
-			break;
-		}
+		if (g_str_equal (uname, "root"))
+			continue;
+		if (g_str_equal (uname, "lost+found"))
+			continue;
+		if (g_str_equal (uname, g_get_user_name ()))
+			continue;
+		g_ptr_array_add (others.users, g_strdup (uname));
+	}
+	g_dir_close (home);
+}
 
-		/* when */
-		//n = fread (&top10[i].when, sizeof (time_t), 1, fh);
-		n = fread (&top10[i].when, sizeof (gint32), 1, fh);
-		if (n == 0)
-		{
-			g_message ("Problem: when = %li", top10[i].when);
-			break;
-		}
+/* The files already found are looked at every time, and read again if their
+ * modification time changed. Since each look into a home may mount it (NFS,
+ * automount), all the homes are looked into only every TOP10_RESCAN_TIME
+ * seconds, when /home changes or when the ranking is opened.
+ * Returns TRUE if the merged records changed.
+ */
+static gboolean
+top10_others_refresh (Top10Others * oth, const gchar * ksc)
+{
+	guint i;
+	gint64 now;
+	gchar *path;
+	gchar *stat_dir;
+	gpointer key;
+	gboolean changed;
+	struct stat st;
+	GHashTable *sources;
+	GHashTableIter iter;
+	GPtrArray *paths;
+	Top10Source *src;
+
+	/* Stats folder relative to the home one
+	 */
+	stat_dir = strchr (main_path_stats (), G_DIR_SEPARATOR);
+	if (stat_dir)
+	       	stat_dir = strchr (stat_dir + 1, G_DIR_SEPARATOR);
+	if (stat_dir)
+	       	stat_dir = strchr (stat_dir + 1, G_DIR_SEPARATOR);
+	if (stat_dir == NULL)
+		return (FALSE);
+	top10_others_list_users ();
 
-		/* nchars */
-		n = fread (&top10[i].nchars, sizeof (gint32), 1, fh);
-		if (n == 0 || top10[i].nchars < MIN_CHARS_TO_LOG)
-		{
-			g_message ("Problem: nchars = %i, < %i", top10[i].nchars, MIN_CHARS_TO_LOG);
-			break;
-		}
+	now = g_get_monotonic_time ();
+	paths = g_ptr_array_new ();
+	if (oth->listing != others.listing || oth->probed == 0 ||
+	    now - oth->probed >= (gint64) TOP10_RESCAN_TIME * G_USEC_PER_SEC)
+	{
+		for (i = 0; i < others.users->len; i++)
+			g_ptr_array_add (paths, g_build_filename ("/home", g_ptr_array_index (others.users, i),
+								  stat_dir + 1, "ksc", ksc, NULL));
+		oth->listing = others.listing;
+		oth->probed = now;
+	}
+	else
+	{
+		g_hash_table_iter_init (&iter, oth->sources);
+		while (g_hash_table_iter_next (&iter, &key, NULL))
+			g_ptr_array_add (paths, g_strdup (key));
+	}
 
-		/* accur */
-		n = fread (&top10[i].accur, sizeof (gfloat), 1, fh);
-		if (n == 0 || top10[i].accur < 0 || top10[i].accur > 100)
+	changed = FALSE;
+	sources = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, top10_source_free);
+	for (i = 0; i < paths->len; i++)
+	{
+		path = g_ptr_array_index (paths, i);
+		if (g_stat (path, &st) != 0 || !S_ISREG (st.st_mode))
 		{
-			g_message ("Problem: accur = %f <> [0, 100]", top10[i].accur);
-			break;
+			g_free (path);
+			continue;
 		}
 
-		/* velo */
-		n = fread (&top10[i].velo, sizeof (gfloat), 1, fh);
-		if (n == 0 || top10[i].velo < 0 || top10[i].velo > 300)
+		if (g_hash_table_lookup_extended (oth->sources, path, &key, (gpointer *) &src))
 		{
-			g_message ("Problem: velo = %f <> [0, 300]", top10[i].velo);
-			break;
+			g_hash_table_steal (oth->sources, path);
+			g_free (key);
 		}
-
-		/* fluid */
-		n = fread (&top10[i].fluid, sizeof (gfloat), 1, fh);
-		if (n == 0 || top10[i].fluid < 0 || top10[i].fluid > 100)
+		else
 		{
-			g_message ("Problem: fluid = %f <> [0, 100]", top10[i].fluid);
-			break;
+			src = g_new0 (Top10Source, 1);
+			src->mtime = -1;
 		}
-
-		/* score */
-		n = fread (&top10[i].score, sizeof (gfloat), 1, fh);
-		if (n == 0 || top10[i].score < 0 || top10[i].score > 20)
+		if (src->mtime != st.st_mtime)
 		{
-			g_message ("Problem: score = %f <> [0, 20]", top10[i].score);
-			break;
+			if (src->stats)
+				g_array_free (src->stats, TRUE);
+			src->stats = ksc_load_file (path);
+			src->mtime = st.st_mtime;
+			changed = TRUE;
 		}
+		g_hash_table_insert (sources, path, src);
+	}
+	g_ptr_array_free (paths, TRUE);
+	if (g_hash_table_size (oth->sources) > 0)
+		changed = TRUE;
+	g_hash_table_destroy (oth->sources);
+	oth->sources = sources;
 
-		/* name_len */
-		n = fread (&top10[i].name_len, sizeof (gint32), 1, fh);
-		if (n == 0 || top10[i].name_len < 0 || top10[i].name_len > MAX_NAME_LEN)
-		{
-			g_message ("Problem: name_len = %i <> [0, MAX_NAME_LEN]", top10[i].name_len);
-			break;
-		}
+	if (!changed)
+		return (FALSE);
 
-		/* name */
-		n = fread (&top10[i].name, sizeof (gchar), top10[i].name_len, fh);
-		top10[i].name[top10[i].name_len] = '\0';
-		if (!g_utf8_validate (top10[i].name, -1, NULL))
-		{
-			for (j = 0; j < top10[i].name_len; j++)
-				if (!g_ascii_isalpha (top10[i].name[j]))
-					top10[i].name[j] = '?';
-		}
-		success = TRUE;
+	ksc_board_clear (&oth->merged);
+	g_hash_table_iter_init (&iter, oth->sources);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &src))
+	{
+		if (src->stats == NULL)
+			continue;
+		for (i = 0; i < src->stats->len; i++)
+			ksc_board_insert (&oth->merged, &g_array_index (src->stats, Statistics, i));
 	}
-	fclose (fh);
+	return (TRUE);
+}
 
-	return (success);
+/* Have the next refresh look into all the homes
+ */
+static void
+top10_others_expire (void)
+{
+	GHashTableIter iter;
+	Top10Others *oth;
+
+	if (others.by_ksc == NULL)
+		return;
+	g_hash_table_iter_init (&iter, others.by_ksc);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &oth))
+		oth->probed = 0;
 }
 
 void
@@ -550,10 +515,9 @@ top10_read_stats (gboolean locally, gint lang)
 {
 	gchar *local_ksc;
 	gchar *tmp;
-	gchar *uname;
-	gchar *stat_dir;
 	gboolean success;
-	GDir *home;
+	GSequenceIter *it;
+	Top10Others *oth;
 
 	top10_init_stats (locally);
 
@@ -565,7 +529,6 @@ top10_read_stats (gboolean locally, gint lang)
 		g_message ("Could not read the scores file '%s'.\n Creating a blank one.", tmp);
 		top10_init_stats (locally);
 		top10_write_stats (locally, lang);
-		//top10_show_stat (locally ? top10_local : top10_global);
 	}
 	g_free (tmp);
 
@@ -575,62 +538,28 @@ top10_read_stats (gboolean locally, gint lang)
 		return;
 	}
 
-	/* Go search other users' subdirs
+	/* Merge the best records of the other users
 	 */
-	tmp = strchr (main_path_stats (), G_DIR_SEPARATOR);
-	if (tmp)
-	       	tmp = strchr (tmp + 1, G_DIR_SEPARATOR);
-	if (tmp)
-	       	tmp = strchr (tmp + 1, G_DIR_SEPARATOR);
-	if (tmp)
-	{
-	       	stat_dir = tmp + 1;
-		home = g_dir_open ("/home", 0, NULL);
-	}
-	else
-	{
-		stat_dir = NULL;
-	       	home = NULL;
-	}
+	oth = top10_others_get (local_ksc);
+	top10_others_refresh (oth, local_ksc);
+	g_free (local_ksc);
 
 	success = FALSE;
-	if (home)
-	{
-		while ((uname = (gchar*) g_dir_read_name (home)))
-		{
-			if (g_str_equal (uname, "root"))
-				continue;
-			if (g_str_equal (uname, "lost+found"))
-				continue;
-			if (g_str_equal (uname, g_get_user_name ()))
-				continue;
-
-			tmp = g_build_filename ("/home", uname, stat_dir, "ksc", local_ksc, NULL);
-			if (g_file_test (tmp, G_FILE_TEST_IS_REGULAR))
-			{
-				top10_merge_stats_from_file (tmp);
-				success = TRUE;
-			}
-			g_free (tmp);
-		}
-		g_dir_close (home);
-	}
-	g_free (local_ksc);
+	it = g_sequence_get_begin_iter (oth->merged.seq);
+	for (; !g_sequence_iter_is_end (it); it = g_sequence_iter_next (it))
+		if (ksc_board_insert (&board_local, g_sequence_get (it)))
+			success = TRUE;
 
 	if (success)
-		top10_write_stats (TRUE, -1);
+		top10_write_stats (TRUE, lang);
 }
 
 void
 top10_write_stats (gboolean locally, gint lang)
 {
-	gint i;
 	gchar *filename;
 	gchar *lsfile;
-	FILE *fh;
-	Statistics *top10;
-
-	top10 = locally ? top10_local : top10_global;
+	GByteArray *buf;
 
 	if (!g_file_test (main_path_score (), G_FILE_TEST_IS_DIR))
 		g_mkdir_with_parents (main_path_score (), DIR_PERM);
@@ -639,38 +568,28 @@ top10_write_stats (gboolean locally, gint lang)
 
 	lsfile = g_build_filename (main_path_score (), filename, NULL);
 
-	fh = g_fopen (lsfile, "w");
-	if (fh == NULL)
-	{
+	buf = ksc_compile (top10_board (locally)->seq);
+	if (!g_file_set_contents (lsfile, (gchar *) buf->data, buf->len, NULL))
 		g_warning ("Could not write the scores file in %s", main_path_score ());
-		g_free (filename);
-		g_free (lsfile);
-		return;
-	}
-
-	for (i = 0; i < 10; i++)
-	{
-		fputc (top10[i].lang[0], fh);
-		fputc (top10[i].lang[1], fh);
-		fputc (top10[i].genv, fh);
-		//fwrite (&top10[i].when, sizeof (time_t), 1, fh);
-		fwrite (&top10[i].when, sizeof (gint32), 1, fh);
-		fwrite (&top10[i].nchars, sizeof (gint32), 1, fh);
-		fwrite (&top10[i].accur, sizeof (gfloat), 1, fh);
-		fwrite (&top10[i].velo, sizeof (gfloat), 1, fh);
-		fwrite (&top10[i].fluid, sizeof (gfloat), 1, fh);
-		fwrite (&top10[i].score, sizeof (gfloat), 1, fh);
-		fwrite (&top10[i].name_len, sizeof (gint32), 1, fh);
-		if (top10[i].name && top10[i].name_len > 0)
-			fputs (top10[i].name, fh);
-	}
-	fputs ("KLAVARO!", fh);
-	fclose (fh);
+	g_byte_array_free (buf, TRUE);
 
 	g_free (filename);
 	g_free (lsfile);
 }
 
+static gboolean
+top10_write_old_stats (KscBoard * board, gchar * file)
+{
+	gboolean success;
+	GByteArray *buf;
+
+	buf = ksc_compile_old (board);
+	success = g_file_set_contents (file, (gchar *) buf->data, buf->len, NULL);
+	g_byte_array_free (buf, TRUE);
+
+	return (success);
+}
+
 /* Test function to show every field of a scoring record, at the terminal
  */
 void
@@ -701,20 +620,19 @@ top10_show_stats (gboolean locally)
 	gchar *nchars;
 	gchar *date;
 	struct tm *ltime;
-	Statistics *top10;
+	const Statistics *top10;
 	GtkListStore *list1;
 	GtkListStore *list2;
 	GtkTreeIter iter1;
 	GtkTreeIter iter2;
 
-	top10 = locally ? top10_local : top10_global;
-
+	top10_others_expire ();
 	top10_read_stats (locally, -1);
 	top10_read_stats (!locally, -1);
 
 	/* Set layout
 	 */
-	if (top10[0].score == 0.0)
+	if (top10_get_n_stats (locally) == 0)
 	{
 		top10_message (_("Empty ranking. Please practice fluidness."));
 		gtk_widget_set_sensitive (get_wg ("treeview_top10_1"), FALSE);
@@ -727,7 +645,7 @@ top10_show_stats (gboolean locally)
 	}
 
 	gtk_widget_set_sensitive (get_wg ("button_top10_update"), !locally);
-	if (top10_local[0].score == 0.0)
+	if (top10_get_n_stats (LOCAL) == 0)
 		gtk_widget_set_sensitive (get_wg ("button_top10_publish"), FALSE);
 	else
 		gtk_widget_set_sensitive (get_wg ("button_top10_publish"), !locally);
@@ -756,9 +674,10 @@ top10_show_stats (gboolean locally)
 		g_warning ("not able to set Top10 Treeviews");
 		return;
 	}
-	for (i = 0; i < 10; i++)
+	for (i = 0; i < TOP10_SHOWN; i++)
 	{
-		if (top10[i].score == 0)
+		top10 = top10_get_stat (i, locally);
+		if (top10 == NULL)
 		{
 			gtk_list_store_set (list1, &iter1, 1, "", 2, "", -1);
 			gtk_list_store_set (list2, &iter2, 0, "", 1, "", 2, "", 3, "", 4, "", -1);
@@ -767,17 +686,17 @@ top10_show_stats (gboolean locally)
 		{
 			/* First treeview: main info
 			 */
-			tmp = g_strdup_printf ("%3.4f", top10[i].score);
-			gtk_list_store_set (list1, &iter1, 1, top10[i].name, 2, tmp, -1);
+			tmp = g_strdup_printf ("%3.4f", top10->score);
+			gtk_list_store_set (list1, &iter1, 1, top10->name, 2, tmp, -1);
 			g_free (tmp);
 
 			/* Second treeview: further info
 			 */
-			accur = g_strdup_printf ("%2.1f", top10[i].accur); 
-			velo = g_strdup_printf ("%2.1f", top10[i].velo); 
-			fluid = g_strdup_printf ("%2.1f", top10[i].fluid); 
-			nchars = g_strdup_printf ("%i", top10[i].nchars); 
-			ltime = localtime (&top10[i].when);
+			accur = g_strdup_printf ("%2.1f", top10->accur); 
+			velo = g_strdup_printf ("%2.1f", top10->velo); 
+			fluid = g_strdup_printf ("%2.1f", top10->fluid); 
+			nchars = g_strdup_printf ("%i", top10->nchars); 
+			ltime = localtime (&top10->when);
 			date = g_strdup_printf ("%i-%2.2i-%2.2i %02i:%02i", (ltime->tm_year) + 1900,
 						(ltime->tm_mon) + 1, (ltime->tm_mday),
 						(ltime->tm_hour), (ltime->tm_min));
@@ -796,142 +715,576 @@ top10_show_stats (gboolean locally)
 	}
 }
 
-gboolean
-top10_global_update (gpointer data)
+/**************************************************
+ * Transfers with the contest server, run in a worker thread so that
+ * a slow server doesn't freeze the interface
+ */
+typedef struct
 {
-	gboolean fail;
+	gchar *url;
+	gchar *path;		/* file sent, or received */
+	gchar *validators;	/* "ETag: ..." and "Last-Modified: ..." of the copy we have */
+	GString *received;	/* the same, from the answer */
+	glong code;		/* HTTP response code */
+	CURLcode result;
+} Top10Item;
+
+typedef struct _Top10Transfer Top10Transfer;
+struct _Top10Transfer
+{
+	GPtrArray *items;	/* Top10Item *, all through the same connection */
+	guint current;
+	gboolean upload;
+	void (*done) (Top10Transfer * xfer);
+	gint percent;		/* atomic, -1 while unknown */
+	gint cancelled;		/* atomic */
+	guint progress_id;
+	GThread *thread;
+};
+
+static Top10Transfer *transfer = NULL;
+
+/* Hosts may be overridden in the preferences: "server" points to a local
+ * leaderboard (klavaro_rangilo), "downhost" and "cgi_server" set each one apart
+ */
+static gchar *
+top10_get_host (gboolean upload)
+{
+	gchar *key;
 	gchar *tmp;
-	gchar *ksc;
 	gchar *host;
-	gchar *command;
-	GtkImage *img;
-	CURL *curl;
-	FILE *fh;
-	
-	img = GTK_IMAGE (get_wg ("image_top10_update"));
-	top10_message (NULL);
 
-	if (!main_curl_ok ())
+	key = upload ? "cgi_server" : "downhost";
+	if (main_preferences_exist ("game", key))
+		return (main_preferences_get_string ("game", key));
+	if (main_preferences_exist ("game", "server"))
 	{
-		tmp = g_strconcat (_("Not able to download files"), ": 'libcurl' ", _("not found"), ". ",
-		       _("Are you sure you have it installed in your system?"), NULL);
-		top10_message (tmp);
+		tmp = main_preferences_get_string ("game", "server");
+		host = g_strconcat (tmp, upload ? "/cgi-bin/klavaro_rangilo" : "/top10", NULL);
 		g_free (tmp);
-		gtk_image_set_from_icon_name (img, "go-bottom", GTK_ICON_SIZE_BUTTON);
-		return FALSE;
+		return (host);
 	}
+	return (g_strdup (upload ? CGI_SERVER : DOWNHOST));
+}
 
-	/**************************************************
-	 * Download from downhost
-	 */
-	host = g_strdup (DOWNHOST);
-	ksc = top10_get_score_file (GLOBAL, -1);
-	if (! (curl = curl_easy_init ()) )
-	{
-		g_message ("Not able to initialize 'curl'");
-		gtk_image_set_from_icon_name (img, "go-bottom", GTK_ICON_SIZE_BUTTON);
-		g_free (host);
-		return FALSE;
-	}
+static int
+top10_transfer_xferinfo (void *data, curl_off_t dltotal, curl_off_t dlnow,
+			 curl_off_t ultotal, curl_off_t ulnow)
+{
+	gint percent = -1;
+	Top10Transfer *xfer = data;
+
+	if (xfer->upload && ultotal > 0)
+		percent = 100 * ulnow / ultotal;
+	else if (!xfer->upload && dltotal > 0)
+		percent = 100 * dlnow / dltotal;
+	if (percent >= 0)
+		g_atomic_int_set (&xfer->percent, (xfer->current * 100 + percent) / xfer->items->len);
+
+	/* Non zero aborts the transfer */
+	return (g_atomic_int_get (&xfer->cancelled));
+}
 
-	if (!g_file_test (main_path_score (), G_FILE_TEST_IS_DIR))
-		g_mkdir_with_parents (main_path_score (), DIR_PERM);
-	tmp = g_build_filename (main_path_score (), ksc, NULL);
-	fail = TRUE;
-	command = g_strdup_printf ("http://%s/%s", host, ksc);
-	if ( (fh = g_fopen (tmp, "wb")) )
+static size_t
+top10_transfer_header (char *buf, size_t size, size_t nmemb, void *data)
+{
+	gsize len = size * nmemb;
+	Top10Item *item = data;
+
+	/* A new answer (after a redirection, say) */
+	if (len > 5 && strncmp (buf, "HTTP/", 5) == 0)
+		g_string_truncate (item->received, 0);
+	else if ((len > 5 && g_ascii_strncasecmp (buf, "ETag:", 5) == 0) ||
+		 (len > 14 && g_ascii_strncasecmp (buf, "Last-Modified:", 14) == 0))
 	{
-		/*
-		curl_easy_setopt (curl, CURLOPT_VERBOSE, 1);
-		 */
-		curl_easy_setopt (curl, CURLOPT_TIMEOUT, TIMEOUT);
-		curl_easy_setopt (curl, CURLOPT_LOW_SPEED_LIMIT, LOW_SPEED_LIMIT);
-		curl_easy_setopt (curl, CURLOPT_LOW_SPEED_TIME, LOW_SPEED_TIME);
-		curl_easy_setopt (curl, CURLOPT_URL, command);
-		curl_easy_setopt (curl, CURLOPT_WRITEDATA, fh);
-		fail = curl_easy_perform (curl);
-		fclose (fh);
+		g_string_append_len (item->received, buf, len);
+		while (item->received->len > 0 && g_ascii_isspace (item->received->str[item->received->len - 1]))
+			g_string_truncate (item->received, item->received->len - 1);
+		g_string_append_c (item->received, '\n');
 	}
-	curl_easy_cleanup (curl);
-	g_free (command);
-	g_free (host);
+	return (len);
+}
 
-	if (fail)
+static size_t
+top10_transfer_discard (char *ptr, size_t size, size_t nmemb, void *data)
+{
+	return (size * nmemb);
+}
+
+/* Turns the saved validators into the headers of a conditional request
+ */
+static struct curl_slist *
+top10_transfer_conditions (Top10Item * item)
+{
+	gint i;
+	gchar *tmp;
+	gchar **line;
+	struct curl_slist *headers = NULL;
+
+	if (item->validators == NULL)
+		return (NULL);
+	line = g_strsplit (item->validators, "\n", -1);
+	for (i = 0; line[i] != NULL; i++)
 	{
-		top10_message (_("Could not download file from the host server."));
-		gtk_image_set_from_icon_name (img, "go-bottom", GTK_ICON_SIZE_BUTTON);
-		g_free (ksc);
+		if (g_ascii_strncasecmp (line[i], "ETag:", 5) == 0)
+			tmp = g_strconcat ("If-None-Match:", line[i] + 5, NULL);
+		else if (g_ascii_strncasecmp (line[i], "Last-Modified:", 14) == 0)
+			tmp = g_strconcat ("If-Modified-Since:", line[i] + 14, NULL);
+		else
+			continue;
+		headers = curl_slist_append (headers, tmp);
 		g_free (tmp);
-		return FALSE;
 	}
+	g_strfreev (line);
+	return (headers);
+}
 
-	if (!g_file_test (tmp, G_FILE_TEST_IS_REGULAR))
-		g_message ("No file downloaded from the host server.");
-
-	gtk_image_set_from_icon_name (img, "go-bottom", GTK_ICON_SIZE_BUTTON);
-	g_free (tmp);
-	g_free (ksc);
+static gboolean
+top10_transfer_progress (gpointer data)
+{
+	gint percent;
+	gchar *msg;
+	Top10Transfer *xfer = data;
 
+	percent = g_atomic_int_get (&xfer->percent);
+	if (percent >= 0)
+	{
+		msg = g_strdup_printf ("%s %i%%", _("Connecting..."), percent);
+		top10_message (msg);
+		g_free (msg);
+	}
+	return (TRUE);
+}
+
+static void
+top10_item_free (gpointer data)
+{
+	Top10Item *item = data;
+
+	g_free (item->url);
+	g_free (item->path);
+	g_free (item->validators);
+	g_string_free (item->received, TRUE);
+	g_free (item);
+}
+
+static void
+top10_transfer_add (Top10Transfer * xfer, gchar * url, gchar * path, gchar * validators)
+{
+	Top10Item *item;
+
+	item = g_new0 (Top10Item, 1);
+	item->url = url;
+	item->path = path;
+	item->validators = validators;
+	item->received = g_string_new ("");
+	item->result = CURLE_FAILED_INIT;
+	g_ptr_array_add (xfer->items, item);
+}
+
+static Top10Transfer *
+top10_transfer_new (gboolean upload, void (*done) (Top10Transfer *))
+{
+	Top10Transfer *xfer;
+
+	xfer = g_new0 (Top10Transfer, 1);
+	xfer->items = g_ptr_array_new_with_free_func (top10_item_free);
+	xfer->upload = upload;
+	xfer->done = done;
+	xfer->percent = -1;
+	return (xfer);
+}
+
+static void
+top10_transfer_free (Top10Transfer * xfer)
+{
+	g_ptr_array_free (xfer->items, TRUE);
+	g_free (xfer);
+}
+
+/* Back in the main loop
+ */
+static gboolean
+top10_transfer_finish (gpointer data)
+{
+	Top10Transfer *xfer = data;
+
+	if (xfer->thread)
+		g_thread_join (xfer->thread);
+	g_source_remove (xfer->progress_id);
+	if (transfer == xfer)
+		transfer = NULL;
+	xfer->done (xfer);
+	top10_transfer_free (xfer);
+	return (FALSE);
+}
+
+static gpointer
+top10_transfer_run (gpointer data)
+{
+	FILE *fh;
+	CURL *curl;
+	struct stat fs;
+	struct curl_slist *headers;
+	Top10Item *item;
+	Top10Transfer *xfer = data;
+
+	/* One handle for every item, so that the connection is kept alive
+	 */
+	curl = curl_easy_init ();
+	for (xfer->current = 0; curl && xfer->current < xfer->items->len; xfer->current++)
+	{
+		if (g_atomic_int_get (&xfer->cancelled))
+			break;
+		item = g_ptr_array_index (xfer->items, xfer->current);
+		if ((fh = g_fopen (item->path, xfer->upload ? "rb" : "wb")) == NULL)
+			continue;
+
+		/*
+		curl_easy_setopt (curl, CURLOPT_VERBOSE, 1);
+		 */
+		curl_easy_setopt (curl, CURLOPT_NOSIGNAL, 1L);
+		curl_easy_setopt (curl, CURLOPT_TIMEOUT, TIMEOUT);
+		curl_easy_setopt (curl, CURLOPT_LOW_SPEED_LIMIT, LOW_SPEED_LIMIT);
+		curl_easy_setopt (curl, CURLOPT_LOW_SPEED_TIME, LOW_SPEED_TIME);
+		curl_easy_setopt (curl, CURLOPT_URL, item->url);
+		curl_easy_setopt (curl, CURLOPT_NOPROGRESS, 0L);
+		curl_easy_setopt (curl, CURLOPT_XFERINFOFUNCTION, top10_transfer_xferinfo);
+		curl_easy_setopt (curl, CURLOPT_XFERINFODATA, xfer);
+		curl_easy_setopt (curl, CURLOPT_HEADERFUNCTION, top10_transfer_header);
+		curl_easy_setopt (curl, CURLOPT_HEADERDATA, item);
+		headers = top10_transfer_conditions (item);
+		curl_easy_setopt (curl, CURLOPT_HTTPHEADER, headers);
+		if (xfer->upload)
+		{
+			fs.st_size = 0;
+			g_stat (item->path, &fs);
+			curl_easy_setopt (curl, CURLOPT_UPLOAD, 1L);
+			curl_easy_setopt (curl, CURLOPT_INFILESIZE, (long) fs.st_size);
+			curl_easy_setopt (curl, CURLOPT_READDATA, fh);
+			curl_easy_setopt (curl, CURLOPT_WRITEFUNCTION, top10_transfer_discard);
+		}
+		else
+		{
+			/* Whatever compression libcurl knows about */
+			curl_easy_setopt (curl, CURLOPT_ACCEPT_ENCODING, "");
+			curl_easy_setopt (curl, CURLOPT_WRITEFUNCTION, NULL);
+			curl_easy_setopt (curl, CURLOPT_WRITEDATA, fh);
+		}
+		item->result = curl_easy_perform (curl);
+		curl_easy_getinfo (curl, CURLINFO_RESPONSE_CODE, &item->code);
+		curl_easy_setopt (curl, CURLOPT_HTTPHEADER, NULL);
+		curl_slist_free_all (headers);
+		fclose (fh);
+	}
+	if (curl)
+		curl_easy_cleanup (curl);
+
+	g_idle_add (top10_transfer_finish, xfer);
+	return (NULL);
+}
+
+/* Only one transfer at a time: FALSE if busy or if the thread can't start
+ */
+static gboolean
+top10_transfer_start (Top10Transfer * xfer)
+{
+	GError *error = NULL;
+
+	if (transfer != NULL)
+	{
+		top10_transfer_free (xfer);
+		return (FALSE);
+	}
+
+	xfer->thread = g_thread_try_new ("top10_transfer", top10_transfer_run, xfer, &error);
+	if (xfer->thread == NULL)
+	{
+		g_message ("could not start the transfer: %s", error->message);
+		g_error_free (error);
+		top10_transfer_free (xfer);
+		return (FALSE);
+	}
+	xfer->progress_id = g_timeout_add (200, top10_transfer_progress, xfer);
+	transfer = xfer;
+	return (TRUE);
+}
+
+/* With 'wait', returns only after the worker thread is gone (e.g. when quitting)
+ */
+void
+top10_transfer_cancel (gboolean wait)
+{
+	if (transfer == NULL)
+		return;
+	g_atomic_int_set (&transfer->cancelled, 1);
+	if (wait && transfer->thread)
+	{
+		g_thread_join (transfer->thread);
+		transfer->thread = NULL;
+	}
+}
+
+gboolean
+top10_transfer_busy ()
+{
+	return (transfer != NULL);
+}
+
+static void
+top10_global_update_done (Top10Transfer * xfer)
+{
+	guint i;
+	gchar *ksc;
+	gchar *http;
+	gboolean fail;
+	gboolean cancelled;
+	Top10Item *item;
+
+	gtk_image_set_from_icon_name (GTK_IMAGE (get_wg ("image_top10_update")), "go-bottom",
+				      GTK_ICON_SIZE_BUTTON);
+
+	fail = cancelled = FALSE;
+	for (i = 0; i < xfer->items->len; i++)
+	{
+		item = g_ptr_array_index (xfer->items, i);
+		ksc = g_strndup (item->path, strlen (item->path) - strlen (".part"));
+		http = g_strconcat (ksc, ".http", NULL);
+
+		if (item->result == CURLE_OK && item->code == 304)
+			g_unlink (item->path);
+		else if (item->result == CURLE_OK && (item->code == 200 || item->code == 0))
+		{
+			/* Keep the previous ranking until the new one is complete
+			 */
+			if (g_rename (item->path, ksc) != 0)
+				g_message ("No file downloaded from the host server.");
+			else if (item->received->len > 0)
+				g_file_set_contents (http, item->received->str, -1, NULL);
+			else
+				g_unlink (http);
+		}
+		else
+		{
+			g_unlink (item->path);
+			if (item->result == CURLE_ABORTED_BY_CALLBACK || g_atomic_int_get (&xfer->cancelled))
+				cancelled = TRUE;
+			else if (i == 0)
+				fail = TRUE;
+		}
+		g_free (ksc);
+		g_free (http);
+	}
+
+	if (cancelled)
+	{
+		top10_message (NULL);
+		return;
+	}
+	if (fail)
+	{
+		top10_message (_("Could not download file from the host server."));
+		return;
+	}
+	top10_message (NULL);
 
 	if (gtk_combo_box_get_active (GTK_COMBO_BOX (get_wg ("combobox_top10"))) == 0)
 		top10_show_stats (LOCAL);
 	else
 		top10_show_stats (GLOBAL);
+}
 
-	return FALSE;
+static void
+top10_global_update_add (Top10Transfer * xfer, const gchar * host, const gchar * ksc)
+{
+	gchar *tmp;
+	gchar *url;
+	gchar *path;
+	gchar *validators = NULL;
+
+	tmp = g_build_filename (main_path_score (), ksc, NULL);
+	if (g_file_test (tmp, G_FILE_TEST_IS_REGULAR))
+	{
+		path = g_strconcat (tmp, ".http", NULL);
+		if (!g_file_get_contents (path, &validators, NULL, NULL))
+			validators = NULL;
+		g_free (path);
+	}
+	url = g_strdup_printf ("http://%s/%s", host, ksc);
+	path = g_strconcat (tmp, ".part", NULL);
+	g_free (tmp);
+
+	top10_transfer_add (xfer, url, path, validators);
 }
 
 gboolean
-top10_global_publish (gpointer data)
+top10_global_update (gpointer data)
 {
-	gint i;
-	gboolean success;
 	gchar *tmp;
 	gchar *ksc;
 	gchar *host;
-	gchar *path;
-	gchar *username;
-	gchar *url;
+	const gchar *name;
+	GDir *dir;
 	GtkImage *img;
-	FILE *fh, *fh2;
-	struct stat fs;
-	CURL *curl;
+	Top10Transfer *xfer;
 	
-	fs.st_size = 0;
-	img = GTK_IMAGE (get_wg ("image_top10_publish"));
+	img = GTK_IMAGE (get_wg ("image_top10_update"));
 	top10_message (NULL);
 
 	if (!main_curl_ok ())
 	{
-		tmp = g_strconcat (_("Not able to upload files"), ": 'libcurl' ", _("not found"), ". ",
+		tmp = g_strconcat (_("Not able to download files"), ": 'libcurl' ", _("not found"), ". ",
 		       _("Are you sure you have it installed in your system?"), NULL);
 		top10_message (tmp);
 		g_free (tmp);
-		gtk_image_set_from_icon_name (img, "go-top", GTK_ICON_SIZE_BUTTON);
-		return FALSE;
-	}
-
-	if (! (curl = curl_easy_init ()))
-	{
-		g_message ("Not able to initialize curl session");
-		gtk_image_set_from_icon_name (img, "go-top", GTK_ICON_SIZE_BUTTON);
+		gtk_image_set_from_icon_name (img, "go-bottom", GTK_ICON_SIZE_BUTTON);
 		return FALSE;
 	}
 
 	/**************************************************
-	 * Upload to uphost, updating local ranking
+	 * Download from downhost: the current language first, then the others
+	 * already downloaded before; only what changed comes through.
 	 */
-	host = g_strdup (CGI_SERVER);
-	tmp = main_preferences_get_string ("interface", "language");
-	if (tmp[0] == 'C')
+	if (!g_file_test (main_path_score (), G_FILE_TEST_IS_DIR))
+		g_mkdir_with_parents (main_path_score (), DIR_PERM);
+	host = top10_get_host (FALSE);
+	ksc = top10_get_score_file (GLOBAL, -1);
+	xfer = top10_transfer_new (FALSE, top10_global_update_done);
+	top10_global_update_add (xfer, host, ksc);
+	if ((dir = g_dir_open (main_path_score (), 0, NULL)))
 	{
-		g_free (tmp);
-		tmp = g_strdup ("en");
+		while ((name = g_dir_read_name (dir)))
+			if (g_str_has_prefix (name, "global_") && g_str_has_suffix (name, ".ksc") &&
+			    strlen (name) == strlen ("global_xx.ksc") && !g_str_equal (name, ksc))
+				top10_global_update_add (xfer, host, name);
+		g_dir_close (dir);
 	}
-	ksc = g_strdup_printf ("local_%c%c.ksc", tmp[0], tmp[1]);
-	path = g_build_filename (main_path_score (), ksc, NULL);
 	g_free (ksc);
-	g_stat (path, &fs);
+	g_free (host);
+
+	if (!top10_transfer_start (xfer))
+	{
+		top10_message (_("Could not download file from the host server."));
+		gtk_image_set_from_icon_name (img, "go-bottom", GTK_ICON_SIZE_BUTTON);
+	}
+
+	return FALSE;
+}
+
+/**************************************************
+ * Outbox of scores waiting to be published: kept in a file, so nothing
+ * is lost while offline, and sent in batches (one upload per language,
+ * all through the same connection) with growing delays between failures
+ */
+#define OUTBOX_RETRY_MIN 30	/* seconds */
+#define OUTBOX_RETRY_MAX 3600
+#define OUTBOX_RETRY_BUSY 5
+
+static struct
+{
+	guint retry_id;
+	guint delay;
+	GArray *batch;		/* Statistics in the uploads being sent */
+} outbox = { 0, 0, NULL };
+
+static gchar *
+top10_outbox_file (void)
+{
+	return (g_build_filename (main_path_score (), "outbox.ksc", NULL));
+}
+
+static GSequence *
+top10_outbox_load (void)
+{
+	guint i;
+	gchar *file;
+	GArray *stats;
+	GSequence *seq;
+
+	seq = g_sequence_new (g_free);
+	file = top10_outbox_file ();
+	if ((stats = ksc_load_file (file)))
+	{
+		for (i = 0; i < stats->len; i++)
+			g_sequence_append (seq, g_memdup (&g_array_index (stats, Statistics, i),
+							  sizeof (Statistics)));
+		g_array_free (stats, TRUE);
+	}
+	g_free (file);
+	return (seq);
+}
+
+static void
+top10_outbox_save (GSequence * seq)
+{
+	gchar *file;
+	GByteArray *buf;
+
+	if (!g_file_test (main_path_score (), G_FILE_TEST_IS_DIR))
+		g_mkdir_with_parents (main_path_score (), DIR_PERM);
+
+	file = top10_outbox_file ();
+	if (g_sequence_get_length (seq) == 0)
+		g_unlink (file);
+	else
+	{
+		buf = ksc_compile (seq);
+		if (!g_file_set_contents (file, (gchar *) buf->data, buf->len, NULL))
+			g_warning ("Could not write the scores outbox in %s", main_path_score ());
+		g_byte_array_free (buf, TRUE);
+	}
+	g_free (file);
+}
+
+/* Each record goes once, whatever the times it gets queued
+ */
+static void
+top10_outbox_add (GSequence * seq, const Statistics * stat)
+{
+	GSequenceIter *it;
+	Statistics *st;
+
+	it = g_sequence_get_begin_iter (seq);
+	for (; !g_sequence_iter_is_end (it); it = g_sequence_iter_next (it))
+	{
+		st = g_sequence_get (it);
+		if (st->when == stat->when && g_str_equal (st->name, stat->name))
+			return;
+	}
+	g_sequence_append (seq, g_memdup (stat, sizeof (Statistics)));
+}
+
+/* Only the records sent may leave the outbox: others may have come meanwhile
+ */
+static gboolean
+top10_outbox_in_batch (const Statistics * stat)
+{
+	guint i;
+	Statistics *st;
+
+	for (i = 0; outbox.batch && i < outbox.batch->len; i++)
+	{
+		st = &g_array_index (outbox.batch, Statistics, i);
+		if (st->when == stat->when && g_str_equal (st->name, stat->name))
+			return (TRUE);
+	}
+	return (FALSE);
+}
+
+static void
+top10_outbox_batch_free (void)
+{
+	if (outbox.batch)
+		g_array_free (outbox.batch, TRUE);
+	outbox.batch = NULL;
+}
+
+static gchar *
+top10_publish_url (const gchar * host, const gchar * lang)
+{
+	gchar *ksc;
+	gchar *url;
+	gchar *username;
 
 	username = g_strdup (g_get_real_name ());
 	username = g_strdelimit (username, " ", '_');
@@ -940,53 +1293,237 @@ top10_global_publish (gpointer data)
 		g_free (username);
 		username = g_strdup (g_get_user_name ());
 	}
-	ksc = g_strdup_printf ("%s_%s_%c%c.ksc", username, g_get_host_name (), tmp[0], tmp[1]);
-	url = g_strdup_printf ("http://%s?dosiernomo=%s&lingvo=%c%c", host, ksc, tmp[0], tmp[1]);
+	ksc = g_strdup_printf ("%s_%s_%c%c.ksc", username, g_get_host_name (), lang[0], lang[1]);
+	url = g_strdup_printf ("http://%s?dosiernomo=%s&lingvo=%c%c", host, ksc, lang[0], lang[1]);
 	g_free (username);
-	g_free (host);
 	g_free (ksc);
-	g_free (tmp);
+	return (url);
+}
+
+static void
+top10_outbox_retry (guint delay)
+{
+	if (outbox.retry_id)
+		g_source_remove (outbox.retry_id);
+	outbox.retry_id = g_timeout_add_seconds (delay, top10_outbox_flush, NULL);
+}
+
+static void
+top10_outbox_done (Top10Transfer * xfer)
+{
+	guint i;
+	gchar lang[2];
+	gchar *name;
+	gboolean sent;
+	gboolean failed;
+	GSequence *seq;
+	GSequenceIter *it;
+	GSequenceIter *next;
+	Statistics *st;
+	Top10Item *item;
+
+	gtk_image_set_from_icon_name (GTK_IMAGE (get_wg ("image_top10_publish")), "go-top",
+				      GTK_ICON_SIZE_BUTTON);
+
+	sent = failed = FALSE;
+	seq = top10_outbox_load ();
+	for (i = 0; i < xfer->items->len; i++)
+	{
+		item = g_ptr_array_index (xfer->items, i);
+		name = g_path_get_basename (item->path);
+		lang[0] = name[strlen ("upload_")];
+		lang[1] = name[strlen ("upload_") + 1];
+		g_free (name);
+		g_unlink (item->path);
+
+		if (item->result != CURLE_OK || item->code >= 400)
+		{
+			failed = TRUE;
+			continue;
+		}
+		sent = TRUE;
+		for (it = g_sequence_get_begin_iter (seq); !g_sequence_iter_is_end (it); it = next)
+		{
+			next = g_sequence_iter_next (it);
+			st = g_sequence_get (it);
+			if (st->lang[0] == lang[0] && st->lang[1] == lang[1] && top10_outbox_in_batch (st))
+				g_sequence_remove (it);
+		}
+	}
+	top10_outbox_save (seq);
+	top10_outbox_batch_free ();
+
+	if (failed)
+	{
+		outbox.delay = outbox.delay ? MIN (2 * outbox.delay, OUTBOX_RETRY_MAX) : OUTBOX_RETRY_MIN;
+		top10_outbox_retry (outbox.delay);
+		if (!g_atomic_int_get (&xfer->cancelled))
+		{
+			g_message ("HTTP upload failed! Trying again in %u s", outbox.delay);
+			top10_message (_("Could not upload/download scores."));
+		}
+	}
+	else
+		outbox.delay = 0;
+	g_sequence_free (seq);
+
+	if (sent && !failed)
+		g_idle_add ((GSourceFunc) top10_global_update, NULL);
+}
+
+gboolean
+top10_outbox_flush (gpointer data)
+{
+	guint i;
+	gchar *tmp;
+	gchar *code;
+	gchar *host;
+	gchar *path;
+	GHashTable *boards;
+	GHashTableIter iter;
+	GSequence *seq;
+	GSequenceIter *it;
+	GArray *stats;
+	Statistics *st;
+	KscBoard *board;
+	Top10Transfer *xfer;
+
+	outbox.retry_id = 0;
+	if (!main_curl_ok ())
+		return (FALSE);
+	if (top10_transfer_busy ())
+	{
+		top10_outbox_retry (OUTBOX_RETRY_BUSY);
+		return (FALSE);
+	}
+
+	seq = top10_outbox_load ();
+	if (g_sequence_get_length (seq) == 0)
+	{
+		g_sequence_free (seq);
+		return (FALSE);
+	}
 
-	/*
-	curl_easy_setopt (curl, CURLOPT_VERBOSE, 1);
+	/* Each language's upload has the best of the local ranking and of the outbox
 	 */
-	curl_easy_setopt (curl, CURLOPT_TIMEOUT, TIMEOUT);
-	curl_easy_setopt (curl, CURLOPT_LOW_SPEED_LIMIT, LOW_SPEED_LIMIT);
-	curl_easy_setopt (curl, CURLOPT_LOW_SPEED_TIME, LOW_SPEED_TIME);
-	curl_easy_setopt (curl, CURLOPT_UPLOAD, TRUE);
-	curl_easy_setopt (curl, CURLOPT_INFILESIZE, (long) fs.st_size);
-	curl_easy_setopt (curl, CURLOPT_URL, url);
-	success = FALSE;
-	if ( (fh = g_fopen (path, "rb")) )
+	top10_outbox_batch_free ();
+	outbox.batch = g_array_new (FALSE, FALSE, sizeof (Statistics));
+	boards = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	it = g_sequence_get_begin_iter (seq);
+	for (; !g_sequence_iter_is_end (it); it = g_sequence_iter_next (it))
 	{
-		i = 0;
-		while (1)
+		st = g_sequence_get (it);
+		g_array_append_vals (outbox.batch, st, 1);
+		code = g_strndup (st->lang, 2);
+		if ((board = g_hash_table_lookup (boards, code)) == NULL)
 		{
-			tmp = g_strdup_printf ("%s/klavaro_%03i.html", g_get_tmp_dir (), i++);
-			if ((fh2 = g_fopen (tmp, "wb")))
-				break;
+			board = g_new0 (KscBoard, 1);
+			ksc_board_init (board);
+			tmp = g_strdup_printf ("local_%s.ksc", code);
+			path = g_build_filename (main_path_score (), tmp, NULL);
+			if ((stats = ksc_load_file (path)))
+			{
+				for (i = 0; i < stats->len; i++)
+					ksc_board_insert (board, &g_array_index (stats, Statistics, i));
+				g_array_free (stats, TRUE);
+			}
+			g_free (path);
 			g_free (tmp);
+			g_hash_table_insert (boards, g_strdup (code), board);
 		}
+		ksc_board_insert (board, st);
+		g_free (code);
+	}
+	g_sequence_free (seq);
+
+	host = top10_get_host (TRUE);
+	xfer = top10_transfer_new (TRUE, top10_outbox_done);
+	g_hash_table_iter_init (&iter, boards);
+	while (g_hash_table_iter_next (&iter, (gpointer *) &code, (gpointer *) &board))
+	{
+		tmp = g_strdup_printf ("upload_%s.ksc", code);
+		path = g_build_filename (main_path_score (), tmp, NULL);
 		g_free (tmp);
-		curl_easy_setopt (curl, CURLOPT_READDATA, fh);
-		curl_easy_setopt (curl, CURLOPT_WRITEDATA, fh2);
-		if (curl_easy_perform (curl))
-			g_message ("HTTP upload failed!");
+		if (top10_write_old_stats (board, path))
+			top10_transfer_add (xfer, top10_publish_url (host, code), path, NULL);
 		else
-			success = TRUE;
-		fclose (fh);
-		fclose (fh2);
+			g_free (path);
+		ksc_board_destroy (board);
+		g_free (board);
 	}
-	curl_easy_cleanup (curl);
-	g_free (path);
-	g_free (url);
+	g_hash_table_destroy (boards);
+	g_free (host);
 
-	gtk_image_set_from_icon_name (img, "go-top", GTK_ICON_SIZE_BUTTON);
+	if (xfer->items->len == 0 || !top10_transfer_start (xfer))
+	{
+		top10_outbox_batch_free ();
+		outbox.delay = outbox.delay ? MIN (2 * outbox.delay, OUTBOX_RETRY_MAX) : OUTBOX_RETRY_MIN;
+		top10_outbox_retry (outbox.delay);
+		gtk_image_set_from_icon_name (GTK_IMAGE (get_wg ("image_top10_publish")), "go-top",
+					      GTK_ICON_SIZE_BUTTON);
+	}
+	return (FALSE);
+}
 
-	if (!success)
-		top10_message (_("Could not upload/download scores."));
-	else
-		g_idle_add ((GSourceFunc) top10_global_update, NULL);
+/* Connectivity is back: don't wait for the next retry
+ */
+static void
+top10_outbox_network_changed (GNetworkMonitor * monitor, gboolean available, gpointer data)
+{
+	if (available && outbox.retry_id != 0)
+	{
+		outbox.delay = 0;
+		top10_outbox_retry (OUTBOX_RETRY_BUSY);
+	}
+}
+
+void
+top10_outbox_init ()
+{
+	gchar *file;
+
+	g_signal_connect (g_network_monitor_get_default (), "network-changed",
+			  G_CALLBACK (top10_outbox_network_changed), NULL);
+
+	file = top10_outbox_file ();
+	if (g_file_test (file, G_FILE_TEST_IS_REGULAR))
+		top10_outbox_retry (OUTBOX_RETRY_MIN);
+	g_free (file);
+}
+
+gboolean
+top10_global_publish (gpointer data)
+{
+	gint i;
+	gchar *tmp;
+	GtkImage *img;
+	GSequence *seq;
+	
+	img = GTK_IMAGE (get_wg ("image_top10_publish"));
+	top10_message (NULL);
+
+	if (!main_curl_ok ())
+	{
+		tmp = g_strconcat (_("Not able to upload files"), ": 'libcurl' ", _("not found"), ". ",
+		       _("Are you sure you have it installed in your system?"), NULL);
+		top10_message (tmp);
+		g_free (tmp);
+		gtk_image_set_from_icon_name (img, "go-top", GTK_ICON_SIZE_BUTTON);
+		return FALSE;
+	}
+
+	/**************************************************
+	 * Queue the local ranking, then try to upload at once
+	 */
+	top10_read_stats (LOCAL, -1);
+	seq = top10_outbox_load ();
+	for (i = 0; i < TOP10_SHOWN && top10_get_stat (i, LOCAL); i++)
+		top10_outbox_add (seq, top10_get_stat (i, LOCAL));
+	top10_outbox_save (seq);
+	g_sequence_free (seq);
+
+	outbox.delay = 0;
+	top10_outbox_flush (NULL);
 
 	return FALSE;
 }
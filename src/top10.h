@@ -16,6 +16,8 @@
 #define DOWNHOST "klavaro.sourceforge.net/top10"
 #define CGI_SERVER "klavaro.sourceforge.net/cgi-bin/klavaro_rangilo"
 #define MIN_CHARS_TO_LOG 500
+#define TOP10_SHOWN 10
+#define TOP10_BOARD_SIZE 1000
 
 #define TIMEOUT 10
 #define LOW_SPEED_LIMIT 160
@@ -51,13 +53,13 @@ void top10_message (gchar * msg);
 
 void top10_init_stats (gboolean locally);
 
-void top10_clean_stat (gint i, gboolean locally);
+gint top10_get_n_stats (gboolean locally);
 
-void top10_insert_stat (Statistics * stat, gint i, gboolean locally);
+const Statistics *top10_get_stat (gint i, gboolean locally);
 
-gboolean top10_compare_insert_stat (Statistics * stat, gboolean locally);
+gint top10_get_rank (Statistics * stat, gboolean locally);
 
-void top10_delete_stat (gint i, gboolean locally);
+gboolean top10_compare_insert_stat (Statistics * stat, gboolean locally);
 
 gfloat top10_calc_score (Statistics * stat);
 
@@ -75,7 +77,15 @@ void top10_show_stat (Statistics * stats);
 
 void top10_show_stats (gboolean locally);
 
+void top10_transfer_cancel (gboolean wait);
+
+gboolean top10_transfer_busy (void);
+
 gboolean top10_global_update (gpointer data);
 
+void top10_outbox_init (void);
+
+gboolean top10_outbox_flush (gpointer data);
+
 gboolean top10_global_publish (gpointer data);
 
@@ -233,12 +233,25 @@ trans_lang_has_stopmark ()
 	gchar *hlp;
 
 	hlp = main_preferences_get_string ("interface", "language");
-	stopmark = g_str_has_prefix (hlp, "ur") ||
-		   g_str_has_prefix (hlp, "ar") ||
-		   g_str_has_prefix (hlp, "bn") ||
-		   g_str_has_prefix (hlp, "pa");
+	stopmark = trans_code_has_stopmark (hlp);
 	g_free (hlp);
 
+	return (stopmark);
+}
+
+/* Same as above, for a given language code: it doesn't touch the preferences,
+ * so it may be used by the exercise generators outside of the main loop.
+ */
+gboolean
+trans_code_has_stopmark (const gchar *code)
+{
+	gboolean stopmark;
+
+	stopmark = g_str_has_prefix (code, "ur") ||
+		   g_str_has_prefix (code, "ar") ||
+		   g_str_has_prefix (code, "bn") ||
+		   g_str_has_prefix (code, "pa");
+
 	return (!stopmark);
 }
 
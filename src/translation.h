@@ -83,6 +83,8 @@ gboolean trans_lang_is_available (gchar * test);
 
 gboolean trans_lang_has_stopmark (void);
 
+gboolean trans_code_has_stopmark (const gchar *code);
+
 FILE *trans_lang_get_similar_file (const gchar * file_end);
 
 gchar * trans_lang_get_similar_file_name (const gchar * file_end);
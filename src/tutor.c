@@ -35,7 +35,9 @@
 #include "velocity.h"
 #include "fluidness.h"
 #include "accuracy.h"
+#include "markov.h"
 #include "top10.h"
+#include "stats.h"
 #include "tutor.h"
 
 #define MAX_TOUCH_TICS 10000
@@ -51,6 +53,7 @@ struct
 	gint n_errors;
 	gint retro_pos;
 	gint correcting;
+	guint64 seed;
 } tutor;
 
 struct
@@ -261,6 +264,317 @@ tutor_goal_level (guint n)
 	return -4.0;
 }
 
+/**********************************************************************
+ * The next exercise is prepared in a separate thread while the student
+ * reads the statistics, so that restarting only inserts the ready text.
+ * All that the generators need from widgets and preferences is copied
+ * here, in the main loop; the 'key' tells if it is still valid when used.
+ */
+typedef struct
+{
+	gchar *key;
+	TutorType type;
+	gchar *lang;
+	gunichar *char_set;
+	gint char_set_size;
+	gboolean special;
+	gint par_num;
+	gboolean double_spaces;
+	guint64 seed;
+	GString *text;
+} Exercise;
+
+static struct
+{
+	GThread *thread;
+	Exercise *ex;
+} prefetch = { NULL, NULL };
+
+static Exercise *
+tutor_exercise_new ()
+{
+	gint i;
+	gchar *tmp;
+	gunichar *char_set;
+	Exercise *ex;
+
+	ex = g_new0 (Exercise, 1);
+	ex->type = tutor.type;
+	ex->lang = main_preferences_get_string ("interface", "language");
+	switch (tutor.type)
+	{
+	case TT_BASIC:
+		char_set = basic_get_char_set ();
+		for (i = 0; char_set[i] != L'\0'; i++);
+		ex->char_set_size = i;
+		ex->char_set = g_new (gunichar, i + 1);
+		memcpy (ex->char_set, char_set, (i + 1) * sizeof (gunichar));
+		break;
+	case TT_ADAPT:
+		ex->special = adapt_get_special ();
+		markov_prepare (ex->lang);
+		break;
+	case TT_VELO:
+		break;
+	case TT_FLUID:
+		ex->par_num = main_preferences_get_int ("tutor", "fluid_paragraphs");
+		ex->double_spaces = main_preferences_get_boolean ("tutor", "double_spaces");
+	}
+
+	if (ex->char_set)
+		tmp = g_ucs4_to_utf8 (ex->char_set, -1, NULL, NULL, NULL);
+	else
+		tmp = g_strdup ("");
+	ex->key = g_strdup_printf ("%i|%s|%s|%s|%i|%i|%i", ex->type, keyb_get_name (), ex->lang, tmp,
+			ex->special, ex->par_num, ex->double_spaces);
+	g_free (tmp);
+
+	/* Initialized here, not in the thread */
+	keyb_get_utf8_paragraph_symbol ();
+	keyb_get_classes ();
+
+	return (ex);
+}
+
+static void
+tutor_exercise_free (Exercise *ex)
+{
+	if (ex == NULL)
+		return;
+	g_free (ex->key);
+	g_free (ex->lang);
+	g_free (ex->char_set);
+	if (ex->text)
+		g_string_free (ex->text, TRUE);
+	g_free (ex);
+}
+
+/* Thread safe: uses only the copies kept in 'data'
+ */
+static gpointer
+tutor_exercise_build (gpointer data)
+{
+	Exercise *ex = data;
+	Rnd rnd;
+
+	rnd_seed (&rnd, ex->seed);
+	ex->text = g_string_sized_new (4096);
+	switch (ex->type)
+	{
+	case TT_BASIC:
+		basic_create_lesson (ex->text, ex->char_set, ex->char_set_size, &rnd);
+		break;
+	case TT_ADAPT:
+		adapt_create_random_pattern (ex->text, ex->special, ex->lang, &rnd);
+		break;
+	case TT_VELO:
+		velo_create_random_words (ex->text, ex->lang, &rnd);
+		break;
+	case TT_FLUID:
+		fluid_create_random_paragraphs (ex->text, ex->par_num, ex->double_spaces, &rnd);
+	}
+	return (ex);
+}
+
+void
+tutor_prefetch_start ()
+{
+	GError *error = NULL;
+
+	tutor_prefetch_discard ();
+	prefetch.ex = tutor_exercise_new ();
+	prefetch.ex->seed = rnd_new_seed ();
+	prefetch.thread = g_thread_try_new ("next_exercise", tutor_exercise_build, prefetch.ex, &error);
+	if (prefetch.thread == NULL)
+	{
+		g_message ("could not prepare the next exercise in background: %s", error->message);
+		g_error_free (error);
+		tutor_exercise_free (prefetch.ex);
+		prefetch.ex = NULL;
+	}
+}
+
+/* Must be called before changing anything the generators read from
+ * (dictionary, paragraphs, keyboard, accuracy data)
+ */
+void
+tutor_prefetch_discard ()
+{
+	if (prefetch.thread)
+		g_thread_join (prefetch.thread);
+	prefetch.thread = NULL;
+	tutor_exercise_free (prefetch.ex);
+	prefetch.ex = NULL;
+}
+
+static Exercise *
+tutor_prefetch_take ()
+{
+	Exercise *ex;
+
+	if (prefetch.thread)
+		g_thread_join (prefetch.thread);
+	prefetch.thread = NULL;
+	ex = prefetch.ex;
+	prefetch.ex = NULL;
+	return (ex);
+}
+
+/**********************************************************************
+ * Apply the font and the wrapping tags to a range of exercise text
+ */
+static void
+tutor_apply_text_tags (GtkTextBuffer *buf, GtkTextIter *range_start, GtkTextIter *range_end)
+{
+	GtkTextIter start;
+	GtkTextIter end;
+
+	start = *range_start;
+	end = *range_end;
+	gtk_text_iter_backward_char (&end);
+	gtk_text_buffer_apply_tag_by_name (buf, "lesson_font", &start, &end);
+
+	/* Trying to minimize automatic wrapping because of cursor blinking:
+	*/
+	end = start;
+	while (gtk_text_iter_forward_word_end (&end) && gtk_text_iter_compare (&end, range_end) <= 0)
+	{
+		gtk_text_buffer_apply_tag_by_name (buf, "char_keep_wrap", &start, &end);
+		start = end;
+		if (! gtk_text_iter_forward_char (&end))
+			break;
+		gtk_text_buffer_apply_tag_by_name (buf, "char_keep_wrap2", &start, &end);
+		start = end;
+	}
+}
+
+/**********************************************************************
+ * Long exercises ("use all the text" fluidness) aren't put at once in the
+ * tutor text buffer: only a window of paragraphs around the cursor is kept
+ * there, so that the cost of each touch doesn't grow with the text length.
+ * Every paragraph is a single line of the buffer.
+ */
+#define WINDOW_MIN_PARS 8
+#define WINDOW_AHEAD 2
+#define WINDOW_BEHIND 1
+static struct
+{
+	gchar **par;
+	gint n_par;
+	gint first;
+	gint last;
+} parwin = { NULL, 0, 0, 0 };
+
+static void
+tutor_window_load (GtkTextBuffer *buf)
+{
+	gint offset;
+	GtkTextIter start;
+	GtkTextIter end;
+
+	gtk_text_buffer_get_end_iter (buf, &end);
+	offset = gtk_text_iter_get_offset (&end);
+	gtk_text_buffer_insert (buf, &end, parwin.par[parwin.last], -1);
+	parwin.last++;
+
+	gtk_text_buffer_get_iter_at_offset (buf, &start, offset);
+	gtk_text_buffer_get_end_iter (buf, &end);
+	tutor_apply_text_tags (buf, &start, &end);
+}
+
+/* Put the exercise 'text' in the (empty) buffer, entirely or just its first paragraphs,
+ * each part tagged once as it comes in
+ */
+void
+tutor_window_set (GtkTextBuffer *buf, const gchar *text)
+{
+	gint i;
+	gchar **line;
+	GtkTextIter start;
+	GtkTextIter end;
+
+	g_strfreev (parwin.par);
+	parwin.par = NULL;
+	parwin.n_par = 0;
+	parwin.first = 0;
+	parwin.last = 0;
+
+	line = g_strsplit (text, "\n", -1);
+	if (tutor.type != TT_FLUID || g_strv_length (line) <= WINDOW_MIN_PARS + 1)
+	{
+		g_strfreev (line);
+		gtk_text_buffer_insert_at_cursor (buf, text, -1);
+		gtk_text_buffer_get_bounds (buf, &start, &end);
+		tutor_apply_text_tags (buf, &start, &end);
+		return;
+	}
+
+	/* The last string is what follows the last '\n', that is, nothing
+	 */
+	parwin.n_par = g_strv_length (line) - 1;
+	parwin.par = g_new0 (gchar *, parwin.n_par + 1);
+	for (i = 0; i < parwin.n_par; i++)
+		parwin.par[i] = g_strconcat (line[i], "\n", NULL);
+	g_strfreev (line);
+
+	gtk_text_buffer_insert_at_cursor (buf, parwin.par[0], -1);
+	gtk_text_buffer_get_bounds (buf, &start, &end);
+	tutor_apply_text_tags (buf, &start, &end);
+	parwin.last = 1;
+	while (parwin.last <= WINDOW_AHEAD)
+		tutor_window_load (buf);
+}
+
+/* Load the paragraphs coming next to the cursor and unload the ones already typed.
+ * Those behind are kept while there are errors to be corrected (backspace).
+ */
+void
+tutor_window_slide ()
+{
+	gint cur;
+	GtkWidget *wg;
+	GtkTextBuffer *buf;
+	GtkTextIter start;
+	GtkTextIter end;
+
+	if (parwin.par == NULL)
+		return;
+
+	wg = get_wg ("text_tutor");
+	buf = gtk_text_view_get_buffer (GTK_TEXT_VIEW (wg));
+	gtk_text_buffer_get_iter_at_mark (buf, &end, gtk_text_buffer_get_insert (buf));
+	cur = parwin.first + gtk_text_iter_get_line (&end);
+
+	while (parwin.last < parwin.n_par && parwin.last <= cur + WINDOW_AHEAD)
+		tutor_window_load (buf);
+
+	if (tutor.retro_pos == 0 && cur - parwin.first > WINDOW_BEHIND)
+	{
+		gtk_text_buffer_get_start_iter (buf, &start);
+		gtk_text_buffer_get_iter_at_line (buf, &end, cur - parwin.first - WINDOW_BEHIND);
+		gtk_text_buffer_delete (buf, &start, &end);
+		parwin.first = cur - WINDOW_BEHIND;
+		gtk_text_view_scroll_mark_onscreen (GTK_TEXT_VIEW (wg), gtk_text_buffer_get_insert (buf));
+	}
+}
+
+/* The whole exercise text, be it windowed or not
+ */
+gchar *
+tutor_window_get_text ()
+{
+	GtkTextBuffer *buf;
+	GtkTextIter start;
+	GtkTextIter end;
+
+	if (parwin.par)
+		return (g_strjoinv ("", parwin.par));
+
+	buf = gtk_text_view_get_buffer (GTK_TEXT_VIEW (get_wg ("text_tutor")));
+	gtk_text_buffer_get_bounds (buf, &start, &end);
+	return (gtk_text_buffer_get_text (buf, &start, &end, FALSE));
+}
+
 /**********************************************************************
  * Initialize the course 
  */
@@ -279,6 +593,7 @@ tutor_init (TutorType tt_type)
 	gtk_widget_show (get_wg ("window_tutor"));
 	gtk_widget_grab_focus (get_wg ("entry_mesg"));
 
+	tutor_prefetch_discard ();
 	tutor.type = tt_type;
 	cursor_set_blink (FALSE);
 
@@ -482,6 +797,8 @@ tutor_update_intro ()
 	callbacks_shield_set (TRUE);
 	gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (get_wg ("togglebutton_tutor_intro")), TRUE);
 	callbacks_shield_set (FALSE);
+
+	tutor_prefetch_start ();
 }
 
 void
@@ -493,9 +810,9 @@ tutor_update_start ()
 	GdkRGBA color;
 	GtkWidget *wg;
 	GtkTextBuffer *buf;
-	GtkTextIter start;
-	GtkTextIter end;
 	GtkAdjustment *scroll;
+	Exercise *ex;
+	Exercise *ready;
 
 	/*
 	 * Delete all the text on tutor window
@@ -517,23 +834,28 @@ tutor_update_start ()
 		wg = get_wg ("label_heading");
 		gtk_label_set_text (GTK_LABEL (wg), text);
 		g_free (text);
-
-		basic_draw_lesson ();
 	}
 
-	switch (tutor.type)
+	/*
+	 * Insert the exercise text, built right now if the prepared one doesn't fit
+	 */
+	ready = tutor_prefetch_take ();
+	ex = tutor_exercise_new ();
+	if (ready && g_str_equal (ready->key, ex->key))
 	{
-	case TT_BASIC:
-		break;
-	case TT_ADAPT:
-		adapt_draw_random_pattern ();
-		break;
-	case TT_VELO:
-		velo_draw_random_words ();
-		break;
-	case TT_FLUID:
-		fluid_draw_random_paragraphs ();
+		tutor_exercise_free (ex);
+		ex = ready;
+	}
+	else
+	{
+		/* The seed already drawn is kept, so that '--seed' still rules */
+		ex->seed = ready ? ready->seed : rnd_new_seed ();
+		tutor_exercise_free (ready);
+		tutor_exercise_build (ex);
 	}
+	tutor.seed = ex->seed;
+	tutor_window_set (buf, ex->text->str);
+	tutor_exercise_free (ex);
 
 	/*
 	 * Apply tutor background color and font to the text
@@ -546,23 +868,6 @@ tutor_update_start ()
 	gtk_widget_override_background_color (get_wg ("text_tutor"), GTK_STATE_FLAG_INSENSITIVE, &color);
 	g_free (color_bg);
 
-	gtk_text_buffer_get_bounds (buf, &start, &end);
-	gtk_text_iter_backward_char (&end);
-	gtk_text_buffer_apply_tag_by_name (buf, "lesson_font", &start, &end);
-
-	/* Trying to minimize automatic wrapping because of cursor blinking:
-	*/
-	end = start;
-	while (gtk_text_iter_forward_word_end (&end))
-	{
-		gtk_text_buffer_apply_tag_by_name (buf, "char_keep_wrap", &start, &end);
-		start = end;
-		if (! gtk_text_iter_forward_char (&end))
-			break;
-		gtk_text_buffer_apply_tag_by_name (buf, "char_keep_wrap2", &start, &end);
-		start = end;
-	}
-	
 	if (tutor.type == TT_FLUID)
 		tmp_name = g_strconcat (_("Start typing when you are ready. "), " ",
 			       _("Use backspace to correct errors."), " ", NULL);
@@ -646,7 +951,10 @@ tutor_process_touch (gunichar user_chr)
 
 		g_timer_start (tutor.tmr);
 		if (tutor.type == TT_FLUID)
+		{
 			tutor_eval_forward_backward (user_chr);
+			tutor_window_slide ();
+		}
 		else
 			tutor_eval_forward (user_chr);
 
@@ -707,6 +1015,7 @@ tutor_process_touch (gunichar user_chr)
 		tutor.query = QUERY_END;
 		tutor_update ();
 		tutor_beep ();
+		tutor_prefetch_start ();
 	}
 	else
 	{
@@ -727,6 +1036,7 @@ tutor_process_touch (gunichar user_chr)
 			return;
 		case TT_FLUID:
 			cursor_off (NULL);
+			tutor_window_slide ();
 			return;
 		}
 	}
@@ -954,13 +1264,12 @@ tutor_calc_stats ()
 	gchar *tmp_name;
 	gchar *tmp;
 	FILE *fh;
-	time_t tmp_time;
-	struct tm *ltime;
 	GtkWidget *wg;
 	GtkTextBuffer *buf;
 	GtkTextIter start;
 	GtkTextIter end;
 	Statistics stat;
+	StatsRecord session;
 
 	/*
 	 * Calculate statistics
@@ -1036,78 +1345,44 @@ tutor_calc_stats ()
 		/*
 		 * Logging
 		 */
-		tmp_name =
-			g_strconcat (main_path_stats (), G_DIR_SEPARATOR_S "stat_", tutor_get_type_name (), ".txt",
-				     NULL);
-		assert_user_dir ();
-		if (!(fh = (FILE *) g_fopen (tmp_name, "r")))
+		memset (&session, 0, sizeof (StatsRecord));
+		session.module = tutor.type;
+		session.when = time (NULL);
+		session.seed = tutor.seed;
+		session.accur = accuracy;
+		session.velo = velocity;
+		session.fluid = fluidness;
+		session.name = STATS_NONE;
+		switch (tutor.type)
 		{
-			fh = (FILE *) g_fopen (tmp_name, "w");
-			if (tutor.type == TT_BASIC)
-				fprintf (fh, "Accuracy\tVelocity\tFluidness\tDate\tHour\tLesson\tKeyboard\n");
-			else if (tutor.type == TT_ADAPT)
-				fprintf (fh, "Accuracy\tVelocity\tFluidness\tDate\tHour\tKeyboard\tLanguage\n");
-			else
-				fprintf (fh, "Accuracy\tVelocity\tFluidness\tDate\tHour\tLesson\tLanguage\n");
+		case TT_BASIC:
+			session.lesson = basic_get_lesson ();
+			tmp = g_strdup (keyb_get_name ());
+			break;
+		case TT_ADAPT:
+			tmp = g_strdup (keyb_get_name ());
+			break;
+		case TT_VELO:
+			tmp = g_strdup (velo_get_dict_name ());
+			break;
+		default:
+			tmp = g_strdup (fluid_get_paragraph_name ());
 		}
-		else
+		for (i=0; tmp[i]; i++)
+			tmp[i] = (tmp[i] == ' ') ? '_' : tmp[i];
+		if (tutor.type == TT_BASIC || tutor.type == TT_ADAPT)
 		{
-			fclose (fh);
-			fh = (FILE *) g_fopen (tmp_name, "a");
+			session.key = stats_intern (tmp);
+			if (tutor.type == TT_ADAPT)
+				session.name = stats_intern (trans_get_current_language ());
 		}
-		if (fh)
+		else
 		{
-			tmp_time = time (NULL);
-			ltime = localtime (&tmp_time);
-			fprintf (fh,
-				 "%.2f\t%.2f\t%.2f\t%i-%2.2i-%2.2i\t%2.2i:%2.2i\t",
-				 accuracy, velocity, fluidness,
-				 (ltime->tm_year) + 1900, (ltime->tm_mon) + 1,
-				 (ltime->tm_mday), (ltime->tm_hour), (ltime->tm_min));
-			switch (tutor.type)
-			{
-			case TT_BASIC:
-				fprintf (fh, "%2.2i\t", basic_get_lesson ());
-				break;
-			case TT_ADAPT:
-				tmp = g_strdup (keyb_get_name ());
-				for (i=0; tmp[i]; i++)
-					tmp[i] = (tmp[i] == ' ') ? '_' : tmp[i];
-				fprintf (fh, "%s\t", tmp);
-				g_free (tmp);
-				break;
-			case TT_VELO:
-				tmp = g_strdup (velo_get_dict_name ());
-				for (i=0; tmp[i]; i++)
-					tmp[i] = (tmp[i] == ' ') ? '_' : tmp[i];
-				fprintf (fh, "%s\t", tmp);
-				g_free (tmp);
-				break;
-			case TT_FLUID:
-				tmp = g_strdup (fluid_get_paragraph_name ());
-				for (i=0; tmp[i]; i++)
-					tmp[i] = (tmp[i] == ' ') ? '_' : tmp[i];
-				fprintf (fh, "%s\t", tmp);
-				g_free (tmp);
-				break;
-			}
-
-			if (tutor.type == TT_BASIC)
-			{
-				tmp = g_strdup (keyb_get_name ());
-				for (i=0; tmp[i]; i++)
-					tmp[i] = (tmp[i] == ' ') ? '_' : tmp[i];
-				fprintf (fh, "%s\n", tmp );
-				g_free (tmp);
-			}
-			else
-				fprintf (fh, "%s\n", trans_get_current_language ());
-
-			fclose (fh);
+			session.key = stats_intern (trans_get_current_language ());
+			session.name = stats_intern (tmp);
 		}
-		else
-			g_message ("not able to log on this file:\n %s", tmp_name);
-		g_free (tmp_name);
+		g_free (tmp);
+		stats_append (&session);
 
 		if (tutor.type == TT_FLUID)
 		{
@@ -1159,16 +1434,19 @@ tutor_calc_stats ()
 			{
 				if (top10_compare_insert_stat (&stat, LOCAL))
 				{
-					contest_ps =
-						g_strdup (_
-							  ("ps.: you have entered the Top 10 list, great!"));
 					top10_write_stats (LOCAL, -1);
-					//if (main_preferences_get_boolean ("game", "autopublish") && UNIX_OK)
-					if (main_preferences_get_boolean ("game", "autopublish"))
+					if (top10_get_rank (&stat, LOCAL) < TOP10_SHOWN)
 					{
-						top10_show_stats (LOCAL);
-						top10_show_stats (GLOBAL);
-						top10_global_publish (NULL);
+						contest_ps =
+							g_strdup (_
+								  ("ps.: you have entered the Top 10 list, great!"));
+						//if (main_preferences_get_boolean ("game", "autopublish") && UNIX_OK)
+						if (main_preferences_get_boolean ("game", "autopublish"))
+						{
+							top10_show_stats (LOCAL);
+							top10_show_stats (GLOBAL);
+							top10_global_publish (NULL);
+						}
 					}
 				}
 			}
@@ -1179,29 +1457,14 @@ tutor_calc_stats ()
 
 			/* Anyway, log also the scoring
 			 */
-			tmp_name =
-				g_build_filename (main_path_stats (), "scores_fluid.txt", NULL);
-			assert_user_dir ();
-			if (!g_file_test (tmp_name, G_FILE_TEST_IS_REGULAR))
-			{
-				fh = (FILE *) g_fopen (tmp_name, "w");
-				fprintf (fh, "Score\tDate\tTime\tNumber of chars\tLanguage\n");
-			}
-			else
-				fh = (FILE *) g_fopen (tmp_name, "a");
-			if (fh)
-			{
-				ltime = localtime (&stat.when);
-				fprintf (fh,
-					 "%3.4f\t%i-%2.2i-%2.2i\t%2.2i:%2.2i\t%i\t%s\n",
-					 stat.score, (ltime->tm_year) + 1900, (ltime->tm_mon) + 1,
-					 (ltime->tm_mday), (ltime->tm_hour), (ltime->tm_min),
-					 stat.nchars, trans_get_current_language ());
-				fclose (fh);
-			}
-			else
-				g_message ("not able to log on this file:\n %s", tmp_name);
-			g_free (tmp_name);
+			memset (&session, 0, sizeof (StatsRecord));
+			session.module = STATS_SCORES;
+			session.when = stat.when;
+			session.score = stat.score;
+			session.nchars = stat.nchars;
+			session.key = stats_intern (trans_get_current_language ());
+			session.name = STATS_NONE;
+			stats_append (&session);
 		}
 
 		/*
@@ -1386,11 +1649,6 @@ tutor_char_distribution_approved ()
 		Char_Distribution dist;
 	} exam;
 
-	GtkWidget *wg;
-	GtkTextBuffer *buf;
-	GtkTextIter start;
-	GtkTextIter end;
-
 	/* Get model text
 	 */
 	tmp_code = main_preferences_get_string ("interface", "language");
@@ -1410,10 +1668,7 @@ tutor_char_distribution_approved ()
 
 	/* Get text under examination
 	 */
-	wg = get_wg ("text_tutor");
-	buf = gtk_text_view_get_buffer (GTK_TEXT_VIEW (wg));
-	gtk_text_buffer_get_bounds (buf, &start, &end);
-	exam.text = gtk_text_buffer_get_text (buf, &start, &end, FALSE);
+	exam.text = tutor_window_get_text ();
 
 	/* Get char distributions
 	 */
@@ -1538,40 +1793,23 @@ tutor_char_distribution_count (gchar * text, Char_Distribution * dist)
 }
 
 /**********************************************************************
- * Formats and draws one paragraph at the tutor window
+ * Formats one paragraph, appending it to the exercise 'text'
  */
 void
-tutor_draw_paragraph (gchar * utf8_text)
+tutor_format_paragraph (GString *text, const gchar * utf8_text)
 {
-	static gchar *tmp1 = NULL;
-	static gchar *tmp2 = NULL;
 	gchar *ptr;
-	GtkWidget *wg;
-	GtkTextBuffer *buf;
-
-	g_free (tmp1);
-	g_free (tmp2);
 
-	if (g_utf8_strrchr (utf8_text, -1, L'\n') == NULL)
+	ptr = g_utf8_strrchr (utf8_text, -1, L'\n');
+	if (ptr == NULL)
 	{
 		g_message ("paragraph not terminated by carriage return: adding one.");
-		tmp1 = g_strconcat (utf8_text, "\n", NULL);
+		ptr = (gchar *) utf8_text + strlen (utf8_text);
 	}
-	else
-		tmp1 = g_strdup (utf8_text);
-
-	ptr = g_utf8_strrchr (tmp1, -1, L'\n');
-	if (ptr)
-		*ptr = '\0';
-	else
-		g_error ("draw_paragraph () ==> string error");
-
-	wg = get_wg ("text_tutor");
-	buf = gtk_text_view_get_buffer (GTK_TEXT_VIEW (wg));
-
-	tmp2 = g_strconcat (tmp1, keyb_get_utf8_paragraph_symbol (), "\n", NULL);
 
-	gtk_text_buffer_insert_at_cursor (buf, tmp2, -1);
+	g_string_append_len (text, utf8_text, ptr - utf8_text);
+	g_string_append (text, keyb_get_utf8_paragraph_symbol ());
+	g_string_append_c (text, '\n');
 }
 
 /**********************************************************************
@@ -81,6 +81,10 @@ gdouble tutor_goal_fluidity (void);
 
 gdouble tutor_goal_level (guint n);
 
+void tutor_prefetch_start (void);
+
+void tutor_prefetch_discard (void);
+
 /*
  * Auxiliar functions
  */
@@ -92,6 +96,12 @@ void tutor_update_intro (void);
 
 void tutor_update_start (void);
 
+void tutor_window_set (GtkTextBuffer *buf, const gchar *text);
+
+void tutor_window_slide (void);
+
+gchar *tutor_window_get_text (void);
+
 void tutor_process_touch (gunichar user_chr);
 
 gboolean tutor_eval_forward (gunichar chr);
@@ -104,7 +114,7 @@ gboolean tutor_char_distribution_approved (void);
 
 void tutor_char_distribution_count (gchar * text, Char_Distribution * dist);
 
-void tutor_draw_paragraph (gchar * text);
+void tutor_format_paragraph (GString *text, const gchar * utf8_text);
 
 void tutor_load_list_other (gchar * file_name_end, GtkListStore * list);
 
@@ -50,6 +50,7 @@ velo_get_dict_name ()
 void
 velo_reset_dict ()
 {
+	tutor_prefetch_discard ();
 	g_list_free (dict.list);
 	dict.list = NULL;
 	dict.len = 0;
@@ -159,10 +160,12 @@ velo_init_dict (gchar * list_name)
 }
 
 /**********************************************************************
- * Draw random phrases with words selected from a 'discretionary'
+ * Append to 'text' random phrases with words selected from a 'discretionary'.
+ * The dictionary isn't changed here, so it may run off the main loop
+ * (velo_reset_dict cancels any pending preparation before freeing it).
  */
 void
-velo_draw_random_words ()
+velo_create_random_words (GString *text, const gchar *lang, Rnd *rnd)
 {
 	gint i, j;
 	gchar *word;
@@ -180,7 +183,7 @@ velo_draw_random_words ()
 		par.i = 0;
 		for (j = 0; j < 20; j++) /* 20 words per paragraph */
 		{		
-			word = g_strdup (g_list_nth_data (dict.list, rand () % dict.len));
+			word = g_strdup (g_list_nth_data (dict.list, rnd_int (rnd, dict.len)));
 			if (j == 0)
 				word[0] = g_ascii_toupper (word[0]);
 
@@ -196,11 +199,11 @@ velo_draw_random_words ()
 			g_free (word);
 		}
 		par.i--;
-		if (trans_lang_has_stopmark ())
+		if (trans_code_has_stopmark (lang))
 			par.text[par.i++] = '.';
 		par.text[par.i++] = '\n';
 		par.text[par.i++] = '\0';
-		tutor_draw_paragraph (par.text);
+		tutor_format_paragraph (text, par.text);
 	}
 	g_free (par.text);
 }
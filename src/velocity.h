@@ -26,7 +26,7 @@ void velo_init (void);
 
 void velo_init_dict (gchar *);
 
-void velo_draw_random_words (void);
+void velo_create_random_words (GString *text, const gchar *lang, Rnd *rnd);
 
 gchar *velo_filter_utf8 (gchar * text);
 